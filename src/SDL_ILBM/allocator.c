@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#include "allocator.h"
+#include <stdlib.h>
+#include <SDL.h>
+
+/* Objects in an arena are aligned to a boundary that is suitable for any type */
+#define ARENA_ALIGNMENT 16
+
+static SDL_ILBM_MallocFunction mallocFunction = malloc;
+static SDL_ILBM_CallocFunction callocFunction = calloc;
+static SDL_ILBM_ReallocFunction reallocFunction = realloc;
+static SDL_ILBM_FreeFunction freeFunction = free;
+
+static SDL_atomic_t arenaMode;
+
+void SDL_ILBM_setAllocator(SDL_ILBM_MallocFunction newMallocFunction, SDL_ILBM_CallocFunction newCallocFunction, SDL_ILBM_ReallocFunction newReallocFunction, SDL_ILBM_FreeFunction newFreeFunction)
+{
+    mallocFunction = newMallocFunction == NULL ? malloc : newMallocFunction;
+    callocFunction = newCallocFunction == NULL ? calloc : newCallocFunction;
+    reallocFunction = newReallocFunction == NULL ? realloc : newReallocFunction;
+    freeFunction = newFreeFunction == NULL ? free : newFreeFunction;
+}
+
+void *SDL_ILBM_malloc(size_t size)
+{
+    return mallocFunction(size);
+}
+
+void *SDL_ILBM_calloc(size_t nmemb, size_t size)
+{
+    return callocFunction(nmemb, size);
+}
+
+void *SDL_ILBM_realloc(void *ptr, size_t size)
+{
+    return reallocFunction(ptr, size);
+}
+
+void SDL_ILBM_free(void *ptr)
+{
+    freeFunction(ptr);
+}
+
+void SDL_ILBM_setArenaMode(const amiVideo_Bool enabled)
+{
+    SDL_AtomicSet(&arenaMode, enabled);
+}
+
+amiVideo_Bool SDL_ILBM_getArenaMode(void)
+{
+    return SDL_AtomicGet(&arenaMode);
+}
+
+size_t SDL_ILBM_computeArenaObjectSize(size_t size)
+{
+    return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+SDL_ILBM_Arena *SDL_ILBM_createArena(size_t size)
+{
+    size_t headerSize = SDL_ILBM_computeArenaObjectSize(sizeof(SDL_ILBM_Arena));
+    amiVideo_UByte *block = (amiVideo_UByte*)SDL_ILBM_malloc(headerSize + size);
+    SDL_ILBM_Arena *arena = (SDL_ILBM_Arena*)block;
+
+    if(arena != NULL)
+    {
+        arena->memory = block + headerSize;
+        arena->size = size;
+        arena->used = 0;
+    }
+
+    return arena;
+}
+
+void *SDL_ILBM_allocateFromArena(SDL_ILBM_Arena *arena, size_t size)
+{
+    size_t objectSize = SDL_ILBM_computeArenaObjectSize(size);
+    void *object;
+
+    if(objectSize > arena->size - arena->used)
+        return NULL;
+
+    object = arena->memory + arena->used;
+    arena->used += objectSize;
+
+    return object;
+}
+
+void SDL_ILBM_freeArena(SDL_ILBM_Arena *arena)
+{
+    SDL_ILBM_free(arena); /* The arena resides at the start of its block */
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#ifndef __SDL_ILBM_ALLOCATOR_H
+#define __SDL_ILBM_ALLOCATOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SDL_ILBM_Arena SDL_ILBM_Arena;
+
+#include <stddef.h>
+#include <libamivideo/amivideotypes.h>
+
+/** Function allocating a block of memory, having the same semantics as malloc() */
+typedef void *(*SDL_ILBM_MallocFunction) (size_t size);
+
+/** Function allocating a zeroed block of memory, having the same semantics as calloc() */
+typedef void *(*SDL_ILBM_CallocFunction) (size_t nmemb, size_t size);
+
+/** Function resizing a block of memory, having the same semantics as realloc() */
+typedef void *(*SDL_ILBM_ReallocFunction) (void *ptr, size_t size);
+
+/** Function freeing a block of memory, having the same semantics as free() */
+typedef void (*SDL_ILBM_FreeFunction) (void *ptr);
+
+/**
+ * @brief A contiguous block of memory from which objects are allocated one
+ * after another. The objects cannot be freed individually, but are all freed
+ * at once when the arena is freed.
+ */
+struct SDL_ILBM_Arena
+{
+    /** Start of the memory from which objects are allocated */
+    amiVideo_UByte *memory;
+
+    /** Size of the memory in bytes */
+    size_t size;
+
+    /** Amount of bytes that have been allocated so far */
+    size_t used;
+};
+
+/**
+ * Replaces the functions that this library uses to allocate and free its own
+ * objects and bookkeeping. This function must be invoked before any object is
+ * created, because an object must be freed with the same allocator that has
+ * allocated it. Pixels of SDL surfaces are allocated by SDL and pixel buffers
+ * that are handed over to libamivideo are allocated with the standard C
+ * library, so these are not affected.
+ *
+ * @param mallocFunction Function replacing malloc() or NULL to use malloc()
+ * @param callocFunction Function replacing calloc() or NULL to use calloc()
+ * @param reallocFunction Function replacing realloc() or NULL to use realloc()
+ * @param freeFunction Function replacing free() or NULL to use free()
+ */
+void SDL_ILBM_setAllocator(SDL_ILBM_MallocFunction mallocFunction, SDL_ILBM_CallocFunction callocFunction, SDL_ILBM_ReallocFunction reallocFunction, SDL_ILBM_FreeFunction freeFunction);
+
+/**
+ * Allocates a block of memory with the configured allocator.
+ *
+ * @param size Size of the block in bytes
+ * @return Pointer to the block or NULL in case of an error
+ */
+void *SDL_ILBM_malloc(size_t size);
+
+/**
+ * Allocates a zeroed block of memory with the configured allocator.
+ *
+ * @param nmemb Amount of elements
+ * @param size Size of an element in bytes
+ * @return Pointer to the block or NULL in case of an error
+ */
+void *SDL_ILBM_calloc(size_t nmemb, size_t size);
+
+/**
+ * Resizes a block of memory with the configured allocator.
+ *
+ * @param ptr Pointer to the block or NULL
+ * @param size New size of the block in bytes
+ * @return Pointer to the resized block or NULL in case of an error
+ */
+void *SDL_ILBM_realloc(void *ptr, size_t size);
+
+/**
+ * Frees a block of memory with the configured allocator.
+ *
+ * @param ptr Pointer to the block or NULL
+ */
+void SDL_ILBM_free(void *ptr);
+
+/**
+ * Enables or disables arena mode. In arena mode, SDL_ILBM_createImage()
+ * allocates the image, its range times, its copy of the palette and the
+ * displays created for it from one contiguous block, which is freed at once
+ * by SDL_ILBM_freeImage(). By default, arena mode is disabled.
+ *
+ * @param enabled TRUE to enable arena mode, FALSE to disable it
+ */
+void SDL_ILBM_setArenaMode(const amiVideo_Bool enabled);
+
+/**
+ * Checks whether arena mode is enabled.
+ *
+ * @return TRUE if arena mode is enabled, else FALSE
+ */
+amiVideo_Bool SDL_ILBM_getArenaMode(void);
+
+/**
+ * Creates an arena having a given size. The arena itself resides in the same
+ * block of memory as the objects allocated from it.
+ *
+ * @param size Amount of bytes that can be allocated from the arena
+ * @return An SDL_ILBM_Arena instance or NULL in case of an error. The result must be freed with SDL_ILBM_freeArena()
+ */
+SDL_ILBM_Arena *SDL_ILBM_createArena(size_t size);
+
+/**
+ * Allocates an object from an arena.
+ *
+ * @param arena An SDL_ILBM_Arena instance
+ * @param size Size of the object in bytes
+ * @return Pointer to the object, suitably aligned for any type, or NULL if the arena has no room left
+ */
+void *SDL_ILBM_allocateFromArena(SDL_ILBM_Arena *arena, size_t size);
+
+/**
+ * Computes how many bytes an arena needs to allocate an object of a given
+ * size, including the padding that keeps the next object aligned.
+ *
+ * @param size Size of the object in bytes
+ * @return The amount of bytes the object occupies in an arena
+ */
+size_t SDL_ILBM_computeArenaObjectSize(size_t size);
+
+/**
+ * Frees an arena and all objects that have been allocated from it.
+ *
+ * @param arena An SDL_ILBM_Arena instance or NULL
+ */
+void SDL_ILBM_freeArena(SDL_ILBM_Arena *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -29,9 +29,70 @@ int SDL_ILBM_setSurfacePaletteFromScreenPalette(amiVideo_Palette *palette, SDL_S
     return SDL_SetPaletteColors(surface->format->palette, (SDL_Color*)palette->chunkyFormat.color, 0, palette->chunkyFormat.numOfColors);
 }
 
-SDL_Surface *SDL_ILBM_createUncorrectedChunkySurfaceFromScreen(amiVideo_Screen *screen)
+int SDL_ILBM_setSurfacePaletteRangeFromScreenPalette(amiVideo_Palette *palette, SDL_Surface *surface, const unsigned int first, const unsigned int count)
+{
+    if(first >= palette->chunkyFormat.numOfColors)
+        return 0;
+    else if(first + count > palette->chunkyFormat.numOfColors)
+        return SDL_SetPaletteColors(surface->format->palette, (SDL_Color*)&palette->chunkyFormat.color[first], first, palette->chunkyFormat.numOfColors - first);
+    else
+        return SDL_SetPaletteColors(surface->format->palette, (SDL_Color*)&palette->chunkyFormat.color[first], first, count);
+}
+
+/*
+ * Attaches uncorrected chunky and, if requested, RGB buffers from the pool to
+ * the screen, instead of letting libamivideo allocate them. They are marked as
+ * allocated, so that amiVideo_cleanupScreen() frees them if they are not
+ * returned to the pool.
+ */
+static amiVideo_Bool attachPooledUncorrectedMemory(amiVideo_Screen *screen, SDL_ILBM_BufferPool *bufferPool, const amiVideo_Bool attachRGBMemory, const SDL_PixelFormat *format)
+{
+    amiVideo_UByte *chunkyPixels;
+
+    if(bufferPool == NULL || (chunkyPixels = (amiVideo_UByte*)SDL_ILBM_takeBuffer(bufferPool, screen->width * screen->height)) == NULL)
+        return FALSE;
+
+    if(attachRGBMemory)
+    {
+        amiVideo_ULong *rgbPixels = (amiVideo_ULong*)SDL_ILBM_takeBuffer(bufferPool, screen->width * screen->height * 4);
+
+        if(rgbPixels == NULL)
+        {
+            SDL_ILBM_returnBuffer(bufferPool, chunkyPixels, screen->width * screen->height);
+            return FALSE;
+        }
+
+        amiVideo_setScreenUncorrectedRGBPixelsPointer(screen, rgbPixels, screen->width * 4, FALSE, format->Rshift, format->Gshift, format->Bshift, format->Ashift);
+        screen->uncorrectedRGBFormat.memoryAllocated = TRUE;
+    }
+
+    amiVideo_setScreenUncorrectedChunkyPixelsPointer(screen, chunkyPixels, screen->width);
+    screen->uncorrectedChunkyFormat.memoryAllocated = TRUE;
+
+    return TRUE;
+}
+
+void SDL_ILBM_returnUncorrectedMemoryToPool(amiVideo_Screen *screen, SDL_ILBM_BufferPool *bufferPool)
 {
-    SDL_Surface *surface = SDL_CreateRGBSurface(0, screen->width, screen->height, 8, 0, 0, 0, 0);
+    /* Buffers allocated by libamivideo itself are adopted by the pool as well. Without a pool, they are freed */
+    if(screen->uncorrectedChunkyFormat.memoryAllocated)
+    {
+        SDL_ILBM_returnBuffer(bufferPool, screen->uncorrectedChunkyFormat.pixels, screen->uncorrectedChunkyFormat.pitch * screen->height);
+        screen->uncorrectedChunkyFormat.pixels = NULL;
+        screen->uncorrectedChunkyFormat.memoryAllocated = FALSE;
+    }
+
+    if(screen->uncorrectedRGBFormat.memoryAllocated)
+    {
+        SDL_ILBM_returnBuffer(bufferPool, screen->uncorrectedRGBFormat.pixels, screen->uncorrectedRGBFormat.pitch * screen->height);
+        screen->uncorrectedRGBFormat.pixels = NULL;
+        screen->uncorrectedRGBFormat.memoryAllocated = FALSE;
+    }
+}
+
+SDL_Surface *SDL_ILBM_createUncorrectedChunkySurfaceFromScreenWithPool(amiVideo_Screen *screen, SDL_ILBM_BufferPool *bufferPool)
+{
+    SDL_Surface *surface = SDL_ILBM_takeSurface(bufferPool, screen->width, screen->height, 8, 0, 0, 0, 0);
 
     if(surface != NULL)
     {
@@ -48,30 +109,77 @@ SDL_Surface *SDL_ILBM_createUncorrectedChunkySurfaceFromScreen(amiVideo_Screen *
     return surface;
 }
 
-SDL_Surface *SDL_ILBM_createUncorrectedRGBSurfaceFromScreen(amiVideo_Screen *screen, const ILBM_Image *image)
+SDL_Surface *SDL_ILBM_createUncorrectedChunkySurfaceFromScreen(amiVideo_Screen *screen)
+{
+    return SDL_ILBM_createUncorrectedChunkySurfaceFromScreenWithPool(screen, NULL);
+}
+
+SDL_Surface *SDL_ILBM_createUncorrectedChunkySurfaceFromBody(amiVideo_Screen *screen, const ILBM_Image *image)
 {
-    SDL_Surface *surface = SDL_CreateRGBSurface(0, screen->width, screen->height, 32, 0, 0, 0, 0);
+    unsigned int pitch = (image->bitMapHeader->w + 1) & ~1U; /* The rows of a PBM body are padded to an even amount of bytes */
+    SDL_Surface *surface;
+
+    if(image->body == NULL || image->body->chunkData == NULL || (IFF_Long)(pitch * image->bitMapHeader->h) > image->body->chunkSize)
+        return NULL; /* The body does not cover all pixels => it cannot be used as a surface */
+
+    surface = SDL_CreateRGBSurfaceFrom(image->body->chunkData, screen->width, screen->height, 8, pitch, 0, 0, 0, 0);
 
     if(surface != NULL)
     {
-        int allocateUncorrectedMemory = !ILBM_imageIsPBM(image);
+        /* The pixels of the surface are the chunky pixels of the body */
+        amiVideo_setScreenUncorrectedChunkyPixelsPointer(screen, surface->pixels, surface->pitch);
+
+        /* Convert the colors of the the bitplane palette to the format of the chunky palette */
+        amiVideo_convertBitplaneColorsToChunkyFormat(&screen->palette);
+
+        /* Set the palette of the target SDL surface */
+        SDL_ILBM_setSurfacePaletteFromScreenPalette(&screen->palette, surface);
+    }
+
+    return surface;
+}
+
+SDL_Surface *SDL_ILBM_createUncorrectedRGBSurfaceFromScreenWithPool(amiVideo_Screen *screen, const ILBM_Image *image, SDL_ILBM_BufferPool *bufferPool)
+{
+    SDL_Surface *surface;
+
+    if(ILBM_imageIsPBM(image) && screen->bitplaneDepth == 32)
+    {
+        /* The body of a 32-bit PBM consists of RGBA bytes => use the same channel order, so that the pixels can be copied as they are. The fourth channel is not displayed */
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+        surface = SDL_ILBM_takeSurface(bufferPool, screen->width, screen->height, 32, 0xff000000, 0x00ff0000, 0x0000ff00, 0);
+#else
+        surface = SDL_ILBM_takeSurface(bufferPool, screen->width, screen->height, 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0);
+#endif
+    }
+    else
+        surface = SDL_ILBM_takeSurface(bufferPool, screen->width, screen->height, 32, 0, 0, 0, 0);
+
+    if(surface != NULL)
+    {
+        int allocateUncorrectedMemory = !ILBM_imageIsPBM(image) && !attachPooledUncorrectedMemory(screen, bufferPool, FALSE, surface->format);
         amiVideo_setScreenUncorrectedRGBPixelsPointer(screen, surface->pixels, surface->pitch, allocateUncorrectedMemory, surface->format->Rshift, surface->format->Gshift, surface->format->Bshift, surface->format->Ashift); /* Set the uncorrected RGB pixels pointer of the conversion struct to that of the SDL pixel surface */
     }
 
     return surface;
 }
 
-SDL_Surface *SDL_ILBM_createCorrectedChunkySurfaceFromScreen(amiVideo_Screen *screen, const ILBM_Image *image, const unsigned int lowresPixelScaleFactor)
+SDL_Surface *SDL_ILBM_createUncorrectedRGBSurfaceFromScreen(amiVideo_Screen *screen, const ILBM_Image *image)
+{
+    return SDL_ILBM_createUncorrectedRGBSurfaceFromScreenWithPool(screen, image, NULL);
+}
+
+SDL_Surface *SDL_ILBM_createCorrectedChunkySurfaceFromScreenWithPool(amiVideo_Screen *screen, const ILBM_Image *image, const unsigned int lowresPixelScaleFactor, SDL_ILBM_BufferPool *bufferPool)
 {
     SDL_Surface *surface;
 
     amiVideo_setLowresPixelScaleFactor(screen, lowresPixelScaleFactor);
 
-    surface = SDL_CreateRGBSurface(0, screen->correctedFormat.width, screen->correctedFormat.height, 8, 0, 0, 0, 0);
+    surface = SDL_ILBM_takeSurface(bufferPool, screen->correctedFormat.width, screen->correctedFormat.height, 8, 0, 0, 0, 0);
 
     if(surface != NULL)
     {
-        int allocateUncorrectedMemory = !ILBM_imageIsPBM(image);
+        int allocateUncorrectedMemory = !ILBM_imageIsPBM(image) && !attachPooledUncorrectedMemory(screen, bufferPool, FALSE, surface->format);
 
         /* Set the corrected chunky pixels pointer of the conversion struct to the SDL pixel surface */
         amiVideo_setScreenCorrectedPixelsPointer(screen, surface->pixels, surface->pitch, 1, allocateUncorrectedMemory, 0, 0, 0, 0);
@@ -86,19 +194,29 @@ SDL_Surface *SDL_ILBM_createCorrectedChunkySurfaceFromScreen(amiVideo_Screen *sc
     return surface;
 }
 
-SDL_Surface *SDL_ILBM_createCorrectedRGBSurfaceFromScreen(amiVideo_Screen *screen, const ILBM_Image *image, const unsigned int lowresPixelScaleFactor)
+SDL_Surface *SDL_ILBM_createCorrectedChunkySurfaceFromScreen(amiVideo_Screen *screen, const ILBM_Image *image, const unsigned int lowresPixelScaleFactor)
+{
+    return SDL_ILBM_createCorrectedChunkySurfaceFromScreenWithPool(screen, image, lowresPixelScaleFactor, NULL);
+}
+
+SDL_Surface *SDL_ILBM_createCorrectedRGBSurfaceFromScreenWithPool(amiVideo_Screen *screen, const ILBM_Image *image, const unsigned int lowresPixelScaleFactor, SDL_ILBM_BufferPool *bufferPool)
 {
     SDL_Surface *surface;
 
     amiVideo_setLowresPixelScaleFactor(screen, lowresPixelScaleFactor);
 
-    surface = SDL_CreateRGBSurface(0, screen->correctedFormat.width, screen->correctedFormat.height, 32, 0, 0, 0, 0);
+    surface = SDL_ILBM_takeSurface(bufferPool, screen->correctedFormat.width, screen->correctedFormat.height, 32, 0, 0, 0, 0);
 
     if(surface != NULL)
     {
-        int allocateUncorrectedMemory = !ILBM_imageIsPBM(image);
+        int allocateUncorrectedMemory = !ILBM_imageIsPBM(image) && !attachPooledUncorrectedMemory(screen, bufferPool, TRUE, surface->format);
         amiVideo_setScreenCorrectedPixelsPointer(screen, surface->pixels, surface->pitch, 4, allocateUncorrectedMemory, surface->format->Rshift, surface->format->Gshift, surface->format->Bshift, surface->format->Ashift); /* Set the corrected RGB pixels pointer of the conversion struct to the SDL pixel surface */
     }
 
     return surface;
 }
+
+SDL_Surface *SDL_ILBM_createCorrectedRGBSurfaceFromScreen(amiVideo_Screen *screen, const ILBM_Image *image, const unsigned int lowresPixelScaleFactor)
+{
+    return SDL_ILBM_createCorrectedRGBSurfaceFromScreenWithPool(screen, image, lowresPixelScaleFactor, NULL);
+}
@@ -28,6 +28,7 @@
 #include <libilbm/ilbmimage.h>
 #include <libamivideo/palette.h>
 #include <libamivideo/screen.h>
+#include "bufferpool.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -35,14 +36,28 @@ extern "C" {
 
 int SDL_ILBM_setSurfacePaletteFromScreenPalette(amiVideo_Palette *palette, SDL_Surface *surface);
 
+int SDL_ILBM_setSurfacePaletteRangeFromScreenPalette(amiVideo_Palette *palette, SDL_Surface *surface, const unsigned int first, const unsigned int count);
+
+void SDL_ILBM_returnUncorrectedMemoryToPool(amiVideo_Screen *screen, SDL_ILBM_BufferPool *bufferPool);
+
 SDL_Surface *SDL_ILBM_createUncorrectedChunkySurfaceFromScreen(amiVideo_Screen *screen);
 
+SDL_Surface *SDL_ILBM_createUncorrectedChunkySurfaceFromScreenWithPool(amiVideo_Screen *screen, SDL_ILBM_BufferPool *bufferPool);
+
+SDL_Surface *SDL_ILBM_createUncorrectedChunkySurfaceFromBody(amiVideo_Screen *screen, const ILBM_Image *image);
+
 SDL_Surface *SDL_ILBM_createUncorrectedRGBSurfaceFromScreen(amiVideo_Screen *screen, const ILBM_Image *image);
 
+SDL_Surface *SDL_ILBM_createUncorrectedRGBSurfaceFromScreenWithPool(amiVideo_Screen *screen, const ILBM_Image *image, SDL_ILBM_BufferPool *bufferPool);
+
 SDL_Surface *SDL_ILBM_createCorrectedChunkySurfaceFromScreen(amiVideo_Screen *screen, const ILBM_Image *image, const unsigned int lowresPixelScaleFactor);
 
+SDL_Surface *SDL_ILBM_createCorrectedChunkySurfaceFromScreenWithPool(amiVideo_Screen *screen, const ILBM_Image *image, const unsigned int lowresPixelScaleFactor, SDL_ILBM_BufferPool *bufferPool);
+
 SDL_Surface *SDL_ILBM_createCorrectedRGBSurfaceFromScreen(amiVideo_Screen *screen, const ILBM_Image *image, const unsigned int lowresPixelScaleFactor);
 
+SDL_Surface *SDL_ILBM_createCorrectedRGBSurfaceFromScreenWithPool(amiVideo_Screen *screen, const ILBM_Image *image, const unsigned int lowresPixelScaleFactor, SDL_ILBM_BufferPool *bufferPool);
+
 #ifdef __cplusplus
 }
 #endif
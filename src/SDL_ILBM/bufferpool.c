@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#include "bufferpool.h"
+#include <stdlib.h>
+#include <string.h>
+#include "allocator.h"
+
+static void *currentBufferPool = NULL;
+
+SDL_ILBM_BufferPool *SDL_ILBM_createBufferPool(size_t maxSize)
+{
+    SDL_ILBM_BufferPool *bufferPool = (SDL_ILBM_BufferPool*)SDL_ILBM_malloc(sizeof(SDL_ILBM_BufferPool));
+
+    if(bufferPool != NULL)
+    {
+        bufferPool->buffers = NULL;
+        bufferPool->size = 0;
+        bufferPool->maxSize = maxSize;
+        bufferPool->mutex = SDL_CreateMutex();
+
+        if(bufferPool->mutex == NULL)
+        {
+            SDL_ILBM_free(bufferPool);
+            return NULL;
+        }
+    }
+
+    return bufferPool;
+}
+
+static void freePooledBuffers(SDL_ILBM_PooledBuffer *pooledBuffer)
+{
+    while(pooledBuffer != NULL)
+    {
+        SDL_ILBM_PooledBuffer *next = pooledBuffer->next;
+
+        SDL_FreeSurface(pooledBuffer->surface);
+        free(pooledBuffer->buffer);
+        SDL_ILBM_free(pooledBuffer);
+
+        pooledBuffer = next;
+    }
+}
+
+void SDL_ILBM_freeBufferPool(SDL_ILBM_BufferPool *bufferPool)
+{
+    if(bufferPool != NULL)
+    {
+        freePooledBuffers(bufferPool->buffers);
+        SDL_DestroyMutex(bufferPool->mutex);
+        SDL_ILBM_free(bufferPool);
+    }
+}
+
+/* Keeps the most recently returned entries that fit in the pool and frees the rest */
+
+static void trimBufferPool(SDL_ILBM_BufferPool *bufferPool)
+{
+    SDL_ILBM_PooledBuffer **link = &bufferPool->buffers;
+    size_t size = 0;
+
+    while(*link != NULL && size + (*link)->size <= bufferPool->maxSize)
+    {
+        size += (*link)->size;
+        link = &(*link)->next;
+    }
+
+    freePooledBuffers(*link);
+    *link = NULL;
+    bufferPool->size = size;
+}
+
+void SDL_ILBM_setBufferPoolMaxSize(SDL_ILBM_BufferPool *bufferPool, size_t maxSize)
+{
+    SDL_LockMutex(bufferPool->mutex);
+    bufferPool->maxSize = maxSize;
+    trimBufferPool(bufferPool);
+    SDL_UnlockMutex(bufferPool->mutex);
+}
+
+void SDL_ILBM_setBufferPool(SDL_ILBM_BufferPool *bufferPool)
+{
+    SDL_AtomicSetPtr(&currentBufferPool, bufferPool);
+}
+
+SDL_ILBM_BufferPool *SDL_ILBM_getBufferPool(void)
+{
+    return (SDL_ILBM_BufferPool*)SDL_AtomicGetPtr(&currentBufferPool);
+}
+
+/* Unlinks the most recently returned entry for which the predicate holds */
+
+static SDL_ILBM_PooledBuffer *takePooledBuffer(SDL_ILBM_BufferPool *bufferPool, amiVideo_Bool (*matches) (const SDL_ILBM_PooledBuffer *pooledBuffer, const void *key), const void *key)
+{
+    SDL_ILBM_PooledBuffer **link;
+    SDL_ILBM_PooledBuffer *pooledBuffer = NULL;
+
+    SDL_LockMutex(bufferPool->mutex);
+
+    for(link = &bufferPool->buffers; *link != NULL; link = &(*link)->next)
+    {
+        if(matches(*link, key))
+        {
+            pooledBuffer = *link;
+            *link = pooledBuffer->next;
+            bufferPool->size -= pooledBuffer->size;
+            break;
+        }
+    }
+
+    SDL_UnlockMutex(bufferPool->mutex);
+
+    return pooledBuffer;
+}
+
+static amiVideo_Bool returnPooledBuffer(SDL_ILBM_BufferPool *bufferPool, SDL_Surface *surface, void *buffer, size_t size)
+{
+    SDL_ILBM_PooledBuffer *pooledBuffer;
+
+    if(size > bufferPool->maxSize)
+        return FALSE; /* It would evict everything else and still not fit */
+
+    pooledBuffer = (SDL_ILBM_PooledBuffer*)SDL_ILBM_malloc(sizeof(SDL_ILBM_PooledBuffer));
+
+    if(pooledBuffer == NULL)
+        return FALSE;
+
+    pooledBuffer->surface = surface;
+    pooledBuffer->buffer = buffer;
+    pooledBuffer->size = size;
+
+    SDL_LockMutex(bufferPool->mutex);
+    pooledBuffer->next = bufferPool->buffers;
+    bufferPool->buffers = pooledBuffer;
+    bufferPool->size += size;
+    trimBufferPool(bufferPool);
+    SDL_UnlockMutex(bufferPool->mutex);
+
+    return TRUE;
+}
+
+typedef struct
+{
+    int width;
+    int height;
+    Uint32 format;
+}
+SurfaceKey;
+
+static amiVideo_Bool surfaceMatches(const SDL_ILBM_PooledBuffer *pooledBuffer, const void *key)
+{
+    const SurfaceKey *surfaceKey = (const SurfaceKey*)key;
+    const SDL_Surface *surface = pooledBuffer->surface;
+
+    return (surface != NULL && surface->w == surfaceKey->width && surface->h == surfaceKey->height && surface->format->format == surfaceKey->format);
+}
+
+/* Restores the pixels and all properties a caller may have changed, so that the surface is indistinguishable from a new one */
+
+static amiVideo_Bool resetSurface(SDL_Surface *surface)
+{
+    memset(surface->pixels, '\0', (size_t)surface->h * surface->pitch);
+    SDL_SetClipRect(surface, NULL);
+    SDL_SetColorKey(surface, SDL_FALSE, 0);
+    SDL_SetSurfaceAlphaMod(surface, SDL_ALPHA_OPAQUE);
+    SDL_SetSurfaceColorMod(surface, 255, 255, 255);
+    SDL_SetSurfaceBlendMode(surface, surface->format->Amask != 0 ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE);
+    SDL_SetSurfaceRLE(surface, SDL_FALSE);
+
+    /* The palette may have been modified or shared with other surfaces => give the surface a fresh one */
+    if(surface->format->palette != NULL)
+    {
+        SDL_Palette *palette = SDL_AllocPalette(1 << surface->format->BitsPerPixel);
+
+        if(palette == NULL)
+            return FALSE;
+
+        SDL_SetSurfacePalette(surface, palette);
+        SDL_FreePalette(palette); /* The surface holds a reference to it */
+    }
+
+    return TRUE;
+}
+
+SDL_Surface *SDL_ILBM_takeSurface(SDL_ILBM_BufferPool *bufferPool, int width, int height, int depth, Uint32 Rmask, Uint32 Gmask, Uint32 Bmask, Uint32 Amask)
+{
+    if(bufferPool != NULL)
+    {
+        SurfaceKey key;
+        SDL_ILBM_PooledBuffer *pooledBuffer;
+
+        key.width = width;
+        key.height = height;
+        key.format = SDL_MasksToPixelFormatEnum(depth, Rmask, Gmask, Bmask, Amask); /* Yields the same format as SDL_CreateRGBSurface() picks for these masks */
+
+        if((pooledBuffer = takePooledBuffer(bufferPool, surfaceMatches, &key)) != NULL)
+        {
+            SDL_Surface *surface = pooledBuffer->surface;
+            SDL_ILBM_free(pooledBuffer);
+
+            if(resetSurface(surface))
+                return surface;
+            else
+                SDL_FreeSurface(surface);
+        }
+    }
+
+    return SDL_CreateRGBSurface(0, width, height, depth, Rmask, Gmask, Bmask, Amask);
+}
+
+void SDL_ILBM_returnSurface(SDL_ILBM_BufferPool *bufferPool, SDL_Surface *surface)
+{
+    if(surface == NULL)
+        return;
+
+    /* Surfaces wrapping a body, or that are still in use, cannot be handed out again */
+    if(bufferPool == NULL || (surface->flags & SDL_PREALLOC) || surface->refcount > 1
+        || !returnPooledBuffer(bufferPool, surface, NULL, (size_t)surface->h * surface->pitch))
+        SDL_FreeSurface(surface);
+}
+
+static amiVideo_Bool bufferMatches(const SDL_ILBM_PooledBuffer *pooledBuffer, const void *key)
+{
+    return (pooledBuffer->buffer != NULL && pooledBuffer->size == *((const size_t*)key));
+}
+
+void *SDL_ILBM_takeBuffer(SDL_ILBM_BufferPool *bufferPool, size_t size)
+{
+    if(bufferPool != NULL)
+    {
+        SDL_ILBM_PooledBuffer *pooledBuffer = takePooledBuffer(bufferPool, bufferMatches, &size);
+
+        if(pooledBuffer != NULL)
+        {
+            void *buffer = pooledBuffer->buffer;
+            SDL_ILBM_free(pooledBuffer);
+
+            memset(buffer, '\0', size);
+            return buffer;
+        }
+    }
+
+    return calloc(size, 1); /* libamivideo frees the buffers of a screen with free() */
+}
+
+void SDL_ILBM_returnBuffer(SDL_ILBM_BufferPool *bufferPool, void *buffer, size_t size)
+{
+    if(buffer != NULL && (bufferPool == NULL || !returnPooledBuffer(bufferPool, NULL, buffer, size)))
+        free(buffer);
+}
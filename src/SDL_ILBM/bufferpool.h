@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#ifndef __SDL_ILBM_BUFFERPOOL_H
+#define __SDL_ILBM_BUFFERPOOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SDL_ILBM_PooledBuffer SDL_ILBM_PooledBuffer;
+typedef struct SDL_ILBM_BufferPool SDL_ILBM_BufferPool;
+
+#include <stddef.h>
+#include <SDL.h>
+
+/**
+ * @brief An idle surface or pixel buffer that can be reused
+ */
+struct SDL_ILBM_PooledBuffer
+{
+    /** An idle surface or NULL if the entry is a plain pixel buffer */
+    SDL_Surface *surface;
+
+    /** An idle pixel buffer allocated with malloc() or NULL if the entry is a surface */
+    void *buffer;
+
+    /** Size of the pixels of the surface or buffer in bytes */
+    size_t size;
+
+    /** Next idle surface or buffer. Entries are ordered from the most to the least recently returned */
+    SDL_ILBM_PooledBuffer *next;
+};
+
+/**
+ * @brief Retains the surfaces and pixel buffers of destroyed images, so that
+ * images having the same dimensions, depth and format can reuse them instead
+ * of allocating new ones.
+ */
+struct SDL_ILBM_BufferPool
+{
+    /** Linked list of idle surfaces and buffers */
+    SDL_ILBM_PooledBuffer *buffers;
+
+    /** Total size of the idle surfaces and buffers in bytes */
+    size_t size;
+
+    /** Maximum total size of the idle surfaces and buffers in bytes. The least recently returned entries are freed when it is exceeded */
+    size_t maxSize;
+
+    /** Serializes access from multiple threads, such as the worker threads of a loader */
+    SDL_mutex *mutex;
+};
+
+/**
+ * Creates a new buffer pool.
+ *
+ * @param maxSize Maximum total size of the idle surfaces and buffers in bytes
+ * @return An SDL_ILBM_BufferPool instance or NULL in case of an error. The result must be freed with SDL_ILBM_freeBufferPool()
+ */
+SDL_ILBM_BufferPool *SDL_ILBM_createBufferPool(size_t maxSize);
+
+/**
+ * Frees a buffer pool and all its idle surfaces and buffers. All images that
+ * have been initialized with the pool must be destroyed first.
+ *
+ * @param bufferPool An SDL_ILBM_BufferPool instance
+ */
+void SDL_ILBM_freeBufferPool(SDL_ILBM_BufferPool *bufferPool);
+
+/**
+ * Changes the maximum total size of the idle surfaces and buffers, freeing the
+ * least recently returned entries until the pool fits.
+ *
+ * @param bufferPool An SDL_ILBM_BufferPool instance
+ * @param maxSize Maximum total size of the idle surfaces and buffers in bytes
+ */
+void SDL_ILBM_setBufferPoolMaxSize(SDL_ILBM_BufferPool *bufferPool, size_t maxSize);
+
+/**
+ * Sets the buffer pool that SDL_ILBM_initImage() draws the surfaces and pixel
+ * buffers of subsequently initialized images from. Each image returns them to
+ * the pool it has been initialized with when it is destroyed. By default, no
+ * pool is used.
+ *
+ * @param bufferPool An SDL_ILBM_BufferPool instance or NULL to stop pooling
+ */
+void SDL_ILBM_setBufferPool(SDL_ILBM_BufferPool *bufferPool);
+
+/**
+ * Retrieves the buffer pool that is used by SDL_ILBM_initImage().
+ *
+ * @return An SDL_ILBM_BufferPool instance or NULL if no pool is used
+ */
+SDL_ILBM_BufferPool *SDL_ILBM_getBufferPool(void);
+
+/**
+ * Takes an idle surface having the given dimensions, depth and format from the
+ * pool or creates a new one if there is none. Its pixels are cleared, and its
+ * clip rectangle, color key, blend mode, alpha and color modulation, RLE
+ * acceleration and palette are reset to those of a new surface.
+ *
+ * @param bufferPool An SDL_ILBM_BufferPool instance or NULL to always create a new surface
+ * @param width Width of the surface
+ * @param height Height of the surface
+ * @param depth Bits per pixel of the surface
+ * @param Rmask Red mask of the pixels
+ * @param Gmask Green mask of the pixels
+ * @param Bmask Blue mask of the pixels
+ * @param Amask Alpha mask of the pixels
+ * @return An SDL surface or NULL in case of an error
+ */
+SDL_Surface *SDL_ILBM_takeSurface(SDL_ILBM_BufferPool *bufferPool, int width, int height, int depth, Uint32 Rmask, Uint32 Gmask, Uint32 Bmask, Uint32 Amask);
+
+/**
+ * Returns a surface to the pool, so that it can be reused. Surfaces that refer
+ * to pixels they do not own, that are still referenced elsewhere or that do
+ * not fit in the pool are freed.
+ *
+ * @param bufferPool An SDL_ILBM_BufferPool instance or NULL to free the surface
+ * @param surface An SDL surface or NULL
+ */
+void SDL_ILBM_returnSurface(SDL_ILBM_BufferPool *bufferPool, SDL_Surface *surface);
+
+/**
+ * Takes an idle pixel buffer of the given size from the pool or allocates a new
+ * one with malloc() if there is none. Its contents are cleared.
+ *
+ * @param bufferPool An SDL_ILBM_BufferPool instance or NULL to always allocate a new buffer
+ * @param size Size of the buffer in bytes
+ * @return A pixel buffer or NULL in case of an error
+ */
+void *SDL_ILBM_takeBuffer(SDL_ILBM_BufferPool *bufferPool, size_t size);
+
+/**
+ * Returns a pixel buffer that has been allocated with malloc() to the pool, so
+ * that it can be reused. Buffers that do not fit in the pool are freed.
+ *
+ * @param bufferPool An SDL_ILBM_BufferPool instance or NULL to free the buffer
+ * @param buffer A pixel buffer or NULL
+ * @param size Size of the buffer in bytes
+ */
+void SDL_ILBM_returnBuffer(SDL_ILBM_BufferPool *bufferPool, void *buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#include "c2p.h"
+#include <string.h>
+
+/*
+ * Converts rows of bitplanes to chunky pixels. Every depth has its own
+ * kernel, so that the loop over the bitplanes is unrolled by the compiler.
+ * Vectorized kernels are picked at runtime if the CPU supports them, and the
+ * scalar kernels are used for all other cases and for the remaining pixels of
+ * a row.
+ */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define C2P_SSE2
+#include <emmintrin.h>
+#endif
+
+#if SDL_VERSION_ATLEAST(2, 0, 4)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define C2P_AVX2
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define C2P_AVX2
+#define TARGET_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+#define PIXELS_PER_BYTE 8
+
+typedef void (*RowKernel) (const amiVideo_UByte **rows, const unsigned int width, amiVideo_UByte *pixels);
+
+/* Scalar kernels expand every bit of a byte into a separate byte, so that eight pixels of a bitplane are merged at once */
+
+static Uint64 bitExpansionTable[256];
+
+static void initBitExpansionTable(void)
+{
+    unsigned int i;
+
+    for(i = 0; i < 256; i++)
+    {
+        amiVideo_UByte bits[PIXELS_PER_BYTE];
+        unsigned int j;
+
+        for(j = 0; j < PIXELS_PER_BYTE; j++)
+            bits[j] = (i >> (PIXELS_PER_BYTE - 1 - j)) & 1; /* The most significant bit is the leftmost pixel */
+
+        memcpy(&bitExpansionTable[i], bits, PIXELS_PER_BYTE);
+    }
+}
+
+static SDL_INLINE void convertScalar(const amiVideo_UByte **rows, const unsigned int numOfBitplanes, const unsigned int first, const unsigned int width, amiVideo_UByte *pixels)
+{
+    unsigned int x;
+
+    for(x = first; x < width; x += PIXELS_PER_BYTE)
+    {
+        unsigned int i, column = x / PIXELS_PER_BYTE, length = width - x;
+        Uint64 chunky = 0;
+
+        /* Each bit of a plane ends up in the same bit position of eight adjacent chunky pixels */
+        for(i = 0; i < numOfBitplanes; i++)
+            chunky |= bitExpansionTable[rows[i][column]] << i;
+
+        if(length > PIXELS_PER_BYTE)
+            length = PIXELS_PER_BYTE;
+
+        memcpy(pixels + x, &chunky, length);
+    }
+}
+
+#define DEFINE_SCALAR_KERNEL(depth) \
+static void convertScalar##depth(const amiVideo_UByte **rows, const unsigned int width, amiVideo_UByte *pixels) \
+{ \
+    convertScalar(rows, depth, 0, width, pixels); \
+}
+
+DEFINE_SCALAR_KERNEL(1)
+DEFINE_SCALAR_KERNEL(2)
+DEFINE_SCALAR_KERNEL(3)
+DEFINE_SCALAR_KERNEL(4)
+DEFINE_SCALAR_KERNEL(5)
+DEFINE_SCALAR_KERNEL(6)
+DEFINE_SCALAR_KERNEL(7)
+DEFINE_SCALAR_KERNEL(8)
+
+static const RowKernel scalarKernels[] = { NULL, convertScalar1, convertScalar2, convertScalar3, convertScalar4, convertScalar5, convertScalar6, convertScalar7, convertScalar8 };
+
+/*
+ * Vector kernels broadcast the bytes of each bitplane so that every lane
+ * holds the byte of its pixel, isolate the bit of the pixel with a mask, and
+ * turn it into the bit of the plane in the chunky pixel.
+ */
+
+#ifdef C2P_SSE2
+#define SSE2_PIXELS 16
+
+static SDL_INLINE void convertSSE2(const amiVideo_UByte **rows, const unsigned int numOfBitplanes, const unsigned int width, amiVideo_UByte *pixels)
+{
+    const __m128i pixelMask = _mm_set_epi8(1, 2, 4, 8, 16, 32, 64, (char)128, 1, 2, 4, 8, 16, 32, 64, (char)128);
+    unsigned int x;
+
+    for(x = 0; x + SSE2_PIXELS <= width; x += SSE2_PIXELS)
+    {
+        unsigned int i, column = x / PIXELS_PER_BYTE;
+        __m128i chunky = _mm_setzero_si128();
+
+        for(i = 0; i < numOfBitplanes; i++)
+        {
+            __m128i bytes = _mm_cvtsi32_si128(rows[i][column] | (rows[i][column + 1] << 8));
+            __m128i bits;
+
+            /* Spread the two bytes over the lanes of their eight pixels */
+            bytes = _mm_unpacklo_epi8(bytes, bytes);
+            bytes = _mm_unpacklo_epi16(bytes, bytes);
+            bytes = _mm_unpacklo_epi32(bytes, bytes);
+
+            bits = _mm_cmpeq_epi8(_mm_and_si128(bytes, pixelMask), pixelMask);
+            chunky = _mm_or_si128(chunky, _mm_and_si128(bits, _mm_set1_epi8((char)(1 << i))));
+        }
+
+        _mm_storeu_si128((__m128i*)(pixels + x), chunky);
+    }
+
+    convertScalar(rows, numOfBitplanes, x, width, pixels);
+}
+
+#define DEFINE_SSE2_KERNEL(depth) \
+static void convertSSE2_##depth(const amiVideo_UByte **rows, const unsigned int width, amiVideo_UByte *pixels) \
+{ \
+    convertSSE2(rows, depth, width, pixels); \
+}
+
+DEFINE_SSE2_KERNEL(1)
+DEFINE_SSE2_KERNEL(2)
+DEFINE_SSE2_KERNEL(3)
+DEFINE_SSE2_KERNEL(4)
+DEFINE_SSE2_KERNEL(5)
+DEFINE_SSE2_KERNEL(6)
+DEFINE_SSE2_KERNEL(7)
+DEFINE_SSE2_KERNEL(8)
+
+static const RowKernel sse2Kernels[] = { NULL, convertSSE2_1, convertSSE2_2, convertSSE2_3, convertSSE2_4, convertSSE2_5, convertSSE2_6, convertSSE2_7, convertSSE2_8 };
+#endif
+
+#ifdef C2P_AVX2
+#define AVX2_PIXELS 32
+
+static SDL_INLINE TARGET_AVX2 void convertAVX2(const amiVideo_UByte **rows, const unsigned int numOfBitplanes, const unsigned int width, amiVideo_UByte *pixels)
+{
+    const __m256i pixelMask = _mm256_set_epi8(1, 2, 4, 8, 16, 32, 64, (char)128, 1, 2, 4, 8, 16, 32, 64, (char)128, 1, 2, 4, 8, 16, 32, 64, (char)128, 1, 2, 4, 8, 16, 32, 64, (char)128);
+    const __m256i spread = _mm256_set_epi8(3, 3, 3, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0);
+    unsigned int x;
+
+    for(x = 0; x + AVX2_PIXELS <= width; x += AVX2_PIXELS)
+    {
+        unsigned int i, column = x / PIXELS_PER_BYTE;
+        __m256i chunky = _mm256_setzero_si256();
+
+        for(i = 0; i < numOfBitplanes; i++)
+        {
+            Sint32 value;
+            __m256i bytes, bits;
+
+            memcpy(&value, rows[i] + column, sizeof(Sint32));
+
+            /* Spread the four bytes over the lanes of their eight pixels. Every 128-bit lane holds all four bytes, so the shuffle can pick any of them */
+            bytes = _mm256_shuffle_epi8(_mm256_set1_epi32(value), spread);
+
+            bits = _mm256_cmpeq_epi8(_mm256_and_si256(bytes, pixelMask), pixelMask);
+            chunky = _mm256_or_si256(chunky, _mm256_and_si256(bits, _mm256_set1_epi8((char)(1 << i))));
+        }
+
+        _mm256_storeu_si256((__m256i*)(pixels + x), chunky);
+    }
+
+    convertScalar(rows, numOfBitplanes, x, width, pixels);
+}
+
+#define DEFINE_AVX2_KERNEL(depth) \
+static TARGET_AVX2 void convertAVX2_##depth(const amiVideo_UByte **rows, const unsigned int width, amiVideo_UByte *pixels) \
+{ \
+    convertAVX2(rows, depth, width, pixels); \
+}
+
+DEFINE_AVX2_KERNEL(1)
+DEFINE_AVX2_KERNEL(2)
+DEFINE_AVX2_KERNEL(3)
+DEFINE_AVX2_KERNEL(4)
+DEFINE_AVX2_KERNEL(5)
+DEFINE_AVX2_KERNEL(6)
+DEFINE_AVX2_KERNEL(7)
+DEFINE_AVX2_KERNEL(8)
+
+static const RowKernel avx2Kernels[] = { NULL, convertAVX2_1, convertAVX2_2, convertAVX2_3, convertAVX2_4, convertAVX2_5, convertAVX2_6, convertAVX2_7, convertAVX2_8 };
+#endif
+
+/* Images may be converted by several loader threads at once => the kernels are selected only once, by the first thread that needs them */
+
+static const RowKernel *kernels = NULL;
+static SDL_atomic_t kernelsSelected;
+static SDL_SpinLock kernelsLock = 0;
+
+static const RowKernel *selectKernels(void)
+{
+    if(!SDL_AtomicGet(&kernelsSelected))
+    {
+        SDL_AtomicLock(&kernelsLock);
+
+        if(!SDL_AtomicGet(&kernelsSelected))
+        {
+            initBitExpansionTable(); /* All kernels use the scalar kernel for the remaining pixels */
+
+#ifdef C2P_AVX2
+            if(SDL_HasAVX2())
+                kernels = avx2Kernels;
+            else
+#endif
+#ifdef C2P_SSE2
+            if(SDL_HasSSE2())
+                kernels = sse2Kernels;
+            else
+#endif
+                kernels = scalarKernels;
+
+            SDL_AtomicSet(&kernelsSelected, TRUE); /* Publishes the table and the kernels to the other threads */
+        }
+
+        SDL_AtomicUnlock(&kernelsLock);
+    }
+
+    return kernels;
+}
+
+void SDL_ILBM_convertPlanarRowToChunky(const amiVideo_UByte **rows, const unsigned int numOfBitplanes, const unsigned int width, amiVideo_UByte *pixels)
+{
+    if(numOfBitplanes == 0)
+        memset(pixels, '\0', width);
+    else
+        selectKernels()[numOfBitplanes](rows, width, pixels);
+}
+
+void SDL_ILBM_mapChunkyPalette(const amiVideo_Palette *palette, const SDL_PixelFormat *format, Uint32 *colors)
+{
+    unsigned int i;
+
+    memset(colors, '\0', SDL_ILBM_MAX_NUM_OF_C2P_COLORS * sizeof(Uint32));
+
+    for(i = 0; i < palette->chunkyFormat.numOfColors && i < SDL_ILBM_MAX_NUM_OF_C2P_COLORS; i++)
+    {
+        const amiVideo_OutputColor *color = &palette->chunkyFormat.color[i];
+        colors[i] = SDL_MapRGB(format, color->r, color->g, color->b);
+    }
+}
+
+void SDL_ILBM_convertChunkyRowToRGB(const amiVideo_UByte *chunkyPixels, const Uint32 *colors, const unsigned int width, Uint32 *pixels)
+{
+    unsigned int x;
+
+    for(x = 0; x < width; x++)
+        pixels[x] = colors[chunkyPixels[x]];
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#ifndef __SDL_ILBM_C2P_H
+#define __SDL_ILBM_C2P_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <SDL.h>
+#include <libamivideo/palette.h>
+
+#define SDL_ILBM_MAX_NUM_OF_C2P_BITPLANES 8
+#define SDL_ILBM_MAX_NUM_OF_C2P_COLORS 256
+
+void SDL_ILBM_convertPlanarRowToChunky(const amiVideo_UByte **rows, const unsigned int numOfBitplanes, const unsigned int width, amiVideo_UByte *pixels);
+
+void SDL_ILBM_mapChunkyPalette(const amiVideo_Palette *palette, const SDL_PixelFormat *format, Uint32 *colors);
+
+void SDL_ILBM_convertChunkyRowToRGB(const amiVideo_UByte *chunkyPixels, const Uint32 *colors, const unsigned int width, Uint32 *pixels);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
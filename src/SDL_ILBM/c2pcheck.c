@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+/*
+ * Checks that all c2p kernels of this library produce exactly the same chunky
+ * pixels as libamivideo, for every supported depth and for widths that are and
+ * are not multiples of the amount of pixels the vector kernels convert at once.
+ * The kernels are static, so the implementation is included directly.
+ */
+
+#include "c2p.c"
+#include <stdio.h>
+#include <stdlib.h>
+#include <libamivideo/screen.h>
+
+#define HEIGHT 3
+
+static const unsigned int widths[] = { 1, 7, 8, 9, 15, 16, 17, 24, 31, 32, 33, 40, 47, 48, 63, 64, 65, 100, 319, 320, 321 };
+
+#define NUM_OF_WIDTHS (sizeof(widths) / sizeof(unsigned int))
+
+static Uint32 seed = 1;
+
+static amiVideo_UByte generateByte(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return (amiVideo_UByte)(seed >> 16);
+}
+
+static int checkKernel(const char *name, const RowKernel kernel, const amiVideo_Screen *screen, amiVideo_UByte *pixels)
+{
+    const amiVideo_UByte *rows[SDL_ILBM_MAX_NUM_OF_C2P_BITPLANES];
+    int i, y;
+
+    for(y = 0; y < screen->height; y++)
+    {
+        const amiVideo_UByte *expected = screen->uncorrectedChunkyFormat.pixels + y * screen->uncorrectedChunkyFormat.pitch;
+
+        for(i = 0; i < screen->bitplaneDepth; i++)
+            rows[i] = screen->bitplaneFormat.bitplanes[i] + y * screen->bitplaneFormat.pitch;
+
+        kernel(rows, screen->width, pixels);
+
+        if(memcmp(pixels, expected, screen->width) != 0)
+        {
+            fprintf(stderr, "The %s kernel converts row %d of a %d pixels wide screen with %d bitplanes incorrectly\n", name, y, screen->width, screen->bitplaneDepth);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static int checkScreen(const unsigned int width, const unsigned int numOfBitplanes)
+{
+    amiVideo_Screen screen;
+    amiVideo_UByte *bitplanes, *chunkyPixels, *pixels;
+    size_t i, bitplanesSize;
+    int status = TRUE;
+
+    amiVideo_initScreen(&screen, width, HEIGHT, numOfBitplanes, 8, 0);
+
+    bitplanesSize = screen.bitplaneFormat.pitch * HEIGHT * numOfBitplanes;
+    bitplanes = (amiVideo_UByte*)malloc(bitplanesSize);
+    chunkyPixels = (amiVideo_UByte*)malloc(width * HEIGHT);
+    pixels = (amiVideo_UByte*)malloc(width);
+
+    if(bitplanes == NULL || chunkyPixels == NULL || pixels == NULL)
+    {
+        fprintf(stderr, "Cannot allocate memory for the screen\n");
+        status = FALSE;
+    }
+    else
+    {
+        for(i = 0; i < bitplanesSize; i++)
+            bitplanes[i] = generateByte();
+
+        /* Let libamivideo compute the reference pixels */
+        amiVideo_setScreenBitplanes(&screen, bitplanes);
+        amiVideo_setScreenUncorrectedChunkyPixelsPointer(&screen, chunkyPixels, width);
+        amiVideo_convertScreenBitplanesToChunkyPixels(&screen);
+
+        status = checkKernel("scalar", scalarKernels[numOfBitplanes], &screen, pixels);
+#ifdef C2P_SSE2
+        if(SDL_HasSSE2())
+            status = checkKernel("SSE2", sse2Kernels[numOfBitplanes], &screen, pixels) && status;
+#endif
+#ifdef C2P_AVX2
+        if(SDL_HasAVX2())
+            status = checkKernel("AVX2", avx2Kernels[numOfBitplanes], &screen, pixels) && status;
+#endif
+        status = checkKernel("selected", selectKernels()[numOfBitplanes], &screen, pixels) && status;
+    }
+
+    amiVideo_cleanupScreen(&screen);
+    free(pixels);
+    free(chunkyPixels);
+    free(bitplanes);
+
+    return status;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int i, numOfBitplanes;
+    int status = TRUE;
+
+    selectKernels(); /* Initializes the bit expansion table that the scalar kernels use */
+
+    for(numOfBitplanes = 1; numOfBitplanes <= SDL_ILBM_MAX_NUM_OF_C2P_BITPLANES; numOfBitplanes++)
+    {
+        for(i = 0; i < NUM_OF_WIDTHS; i++)
+            status = checkScreen(widths[i], numOfBitplanes) && status;
+    }
+
+    if(status)
+        return 0;
+    else
+        return 1;
+}
@@ -0,0 +1,699 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#include "catalog.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#define CATALOG_MAGIC "SDLILBMC"
+#define CATALOG_MAGIC_SIZE 8
+#define CATALOG_VERSION 1
+#define MAX_NUM_OF_IMAGES 65536
+#define MAX_NUM_OF_ENTRIES 1048576
+
+static char *duplicateString(const char *string)
+{
+    size_t size = strlen(string) + 1;
+    char *copy = (char*)SDL_ILBM_malloc(size);
+
+    if(copy != NULL)
+        memcpy(copy, string, size);
+
+    return copy;
+}
+
+static char *composePath(const char *directory, const char *name)
+{
+    size_t directoryLength = strlen(directory);
+    size_t nameLength = strlen(name);
+    char *path = (char*)SDL_ILBM_malloc(directoryLength + nameLength + 2);
+
+    if(path != NULL)
+    {
+        memcpy(path, directory, directoryLength);
+        path[directoryLength] = '/';
+        memcpy(path + directoryLength + 1, name, nameLength + 1);
+    }
+
+    return path;
+}
+
+SDL_ILBM_Catalog *SDL_ILBM_createCatalog(const char *directory, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format)
+{
+    SDL_ILBM_Catalog *catalog = (SDL_ILBM_Catalog*)SDL_ILBM_malloc(sizeof(SDL_ILBM_Catalog));
+
+    if(catalog != NULL)
+    {
+        if((catalog->directory = duplicateString(directory)) == NULL)
+        {
+            SDL_ILBM_free(catalog);
+            return NULL;
+        }
+
+        catalog->lowresPixelScaleFactor = lowresPixelScaleFactor;
+        catalog->format = format;
+        catalog->entries = NULL;
+        catalog->entriesLength = 0;
+    }
+
+    return catalog;
+}
+
+static void freeEntries(SDL_ILBM_CatalogEntry *entries, const unsigned int entriesLength)
+{
+    unsigned int i;
+
+    for(i = 0; i < entriesLength; i++)
+    {
+        SDL_ILBM_free(entries[i].name);
+        SDL_ILBM_free(entries[i].images);
+    }
+
+    SDL_ILBM_free(entries);
+}
+
+void SDL_ILBM_freeCatalog(SDL_ILBM_Catalog *catalog)
+{
+    if(catalog != NULL)
+    {
+        freeEntries(catalog->entries, catalog->entriesLength);
+        SDL_ILBM_free(catalog->directory);
+        SDL_ILBM_free(catalog);
+    }
+}
+
+/* Reading and writing the fields of an index file, which are stored in big endian order */
+
+static amiVideo_Bool writeUByte(FILE *file, const Uint8 value)
+{
+    return (fputc(value, file) != EOF);
+}
+
+static amiVideo_Bool writeULong(FILE *file, const Uint32 value)
+{
+    Uint8 data[4];
+
+    data[0] = (Uint8)(value >> 24);
+    data[1] = (Uint8)(value >> 16);
+    data[2] = (Uint8)(value >> 8);
+    data[3] = (Uint8)value;
+
+    return (fwrite(data, 1, 4, file) == 4);
+}
+
+static amiVideo_Bool writeQuad(FILE *file, const Uint64 value)
+{
+    return writeULong(file, (Uint32)(value >> 32)) && writeULong(file, (Uint32)value);
+}
+
+static amiVideo_Bool writeString(FILE *file, const char *string)
+{
+    size_t length = strlen(string);
+    return writeULong(file, (Uint32)length) && (fwrite(string, 1, length, file) == length);
+}
+
+static amiVideo_Bool readUByte(FILE *file, Uint8 *value)
+{
+    int c = fgetc(file);
+
+    if(c == EOF)
+        return FALSE;
+
+    *value = (Uint8)c;
+    return TRUE;
+}
+
+static amiVideo_Bool readULong(FILE *file, Uint32 *value)
+{
+    Uint8 data[4];
+
+    if(fread(data, 1, 4, file) < 4)
+        return FALSE;
+
+    *value = ((Uint32)data[0] << 24) | ((Uint32)data[1] << 16) | ((Uint32)data[2] << 8) | data[3];
+    return TRUE;
+}
+
+static amiVideo_Bool readQuad(FILE *file, Uint64 *value)
+{
+    Uint32 high, low;
+
+    if(!readULong(file, &high) || !readULong(file, &low))
+        return FALSE;
+
+    *value = ((Uint64)high << 32) | low;
+    return TRUE;
+}
+
+static char *readString(FILE *file)
+{
+    Uint32 length;
+    char *string;
+
+    if(!readULong(file, &length) || length > FILENAME_MAX)
+        return NULL;
+
+    if((string = (char*)SDL_ILBM_malloc(length + 1)) != NULL)
+    {
+        if(fread(string, 1, length, file) == length)
+        {
+            string[length] = '\0';
+            return string;
+        }
+
+        SDL_ILBM_free(string);
+    }
+
+    return NULL;
+}
+
+static amiVideo_Bool writeImageInfo(FILE *file, const SDL_ILBM_ImageInfo *info)
+{
+    return (fwrite(info->formType, 1, 4, file) == 4)
+        && writeQuad(file, (Uint64)info->formOffset)
+        && writeULong(file, (Uint32)info->formSize)
+        && writeQuad(file, (Uint64)info->bodyOffset)
+        && writeULong(file, (Uint32)info->bodySize)
+        && writeUByte(file, (Uint8)info->selfContained)
+        && writeULong(file, info->width)
+        && writeULong(file, info->height)
+        && writeULong(file, info->nPlanes)
+        && writeULong(file, (Uint32)info->pageWidth)
+        && writeULong(file, (Uint32)info->pageHeight)
+        && writeUByte(file, info->masking)
+        && writeUByte(file, info->compression)
+        && writeULong(file, (Uint32)info->viewportMode)
+        && writeULong(file, info->numOfColors)
+        && writeULong(file, info->numOfRanges)
+        && writeUByte(file, (Uint8)info->hasActiveRanges)
+        && writeULong(file, (Uint32)info->surfaceWidth)
+        && writeULong(file, (Uint32)info->surfaceHeight)
+        && writeULong(file, (Uint32)info->surfaceFormat)
+        && writeQuad(file, info->surfaceSize)
+        && writeQuad(file, info->unpackedBodySize)
+        && writeQuad(file, info->decodedSize);
+}
+
+static amiVideo_Bool readImageInfo(FILE *file, SDL_ILBM_ImageInfo *info)
+{
+    Uint8 selfContained, masking, compression, hasActiveRanges;
+    Uint32 formSize, bodySize, width, height, nPlanes, pageWidth, pageHeight, viewportMode, numOfColors, numOfRanges, surfaceWidth, surfaceHeight, surfaceFormat;
+    Uint64 formOffset, bodyOffset, surfaceSize, unpackedBodySize, decodedSize;
+
+    if(fread(info->formType, 1, 4, file) < 4
+        || !readQuad(file, &formOffset)
+        || !readULong(file, &formSize)
+        || !readQuad(file, &bodyOffset)
+        || !readULong(file, &bodySize)
+        || !readUByte(file, &selfContained)
+        || !readULong(file, &width)
+        || !readULong(file, &height)
+        || !readULong(file, &nPlanes)
+        || !readULong(file, &pageWidth)
+        || !readULong(file, &pageHeight)
+        || !readUByte(file, &masking)
+        || !readUByte(file, &compression)
+        || !readULong(file, &viewportMode)
+        || !readULong(file, &numOfColors)
+        || !readULong(file, &numOfRanges)
+        || !readUByte(file, &hasActiveRanges)
+        || !readULong(file, &surfaceWidth)
+        || !readULong(file, &surfaceHeight)
+        || !readULong(file, &surfaceFormat)
+        || !readQuad(file, &surfaceSize)
+        || !readQuad(file, &unpackedBodySize)
+        || !readQuad(file, &decodedSize))
+        return FALSE;
+
+    info->formOffset = (long)formOffset;
+    info->formSize = (IFF_Long)formSize;
+    info->bodyOffset = (long)(Sint64)bodyOffset;
+    info->bodySize = (IFF_Long)bodySize;
+    info->selfContained = selfContained;
+    info->width = width;
+    info->height = height;
+    info->nPlanes = nPlanes;
+    info->pageWidth = (Sint32)pageWidth;
+    info->pageHeight = (Sint32)pageHeight;
+    info->masking = masking;
+    info->compression = compression;
+    info->viewportMode = viewportMode;
+    info->numOfColors = numOfColors;
+    info->numOfRanges = numOfRanges;
+    info->hasActiveRanges = hasActiveRanges;
+    info->surfaceWidth = (Sint32)surfaceWidth;
+    info->surfaceHeight = (Sint32)surfaceHeight;
+    info->surfaceFormat = (SDL_ILBM_Format)surfaceFormat;
+    info->surfaceSize = (size_t)surfaceSize;
+    info->unpackedBodySize = (size_t)unpackedBodySize;
+    info->decodedSize = (size_t)decodedSize;
+
+    return TRUE;
+}
+
+static amiVideo_Bool readEntry(FILE *file, SDL_ILBM_CatalogEntry *entry)
+{
+    Uint64 modificationTime, size;
+    Uint32 imagesLength;
+    unsigned int i;
+
+    entry->images = NULL;
+    entry->imagesLength = 0;
+
+    if((entry->name = readString(file)) == NULL)
+        return FALSE;
+
+    if(!readQuad(file, &modificationTime) || !readQuad(file, &size) || !readULong(file, &imagesLength) || imagesLength > MAX_NUM_OF_IMAGES)
+        return FALSE;
+
+    entry->modificationTime = (Sint64)modificationTime;
+    entry->size = (Sint64)size;
+
+    if(imagesLength > 0 && (entry->images = (SDL_ILBM_ImageInfo*)SDL_ILBM_malloc(imagesLength * sizeof(SDL_ILBM_ImageInfo))) == NULL)
+        return FALSE;
+
+    for(i = 0; i < imagesLength; i++)
+    {
+        if(!readImageInfo(file, &entry->images[i]))
+            return FALSE;
+
+        entry->imagesLength++;
+    }
+
+    return TRUE;
+}
+
+static int compareEntries(const void *left, const void *right)
+{
+    return strcmp(((const SDL_ILBM_CatalogEntry*)left)->name, ((const SDL_ILBM_CatalogEntry*)right)->name);
+}
+
+static amiVideo_Bool readEntries(FILE *file, SDL_ILBM_Catalog *catalog, const Uint32 entriesLength)
+{
+    unsigned int entriesCapacity = 0;
+    Uint32 i;
+
+    if(entriesLength > MAX_NUM_OF_ENTRIES)
+        return FALSE;
+
+    for(i = 0; i < entriesLength; i++)
+    {
+        amiVideo_Bool status;
+
+        /* Grow the array while reading, so that a corrupt count does not allocate more than the file contains */
+        if(catalog->entriesLength == entriesCapacity)
+        {
+            unsigned int capacity = entriesCapacity == 0 ? 64 : entriesCapacity * 2;
+            SDL_ILBM_CatalogEntry *result = (SDL_ILBM_CatalogEntry*)SDL_ILBM_realloc(catalog->entries, capacity * sizeof(SDL_ILBM_CatalogEntry));
+
+            if(result == NULL)
+                return FALSE;
+
+            catalog->entries = result;
+            entriesCapacity = capacity;
+        }
+
+        status = readEntry(file, &catalog->entries[i]);
+        catalog->entriesLength++; /* Make sure that partially read entries are freed as well */
+
+        if(!status)
+            return FALSE;
+
+        /* Entries are looked up with a binary search => their names must be unique and in order */
+        if(i > 0 && compareEntries(&catalog->entries[i - 1], &catalog->entries[i]) >= 0)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+SDL_ILBM_Catalog *SDL_ILBM_loadCatalog(const char *filename)
+{
+    FILE *file = fopen(filename, "rb");
+    SDL_ILBM_Catalog *catalog = NULL;
+    char magic[CATALOG_MAGIC_SIZE];
+    Uint32 version, lowresPixelScaleFactor, format, entriesLength;
+    char *directory;
+
+    if(file == NULL)
+        return NULL;
+
+    if(fread(magic, 1, CATALOG_MAGIC_SIZE, file) == CATALOG_MAGIC_SIZE && memcmp(magic, CATALOG_MAGIC, CATALOG_MAGIC_SIZE) == 0
+        && readULong(file, &version) && version == CATALOG_VERSION
+        && (directory = readString(file)) != NULL)
+    {
+        if(readULong(file, &lowresPixelScaleFactor) && readULong(file, &format) && readULong(file, &entriesLength)
+            && (catalog = SDL_ILBM_createCatalog(directory, lowresPixelScaleFactor, (SDL_ILBM_Format)format)) != NULL)
+        {
+            if(!readEntries(file, catalog, entriesLength))
+            {
+                SDL_ILBM_freeCatalog(catalog);
+                catalog = NULL;
+            }
+        }
+
+        SDL_ILBM_free(directory);
+    }
+
+    fclose(file);
+    return catalog;
+}
+
+amiVideo_Bool SDL_ILBM_saveCatalog(const SDL_ILBM_Catalog *catalog, const char *filename)
+{
+    FILE *file = fopen(filename, "wb");
+    amiVideo_Bool status;
+    unsigned int i, j;
+
+    if(file == NULL)
+        return FALSE;
+
+    status = (fwrite(CATALOG_MAGIC, 1, CATALOG_MAGIC_SIZE, file) == CATALOG_MAGIC_SIZE)
+        && writeULong(file, CATALOG_VERSION)
+        && writeString(file, catalog->directory)
+        && writeULong(file, catalog->lowresPixelScaleFactor)
+        && writeULong(file, (Uint32)catalog->format)
+        && writeULong(file, catalog->entriesLength);
+
+    for(i = 0; i < catalog->entriesLength && status; i++)
+    {
+        const SDL_ILBM_CatalogEntry *entry = &catalog->entries[i];
+
+        status = writeString(file, entry->name)
+            && writeQuad(file, (Uint64)entry->modificationTime)
+            && writeQuad(file, (Uint64)entry->size)
+            && writeULong(file, entry->imagesLength);
+
+        for(j = 0; j < entry->imagesLength && status; j++)
+            status = writeImageInfo(file, &entry->images[j]);
+    }
+
+    if(fclose(file) != 0)
+        status = FALSE;
+
+    return status;
+}
+
+/* Listing the regular files in the directory. Of each file only the name, modification time and size are known */
+
+static amiVideo_Bool addFile(SDL_ILBM_CatalogEntry **entries, unsigned int *entriesLength, unsigned int *entriesCapacity, const char *directory, const char *name)
+{
+    char *path = composePath(directory, name);
+    struct stat fileStatus;
+    SDL_ILBM_CatalogEntry *entry;
+    int status;
+
+    if(path == NULL)
+        return FALSE;
+
+    status = stat(path, &fileStatus);
+    SDL_ILBM_free(path);
+
+    if(status != 0 || (fileStatus.st_mode & S_IFMT) != S_IFREG)
+        return TRUE; /* Skip directories and files that have disappeared in the meantime */
+
+    if(*entriesLength == *entriesCapacity)
+    {
+        unsigned int capacity = *entriesCapacity == 0 ? 64 : *entriesCapacity * 2;
+        SDL_ILBM_CatalogEntry *result = (SDL_ILBM_CatalogEntry*)SDL_ILBM_realloc(*entries, capacity * sizeof(SDL_ILBM_CatalogEntry));
+
+        if(result == NULL)
+            return FALSE;
+
+        *entries = result;
+        *entriesCapacity = capacity;
+    }
+
+    entry = &(*entries)[*entriesLength];
+
+    if((entry->name = duplicateString(name)) == NULL)
+        return FALSE;
+
+    entry->modificationTime = (Sint64)fileStatus.st_mtime;
+    entry->size = (Sint64)fileStatus.st_size;
+    entry->images = NULL;
+    entry->imagesLength = 0;
+    (*entriesLength)++;
+
+    return TRUE;
+}
+
+static amiVideo_Bool listDirectory(const char *directory, SDL_ILBM_CatalogEntry **entries, unsigned int *entriesLength)
+{
+    unsigned int entriesCapacity = 0;
+    amiVideo_Bool status = TRUE;
+#ifdef _WIN32
+    WIN32_FIND_DATAA findData;
+    HANDLE handle;
+    char *pattern = composePath(directory, "*");
+
+    if(pattern == NULL)
+        return FALSE;
+
+    handle = FindFirstFileA(pattern, &findData);
+    SDL_ILBM_free(pattern);
+
+    if(handle == INVALID_HANDLE_VALUE)
+        return FALSE;
+
+    do
+        status = addFile(entries, entriesLength, &entriesCapacity, directory, findData.cFileName);
+    while(status && FindNextFileA(handle, &findData));
+
+    FindClose(handle);
+#else
+    DIR *dir = opendir(directory);
+    struct dirent *dirEntry;
+
+    if(dir == NULL)
+        return FALSE;
+
+    while(status && (dirEntry = readdir(dir)) != NULL)
+        status = addFile(entries, entriesLength, &entriesCapacity, directory, dirEntry->d_name);
+
+    closedir(dir);
+#endif
+    return status;
+}
+
+static int compareNameToEntry(const void *name, const void *entry)
+{
+    return strcmp((const char*)name, ((const SDL_ILBM_CatalogEntry*)entry)->name);
+}
+
+SDL_ILBM_CatalogEntry *SDL_ILBM_lookupCatalogEntry(const SDL_ILBM_Catalog *catalog, const char *name)
+{
+    if(catalog->entriesLength == 0)
+        return NULL;
+    else
+        return (SDL_ILBM_CatalogEntry*)bsearch(name, catalog->entries, catalog->entriesLength, sizeof(SDL_ILBM_CatalogEntry), compareNameToEntry);
+}
+
+/* Probing the files that are new or have changed, distributed over several threads */
+
+typedef struct
+{
+    const SDL_ILBM_Catalog *catalog;
+    SDL_ILBM_CatalogEntry *entries;
+    const unsigned int *pending;
+    unsigned int pendingLength;
+    SDL_atomic_t next;
+}
+ProbeJob;
+
+static void probeEntry(const SDL_ILBM_Catalog *catalog, SDL_ILBM_CatalogEntry *entry)
+{
+    char *path = composePath(catalog->directory, entry->name);
+
+    if(path != NULL)
+    {
+        SDL_ILBM_Probe *probe = SDL_ILBM_probeFilename(path, catalog->lowresPixelScaleFactor, catalog->format);
+
+        /* Files that cannot be probed, such as files that are not IFF files, are recorded without images */
+        if(probe != NULL)
+        {
+            entry->images = probe->images; /* Take over the metadata of the images */
+            entry->imagesLength = probe->imagesLength;
+            probe->images = NULL;
+            SDL_ILBM_freeProbe(probe);
+        }
+
+        SDL_ILBM_free(path);
+    }
+}
+
+static int probeEntries(void *data)
+{
+    ProbeJob *job = (ProbeJob*)data;
+    int i;
+
+    while((i = SDL_AtomicAdd(&job->next, 1)) < (int)job->pendingLength)
+        probeEntry(job->catalog, &job->entries[job->pending[i]]);
+
+    return 0;
+}
+
+static void probeEntriesInParallel(const SDL_ILBM_Catalog *catalog, SDL_ILBM_CatalogEntry *entries, const unsigned int *pending, const unsigned int pendingLength, unsigned int numOfThreads)
+{
+    ProbeJob job;
+    SDL_Thread **threads = NULL;
+    unsigned int i, numOfStartedThreads = 0;
+
+    if(numOfThreads == 0)
+        numOfThreads = SDL_GetCPUCount();
+
+    if(numOfThreads > pendingLength)
+        numOfThreads = pendingLength;
+
+    job.catalog = catalog;
+    job.entries = entries;
+    job.pending = pending;
+    job.pendingLength = pendingLength;
+    SDL_AtomicSet(&job.next, 0);
+
+    /* The calling thread probes files as well, so one thread less needs to be started */
+    if(numOfThreads > 1 && (threads = (SDL_Thread**)SDL_ILBM_malloc((numOfThreads - 1) * sizeof(SDL_Thread*))) != NULL)
+    {
+        for(i = 0; i < numOfThreads - 1; i++)
+        {
+            SDL_Thread *thread = SDL_CreateThread(probeEntries, "SDL_ILBM catalog", &job);
+
+            if(thread == NULL)
+                break; /* The threads that have been started take care of the remaining files */
+
+            threads[numOfStartedThreads++] = thread;
+        }
+    }
+
+    probeEntries(&job);
+
+    for(i = 0; i < numOfStartedThreads; i++)
+        SDL_WaitThread(threads[i], NULL);
+
+    SDL_ILBM_free(threads);
+}
+
+int SDL_ILBM_updateCatalog(SDL_ILBM_Catalog *catalog, unsigned int numOfThreads)
+{
+    SDL_ILBM_CatalogEntry *entries = NULL;
+    unsigned int entriesLength = 0, pendingLength = 0, numOfMatches = 0, i;
+    unsigned int *pending;
+
+    if(!listDirectory(catalog->directory, &entries, &entriesLength))
+    {
+        freeEntries(entries, entriesLength);
+        return -1;
+    }
+
+    if(entriesLength > 0)
+        qsort(entries, entriesLength, sizeof(SDL_ILBM_CatalogEntry), compareEntries);
+
+    if((pending = (unsigned int*)SDL_ILBM_malloc((entriesLength + 1) * sizeof(unsigned int))) == NULL)
+    {
+        freeEntries(entries, entriesLength);
+        return -1;
+    }
+
+    /* Keep the metadata of files that have not changed, and probe the others */
+    for(i = 0; i < entriesLength; i++)
+    {
+        SDL_ILBM_CatalogEntry *entry = &entries[i];
+        SDL_ILBM_CatalogEntry *previousEntry = SDL_ILBM_lookupCatalogEntry(catalog, entry->name);
+
+        if(previousEntry != NULL)
+            numOfMatches++;
+
+        if(previousEntry != NULL && previousEntry->modificationTime == entry->modificationTime && previousEntry->size == entry->size)
+        {
+            entry->images = previousEntry->images;
+            entry->imagesLength = previousEntry->imagesLength;
+            previousEntry->images = NULL;
+            previousEntry->imagesLength = 0;
+        }
+        else
+            pending[pendingLength++] = i;
+    }
+
+    if(pendingLength > 0)
+        probeEntriesInParallel(catalog, entries, pending, pendingLength, numOfThreads);
+
+    SDL_ILBM_free(pending);
+
+    /* Entries of files that have not been found anymore are removed */
+    i = catalog->entriesLength - numOfMatches;
+
+    freeEntries(catalog->entries, catalog->entriesLength);
+    catalog->entries = entries;
+    catalog->entriesLength = entriesLength;
+
+    return pendingLength + i;
+}
+
+SDL_ILBM_Set *SDL_ILBM_createSetFromCatalog(const SDL_ILBM_Catalog *catalog, const unsigned int entryIndex, const unsigned int imageIndex, unsigned int *index)
+{
+    const SDL_ILBM_CatalogEntry *entry;
+    const SDL_ILBM_ImageInfo *info;
+    SDL_ILBM_Set *set = NULL;
+    char *path;
+
+    if(entryIndex >= catalog->entriesLength || imageIndex >= catalog->entries[entryIndex].imagesLength)
+        return NULL;
+
+    entry = &catalog->entries[entryIndex];
+    info = &entry->images[imageIndex];
+
+    if((path = composePath(catalog->directory, entry->name)) == NULL)
+        return NULL;
+
+    if(info->selfContained)
+    {
+        /* Only parse the form of the image, by seeking to it directly */
+        FILE *file = fopen(path, "rb");
+
+        if(file != NULL)
+        {
+            if(fseek(file, info->formOffset, SEEK_SET) == 0)
+                set = SDL_ILBM_createSetFromFd(file);
+
+            fclose(file);
+        }
+
+        *index = 0;
+    }
+    else
+    {
+        set = SDL_ILBM_createSetFromFilename(path); /* The image needs the PROP chunks of its enclosing list */
+        *index = imageIndex;
+    }
+
+    SDL_ILBM_free(path);
+    return set;
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#ifndef __SDL_ILBM_CATALOG_H
+#define __SDL_ILBM_CATALOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <SDL.h>
+#include "set.h"
+#include "image.h"
+#include "probe.h"
+
+/**
+ * @brief Metadata of a file in a catalogued directory
+ */
+typedef struct
+{
+    /** Name of the file in the directory */
+    char *name;
+
+    /** Modification time of the file at the moment it has been probed */
+    Sint64 modificationTime;
+
+    /** Size of the file in bytes at the moment it has been probed */
+    Sint64 size;
+
+    /** An array of metadata of the images in the file. It is empty if the file is not an IFF file containing images */
+    SDL_ILBM_ImageInfo *images;
+
+    /** Specifies the length of the images array */
+    unsigned int imagesLength;
+}
+SDL_ILBM_CatalogEntry;
+
+/**
+ * @brief Metadata of the images in all files of a directory, which can be
+ * saved to and loaded from an index file
+ */
+typedef struct
+{
+    /** Path to the catalogued directory */
+    char *directory;
+
+    /** The width of a lowres pixel for which the surface metrics of the images are computed */
+    unsigned int lowresPixelScaleFactor;
+
+    /** The format for which the surface metrics of the images are computed */
+    SDL_ILBM_Format format;
+
+    /** An array of entries of the files in the directory, sorted by name */
+    SDL_ILBM_CatalogEntry *entries;
+
+    /** Specifies the length of the entries array */
+    unsigned int entriesLength;
+}
+SDL_ILBM_Catalog;
+
+/**
+ * Creates an empty catalog of a directory. SDL_ILBM_updateCatalog() fills it
+ * with the files in the directory.
+ *
+ * @param directory Path to the directory to catalog
+ * @param lowresPixelScaleFactor Specifies the width of a lowres pixel for which the surface metrics are computed or 0 to pick it automatically
+ * @param format Defines the format for which the surface metrics are computed
+ * @return An SDL_ILBM_Catalog instance or NULL in case of an error. The result must be freed with SDL_ILBM_freeCatalog()
+ */
+SDL_ILBM_Catalog *SDL_ILBM_createCatalog(const char *directory, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format);
+
+/**
+ * Loads a catalog from an index file that has been written by
+ * SDL_ILBM_saveCatalog(). No file in the catalogued directory is read.
+ *
+ * @param filename Path to the index file
+ * @return An SDL_ILBM_Catalog instance or NULL if the index cannot be read or is invalid. The result must be freed with SDL_ILBM_freeCatalog()
+ */
+SDL_ILBM_Catalog *SDL_ILBM_loadCatalog(const char *filename);
+
+/**
+ * Brings a catalog up to date with its directory. Only files that are new or
+ * of which the modification time or size has changed are probed, in parallel
+ * on a given amount of threads. Entries of files that no longer exist are
+ * removed.
+ *
+ * @param catalog An SDL_ILBM_Catalog instance
+ * @param numOfThreads Amount of threads probing the files or 0 to use as many threads as there are CPU cores
+ * @return The amount of entries that have been added, changed or removed, or -1 if the directory cannot be read
+ */
+int SDL_ILBM_updateCatalog(SDL_ILBM_Catalog *catalog, unsigned int numOfThreads);
+
+/**
+ * Saves a catalog to an index file.
+ *
+ * @param catalog An SDL_ILBM_Catalog instance
+ * @param filename Path to the index file
+ * @return TRUE if the index has been written, else FALSE
+ */
+amiVideo_Bool SDL_ILBM_saveCatalog(const SDL_ILBM_Catalog *catalog, const char *filename);
+
+/**
+ * Looks up the entry of a file in a catalog.
+ *
+ * @param catalog An SDL_ILBM_Catalog instance
+ * @param name Name of the file in the directory
+ * @return The entry of the file or NULL if the catalog has no entry for it
+ */
+SDL_ILBM_CatalogEntry *SDL_ILBM_lookupCatalogEntry(const SDL_ILBM_Catalog *catalog, const char *name);
+
+/**
+ * Creates a set containing an image of a catalogued file. If the image does
+ * not depend on the properties of its enclosing list, only its form is read by
+ * seeking to it directly. Otherwise, the entire file is read. The catalog
+ * must be up to date, because the recorded offsets are used as they are.
+ *
+ * @param catalog An SDL_ILBM_Catalog instance
+ * @param entryIndex Index of the entry of the file in the catalog
+ * @param imageIndex Index of the image in the file
+ * @param index Variable receiving the index of the image in the resulting set
+ * @return An SDL_ILBM_Set instance or NULL in case of an error. The resulting set must be freed with SDL_ILBM_freeSet()
+ */
+SDL_ILBM_Set *SDL_ILBM_createSetFromCatalog(const SDL_ILBM_Catalog *catalog, const unsigned int entryIndex, const unsigned int imageIndex, unsigned int *index);
+
+/**
+ * Frees a catalog from memory.
+ *
+ * @param catalog An SDL_ILBM_Catalog instance
+ */
+void SDL_ILBM_freeCatalog(SDL_ILBM_Catalog *catalog);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -23,158 +23,965 @@
  */
 
 #include "cycle.h"
+#include "rangestate.h"
 #include <stdlib.h>
+#include <string.h>
 
 #define _60_STEPS 60.0
 #define MILLIS_PER_SECOND 1000
 #define MICROS_PER_MILLIS 1000
 
-static void shiftColorRange(amiVideo_Palette *palette, const ILBM_ColorRange *colorRange, int shiftRight)
+/* Range offsets are stored as the amount of positions the range has been rotated to the left */
+
+static unsigned int computeOffset(const Uint32 steps, const unsigned int length, const int shiftRight)
 {
-    unsigned int i;
-    amiVideo_Color *color = palette->bitplaneFormat.color;
+    unsigned int offset = steps % length;
 
     if(shiftRight)
-    {
-        amiVideo_Color temp = color[colorRange->low];
+        return offset;
+    else
+        return (length - offset) % length;
+}
+
+static void markDirty(SDL_ILBM_RangeTimes *rangeTimes, const unsigned int low, const unsigned int high)
+{
+    if(low < rangeTimes->dirtyLow)
+        rangeTimes->dirtyLow = low;
+
+    if(high > rangeTimes->dirtyHigh || rangeTimes->dirtyHigh == (unsigned int)-1)
+        rangeTimes->dirtyHigh = high;
+}
+
+static amiVideo_Bool isDirty(const SDL_ILBM_RangeTimes *rangeTimes)
+{
+    return (rangeTimes->dirtyHigh != (unsigned int)-1);
+}
+
+static void clearDirty(SDL_ILBM_RangeTimes *rangeTimes)
+{
+    rangeTimes->dirtyLow = (unsigned int)-1;
+    rangeTimes->dirtyHigh = (unsigned int)-1;
+}
+
+static amiVideo_Bool rangeFits(const unsigned int low, const unsigned int high, const unsigned int numOfColors)
+{
+    return (low < high && high < numOfColors);
+}
+
+static amiVideo_Bool rangeIsValid(const SDL_ILBM_RangeTimes *rangeTimes, const unsigned int low, const unsigned int high)
+{
+    return rangeFits(low, high, rangeTimes->baseColorsLength);
+}
 
-        for(i = colorRange->low; i < colorRange->high; i++)
-            color[i] = color[i + 1];
+static amiVideo_Bool drangeFits(const ILBM_DRange *drange, const unsigned int numOfColors)
+{
+    unsigned int i;
 
-        color[colorRange->high] = temp;
+    if(drange->min >= drange->max)
+        return FALSE;
+
+    for(i = drange->min; i <= drange->max; i++)
+    {
+        if(drange->dindex[i].index >= numOfColors)
+            return FALSE;
     }
-    else
+
+    return TRUE;
+}
+
+static void setContiguousRangeOffset(SDL_ILBM_RangeTimes *rangeTimes, unsigned int *offset, const unsigned int low, const unsigned int high, const Uint32 steps, const int shiftRight)
+{
+    if(rangeIsValid(rangeTimes, low, high))
     {
-        amiVideo_Color temp = color[colorRange->high];
+        unsigned int newOffset = computeOffset(steps, high - low + 1, shiftRight);
+
+        if(newOffset != *offset)
+        {
+            *offset = newOffset;
+            markDirty(rangeTimes, low, high);
+        }
+    }
+}
 
-        for(i = colorRange->high; i > colorRange->low; i--)
-            color[i] = color[i - 1];
+static void setDRangeOffset(SDL_ILBM_RangeTimes *rangeTimes, unsigned int *offset, const ILBM_DRange *drange, const Uint32 steps)
+{
+    if(drange->min < drange->max)
+    {
+        unsigned int newOffset = computeOffset(steps, drange->max - drange->min + 1, TRUE);
 
-        color[colorRange->low] = temp;
+        if(newOffset != *offset)
+        {
+            *offset = newOffset;
+            markDirty(rangeTimes, 0, rangeTimes->baseColorsLength - 1); /* The registers of a DRange are scattered over the palette */
+        }
     }
 }
 
-static void shiftDRange(amiVideo_Palette *palette, const ILBM_DRange *drange)
+/* Materializes a contiguous range by copying the rotated base colors in two blocks */
+
+static void materializeContiguousRange(const SDL_ILBM_RangeTimes *rangeTimes, amiVideo_Color *color, const unsigned int low, const unsigned int high, const unsigned int offset)
+{
+    unsigned int length = high - low + 1;
+
+    memcpy(&color[low], &rangeTimes->baseColors[low + offset], (length - offset) * sizeof(amiVideo_Color));
+    memcpy(&color[low + length - offset], &rangeTimes->baseColors[low], offset * sizeof(amiVideo_Color));
+}
+
+static void materializeDRange(const SDL_ILBM_RangeTimes *rangeTimes, amiVideo_Color *color, const ILBM_DRange *drange, const unsigned int offset)
 {
     unsigned int i;
-    amiVideo_Color *color = palette->bitplaneFormat.color;
-    amiVideo_Color temp = color[drange->dindex[drange->min].index];
+    unsigned int length = drange->max - drange->min + 1;
+
+    for(i = 0; i < length; i++)
+        color[drange->dindex[drange->min + i].index] = rangeTimes->baseColors[drange->dindex[drange->min + (i + offset) % length].index];
+}
 
-    for(i = drange->min; i < drange->max; i++)
-        color[drange->dindex[i].index] = color[drange->dindex[i + 1].index];
+/* Ranges that share colors are rotated in place by the steps they have advanced, one step at a time, like the palette used to be shifted */
+
+static void rotateContiguousRange(amiVideo_Color *color, const unsigned int low, const unsigned int high, const unsigned int steps)
+{
+    unsigned int length = high - low + 1;
+    unsigned int i;
 
-    color[drange->dindex[drange->max].index] = temp;
+    if(steps <= length / 2)
+    {
+        for(i = 0; i < steps; i++)
+        {
+            amiVideo_Color temp = color[low];
+            memmove(&color[low], &color[low + 1], (length - 1) * sizeof(amiVideo_Color));
+            color[high] = temp;
+        }
+    }
+    else
+    {
+        for(i = steps; i < length; i++)
+        {
+            amiVideo_Color temp = color[high];
+            memmove(&color[low + 1], &color[low], (length - 1) * sizeof(amiVideo_Color));
+            color[low] = temp;
+        }
+    }
 }
 
-static void shiftCycleInfo(amiVideo_Palette *palette, const ILBM_CycleInfo *cycleInfo)
+static void rotateDRange(amiVideo_Color *color, const ILBM_DRange *drange, const unsigned int steps)
 {
-    amiVideo_Color *color = palette->bitplaneFormat.color;
+    unsigned int length = drange->max - drange->min + 1;
+    unsigned int i, j;
 
-    if(cycleInfo->direction == ILBM_CYCLEINFO_SHIFT_LEFT)
+    if(steps <= length / 2)
     {
-        /* Shift left */
-        unsigned int i;
-        amiVideo_Color temp = color[cycleInfo->end];
+        for(i = 0; i < steps; i++)
+        {
+            amiVideo_Color temp = color[drange->dindex[drange->min].index];
 
-        for(i = cycleInfo->end; i > cycleInfo->start; i--)
-            color[i] = color[i - 1];
+            for(j = drange->min; j < drange->max; j++)
+                color[drange->dindex[j].index] = color[drange->dindex[j + 1].index];
 
-        color[cycleInfo->start] = temp;
+            color[drange->dindex[drange->max].index] = temp;
+        }
     }
-    else if(cycleInfo->direction == ILBM_CYCLEINFO_SHIFT_RIGHT)
+    else
     {
-        /* Shift right */
-        unsigned int i;
-        amiVideo_Color temp = color[cycleInfo->start];
+        for(i = steps; i < length; i++)
+        {
+            amiVideo_Color temp = color[drange->dindex[drange->max].index];
 
-        for(i = cycleInfo->start; i < cycleInfo->end; i++)
-            color[i] = color[i + 1];
+            for(j = drange->max; j > drange->min; j--)
+                color[drange->dindex[j].index] = color[drange->dindex[j - 1].index];
 
-        color[cycleInfo->end] = temp;
+            color[drange->dindex[drange->min].index] = temp;
+        }
     }
 }
 
-static Uint32 computeColorRangeTime(const Uint32 ticks, const ILBM_ColorRange *colorRange)
+static unsigned int takeSteps(unsigned int *appliedOffset, const unsigned int offset, const unsigned int length)
 {
-    return (Uint32)(MILLIS_PER_SECOND / (_60_STEPS * colorRange->rate / ILBM_COLORRANGE_60_STEPS_PER_SECOND) + ticks);
+    unsigned int steps = (offset + length - *appliedOffset) % length;
+    *appliedOffset = offset;
+    return steps;
 }
 
-static Uint32 computeDRangeTime(const Uint32 ticks, const ILBM_DRange *drange)
+static amiVideo_Bool intersectsDirtySpan(const SDL_ILBM_RangeTimes *rangeTimes, const unsigned int low, const unsigned int high)
 {
-    return (Uint32)(MILLIS_PER_SECOND / (_60_STEPS * drange->rate / ILBM_DRANGE_60_STEPS_PER_SECOND) + ticks);
+    return (low <= rangeTimes->dirtyHigh && high >= rangeTimes->dirtyLow);
 }
 
-static Uint32 computeCycleInfoTime(const Uint32 ticks, const ILBM_CycleInfo *cycleInfo)
+/* The intervals are fractions of milliseconds per step, so that steps can be computed exactly. A numerator of 0 means that the range never advances */
+
+typedef struct
 {
-    return (Uint32)(MILLIS_PER_SECOND * cycleInfo->seconds + cycleInfo->microSeconds / MICROS_PER_MILLIS + ticks);
+    Uint64 numerator;
+    Uint64 denominator;
 }
+Interval;
 
-void SDL_ILBM_initRangeTimes(SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image)
+static Interval computeColorRangeInterval(const ILBM_ColorRange *colorRange)
 {
-    unsigned int i;
-    Uint32 ticks;
+    Interval interval;
+
+    if(colorRange->rate > 0)
+    {
+        interval.numerator = (Uint64)MILLIS_PER_SECOND * ILBM_COLORRANGE_60_STEPS_PER_SECOND;
+        interval.denominator = (Uint64)_60_STEPS * colorRange->rate;
+    }
+    else
+    {
+        interval.numerator = 0;
+        interval.denominator = 1;
+    }
+
+    return interval;
+}
+
+static Interval computeDRangeInterval(const ILBM_DRange *drange)
+{
+    Interval interval;
+
+    if(drange->rate > 0)
+    {
+        interval.numerator = (Uint64)MILLIS_PER_SECOND * ILBM_DRANGE_60_STEPS_PER_SECOND;
+        interval.denominator = (Uint64)_60_STEPS * drange->rate;
+    }
+    else
+    {
+        interval.numerator = 0;
+        interval.denominator = 1;
+    }
+
+    return interval;
+}
+
+static Interval computeCycleInfoInterval(const ILBM_CycleInfo *cycleInfo)
+{
+    Interval interval;
+
+    if(cycleInfo->seconds >= 0 && cycleInfo->microSeconds >= 0)
+        interval.numerator = (Uint64)MILLIS_PER_SECOND * cycleInfo->seconds + cycleInfo->microSeconds / MICROS_PER_MILLIS;
+    else
+        interval.numerator = 0;
+
+    interval.denominator = 1;
+
+    return interval;
+}
+
+static Uint32 computeSteps(const Uint32 time, const Interval interval)
+{
+    if(interval.numerator > 0)
+        return (Uint32)(time * interval.denominator / interval.numerator);
+    else
+        return 0;
+}
+
+static Uint32 computeNextStepTime(const Uint32 startTicks, const Uint32 steps, const Interval interval)
+{
+    if(interval.numerator > 0)
+        return startTicks + (Uint32)(((steps + (Uint64)1) * interval.numerator + interval.denominator - 1) / interval.denominator); /* Round up, so that the step has really elapsed at that time */
+    else
+        return (Uint32)-1;
+}
+
+/* Computes the offsets of each range directly from the time that has elapsed since the start of cycling */
+
+static void advanceColorRange(SDL_ILBM_RangeTimes *rangeTimes, const unsigned int index, const ILBM_ColorRange *colorRange, const Uint32 time)
+{
+    Interval interval = computeColorRangeInterval(colorRange);
+    Uint32 steps = computeSteps(time, interval);
+
+    setContiguousRangeOffset(rangeTimes, &rangeTimes->crngOffsets[index], colorRange->low, colorRange->high, steps, colorRange->active & ILBM_COLORRANGE_SHIFT_RIGHT);
+    rangeTimes->crngTimes[index] = computeNextStepTime(rangeTimes->startTicks, steps, interval);
+}
+
+static void advanceDRange(SDL_ILBM_RangeTimes *rangeTimes, const unsigned int index, const ILBM_DRange *drange, const Uint32 time)
+{
+    Interval interval = computeDRangeInterval(drange);
+    Uint32 steps = computeSteps(time, interval);
+
+    setDRangeOffset(rangeTimes, &rangeTimes->drngOffsets[index], drange, steps);
+    rangeTimes->drngTimes[index] = computeNextStepTime(rangeTimes->startTicks, steps, interval);
+}
 
-    rangeTimes->crngTimes = (Uint32*)malloc(image->colorRangeLength * sizeof(Uint32));
-    rangeTimes->drngTimes = (Uint32*)malloc(image->drangeLength * sizeof(Uint32));
-    rangeTimes->ccrtTimes = (Uint32*)malloc(image->cycleInfoLength * sizeof(Uint32));
+static void advanceCycleInfo(SDL_ILBM_RangeTimes *rangeTimes, const unsigned int index, const ILBM_CycleInfo *cycleInfo, const Uint32 time)
+{
+    Interval interval = computeCycleInfoInterval(cycleInfo);
+    Uint32 steps = computeSteps(time, interval);
+
+    setContiguousRangeOffset(rangeTimes, &rangeTimes->ccrtOffsets[index], cycleInfo->start, cycleInfo->end, steps, cycleInfo->direction == ILBM_CYCLEINFO_SHIFT_RIGHT);
+    rangeTimes->ccrtTimes[index] = computeNextStepTime(rangeTimes->startTicks, steps, interval);
+}
+
+static amiVideo_Bool colorRangeIsActive(const ILBM_ColorRange *colorRange)
+{
+    return (colorRange->active != 0);
+}
+
+static amiVideo_Bool drangeIsActive(const ILBM_DRange *drange)
+{
+    return ((drange->flags & ILBM_RNG_ACTIVE) == ILBM_RNG_ACTIVE);
+}
+
+static amiVideo_Bool cycleInfoIsActive(const ILBM_CycleInfo *cycleInfo)
+{
+    return (cycleInfo->direction != 0);
+}
+
+static void rotateRanges(SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image, amiVideo_Color *color, const unsigned int numOfColors)
+{
+    unsigned int i;
+    unsigned int *appliedOffsets = rangeTimes->appliedOffsets;
 
-    ticks = SDL_GetTicks();
+    /* Ranges are rotated in the same order as the palette used to be shifted, so that overlapping ranges compose in the same way */
 
     for(i = 0; i < image->colorRangeLength; i++)
-        rangeTimes->crngTimes[i] = computeColorRangeTime(ticks, image->colorRange[i]);
+    {
+        ILBM_ColorRange *colorRange = image->colorRange[i];
+
+        if(colorRangeIsActive(colorRange) && rangeFits(colorRange->low, colorRange->high, numOfColors))
+            rotateContiguousRange(color, colorRange->low, colorRange->high, takeSteps(&appliedOffsets[i], rangeTimes->crngOffsets[i], colorRange->high - colorRange->low + 1));
+    }
+
+    appliedOffsets += image->colorRangeLength;
 
     for(i = 0; i < image->drangeLength; i++)
-        rangeTimes->drngTimes[i] = computeDRangeTime(ticks, image->drange[i]);
+    {
+        ILBM_DRange *drange = image->drange[i];
+
+        if(drangeIsActive(drange) && drangeFits(drange, numOfColors))
+            rotateDRange(color, drange, takeSteps(&appliedOffsets[i], rangeTimes->drngOffsets[i], drange->max - drange->min + 1));
+    }
+
+    appliedOffsets += image->drangeLength;
 
     for(i = 0; i < image->cycleInfoLength; i++)
-        rangeTimes->ccrtTimes[i] = computeCycleInfoTime(ticks, image->cycleInfo[i]);
+    {
+        ILBM_CycleInfo *cycleInfo = image->cycleInfo[i];
+
+        if(cycleInfoIsActive(cycleInfo) && rangeFits(cycleInfo->start, cycleInfo->end, numOfColors))
+            rotateContiguousRange(color, cycleInfo->start, cycleInfo->end, takeSteps(&appliedOffsets[i], rangeTimes->ccrtOffsets[i], cycleInfo->end - cycleInfo->start + 1));
+    }
+}
+
+/* Checks whether any color belongs to more than one active range, in which case the palette cannot be materialized from the offsets alone */
+
+static amiVideo_Bool claimColor(amiVideo_UByte *claimed, const unsigned int index)
+{
+    if(claimed[index])
+        return FALSE;
+
+    claimed[index] = TRUE;
+    return TRUE;
+}
+
+static amiVideo_Bool claimContiguousRange(amiVideo_UByte *claimed, const unsigned int low, const unsigned int high)
+{
+    unsigned int i;
+
+    for(i = low; i <= high; i++)
+    {
+        if(!claimColor(claimed, i))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+static amiVideo_Bool activeRangesOverlap(const SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image)
+{
+    amiVideo_UByte *claimed;
+    amiVideo_Bool disjoint = TRUE;
+    unsigned int i, j;
+
+    if(rangeTimes->baseColorsLength == 0)
+        return FALSE;
+
+    if((claimed = (amiVideo_UByte*)SDL_ILBM_calloc(rangeTimes->baseColorsLength, sizeof(amiVideo_UByte))) == NULL)
+        return TRUE; /* Rotating in place yields the right palette in both cases */
+
+    for(i = 0; i < image->colorRangeLength && disjoint; i++)
+    {
+        ILBM_ColorRange *colorRange = image->colorRange[i];
+
+        if(colorRangeIsActive(colorRange) && rangeIsValid(rangeTimes, colorRange->low, colorRange->high))
+            disjoint = claimContiguousRange(claimed, colorRange->low, colorRange->high);
+    }
+
+    for(i = 0; i < image->drangeLength && disjoint; i++)
+    {
+        ILBM_DRange *drange = image->drange[i];
+
+        if(drangeIsActive(drange) && drangeFits(drange, rangeTimes->baseColorsLength))
+        {
+            for(j = drange->min; j <= drange->max && disjoint; j++)
+                disjoint = claimColor(claimed, drange->dindex[j].index);
+        }
+    }
+
+    for(i = 0; i < image->cycleInfoLength && disjoint; i++)
+    {
+        ILBM_CycleInfo *cycleInfo = image->cycleInfo[i];
+
+        if(cycleInfoIsActive(cycleInfo) && rangeIsValid(rangeTimes, cycleInfo->start, cycleInfo->end))
+            disjoint = claimContiguousRange(claimed, cycleInfo->start, cycleInfo->end);
+    }
+
+    SDL_ILBM_free(claimed);
+    return !disjoint;
+}
+
+size_t SDL_ILBM_computeRangeTimesSize(const ILBM_Image *image, const unsigned int numOfColors)
+{
+    unsigned int rangesLength = image->colorRangeLength + image->drangeLength + image->cycleInfoLength;
+    return rangesLength * (sizeof(Uint32) + 2 * sizeof(unsigned int)) + numOfColors * sizeof(amiVideo_Color);
+}
+
+static amiVideo_Bool initRangeTimes(SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image, const amiVideo_Color *baseColors, const unsigned int numOfColors, SDL_ILBM_Arena *arena)
+{
+    unsigned int rangesLength = image->colorRangeLength + image->drangeLength + image->cycleInfoLength;
+    size_t size = SDL_ILBM_computeRangeTimesSize(image, numOfColors);
+    amiVideo_UByte *memory = NULL;
+
+    /* Carve all arrays out of one block, so that the times, offsets and base colors are close together */
+    if(arena != NULL)
+        memory = (amiVideo_UByte*)SDL_ILBM_allocateFromArena(arena, size);
+
+    if(memory == NULL)
+    {
+        memory = (amiVideo_UByte*)SDL_ILBM_malloc(size);
+        rangeTimes->memory = memory;
+
+        if(memory == NULL)
+            return FALSE;
+    }
+    else
+        rangeTimes->memory = NULL; /* The arena is freed at once with its image */
+
+    rangeTimes->crngTimes = (Uint32*)memory;
+    rangeTimes->drngTimes = rangeTimes->crngTimes + image->colorRangeLength;
+    rangeTimes->ccrtTimes = rangeTimes->drngTimes + image->drangeLength;
+
+    rangeTimes->crngOffsets = (unsigned int*)(rangeTimes->ccrtTimes + image->cycleInfoLength);
+    rangeTimes->drngOffsets = rangeTimes->crngOffsets + image->colorRangeLength;
+    rangeTimes->ccrtOffsets = rangeTimes->drngOffsets + image->drangeLength;
+    rangeTimes->appliedOffsets = rangeTimes->ccrtOffsets + image->cycleInfoLength;
+    memset(rangeTimes->crngOffsets, '\0', 2 * rangesLength * sizeof(unsigned int));
+
+    /* Memorize the unshifted colors of the palette */
+    rangeTimes->baseColorsLength = numOfColors;
+    rangeTimes->baseColors = (amiVideo_Color*)(rangeTimes->appliedOffsets + rangesLength);
+
+    if(baseColors != NULL)
+        memcpy(rangeTimes->baseColors, baseColors, numOfColors * sizeof(amiVideo_Color));
+    else
+        memset(rangeTimes->baseColors, '\0', numOfColors * sizeof(amiVideo_Color));
+
+    rangeTimes->overlapping = activeRangesOverlap(rangeTimes, image);
+    rangeTimes->restoreBaseColors = FALSE;
+    clearDirty(rangeTimes);
+
+    /* Start cycling from the current time */
+    SDL_ILBM_seekRanges(rangeTimes, image, 0);
+    return TRUE;
+}
+
+/* Estimates the amount of colors of the palette the ranges apply to, if it is not known */
+
+#define MAX_NUM_OF_ESTIMATED_COLORS 256
+
+static unsigned int estimateNumOfColors(const ILBM_Image *image)
+{
+    unsigned int numOfColors;
+
+    if(image->bitMapHeader != NULL)
+        numOfColors = 1 << (image->bitMapHeader->nPlanes < 8 ? image->bitMapHeader->nPlanes : 8);
+    else
+        numOfColors = MAX_NUM_OF_ESTIMATED_COLORS;
+
+    if(image->colorMap != NULL && image->colorMap->colorRegisterLength > numOfColors)
+        numOfColors = image->colorMap->colorRegisterLength;
+
+    return numOfColors;
+}
+
+void SDL_ILBM_initRangeTimes(SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image)
+{
+    /* Without a palette there are no base colors to memorize. That is fine, because SDL_ILBM_shiftActiveRanges() shifts the colors of the palette it is given */
+    if(!initRangeTimes(rangeTimes, image, NULL, estimateNumOfColors(image), NULL))
+        memset(rangeTimes, '\0', sizeof(SDL_ILBM_RangeTimes));
+}
+
+amiVideo_Bool SDL_ILBM_initRangeTimesFromPalette(SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image, const amiVideo_Palette *palette)
+{
+    return SDL_ILBM_initRangeTimesInArena(rangeTimes, image, palette, NULL);
+}
+
+amiVideo_Bool SDL_ILBM_initRangeTimesInArena(SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image, const amiVideo_Palette *palette, SDL_ILBM_Arena *arena)
+{
+    return initRangeTimes(rangeTimes, image, palette->bitplaneFormat.color, palette->bitplaneFormat.numOfColors, arena);
 }
 
 void SDL_ILBM_cleanupRangeTimes(SDL_ILBM_RangeTimes *rangeTimes)
 {
-    free(rangeTimes->crngTimes);
-    free(rangeTimes->drngTimes);
-    free(rangeTimes->ccrtTimes);
+    SDL_ILBM_free(rangeTimes->memory);
 }
 
 void SDL_ILBM_shiftActiveRanges(SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image, amiVideo_Palette *palette)
+{
+    if(rangeTimes->crngTimes == NULL)
+        return; /* The range times could not be allocated */
+
+    /* Shift the colors of the provided palette in place by the steps that have elapsed */
+    if(SDL_ILBM_shiftActiveRangesAt(rangeTimes, image, SDL_GetTicks()))
+    {
+        rotateRanges(rangeTimes, image, palette->bitplaneFormat.color, palette->bitplaneFormat.numOfColors);
+        clearDirty(rangeTimes);
+    }
+}
+
+amiVideo_Bool SDL_ILBM_shiftActiveRangesAt(SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image, const Uint32 ticks)
 {
     unsigned int i;
     Uint32 *crngTimes = rangeTimes->crngTimes;
     Uint32 *drngTimes = rangeTimes->drngTimes;
     Uint32 *ccrtTimes = rangeTimes->ccrtTimes;
-    Uint32 ticks = SDL_GetTicks();
+    Uint32 time = ticks - rangeTimes->startTicks;
+
+    /* Ranges whose time has elapsed are advanced by all the steps that have passed, so that stalls are caught up with */
 
     for(i = 0; i < image->colorRangeLength; i++)
     {
         ILBM_ColorRange *colorRange = image->colorRange[i];
 
-        if(colorRange->active != 0 && ticks >= crngTimes[i])
-        {
-            shiftColorRange(palette, colorRange, colorRange->active & ILBM_COLORRANGE_SHIFT_RIGHT);
-            crngTimes[i] = computeColorRangeTime(ticks, colorRange); /* Update time */
-        }
+        if(colorRangeIsActive(colorRange) && ticks >= crngTimes[i])
+            advanceColorRange(rangeTimes, i, colorRange, time);
     }
 
     for(i = 0; i < image->drangeLength; i++)
     {
         ILBM_DRange *drange = image->drange[i];
 
-        if((drange->flags & ILBM_RNG_ACTIVE) == ILBM_RNG_ACTIVE && ticks >= drngTimes[i])
-        {
-            shiftDRange(palette, drange);
-            drngTimes[i] = computeDRangeTime(ticks, drange); /* Update time */
-        }
+        if(drangeIsActive(drange) && ticks >= drngTimes[i])
+            advanceDRange(rangeTimes, i, drange, time);
+    }
+
+    for(i = 0; i < image->cycleInfoLength; i++)
+    {
+        ILBM_CycleInfo *cycleInfo = image->cycleInfo[i];
+
+        if(cycleInfoIsActive(cycleInfo) && ticks >= ccrtTimes[i])
+            advanceCycleInfo(rangeTimes, i, cycleInfo, time);
+    }
+
+    return isDirty(rangeTimes);
+}
+
+amiVideo_Bool SDL_ILBM_seekRanges(SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image, const Uint32 time)
+{
+    unsigned int i;
+
+    /* Pretend that cycling has started the given amount of time ago, so that subsequent shifts continue from there */
+    rangeTimes->startTicks = SDL_GetTicks() - time;
+
+    for(i = 0; i < image->colorRangeLength; i++)
+    {
+        ILBM_ColorRange *colorRange = image->colorRange[i];
+
+        if(colorRangeIsActive(colorRange))
+            advanceColorRange(rangeTimes, i, colorRange, time);
+    }
+
+    for(i = 0; i < image->drangeLength; i++)
+    {
+        ILBM_DRange *drange = image->drange[i];
+
+        if(drangeIsActive(drange))
+            advanceDRange(rangeTimes, i, drange, time);
     }
 
     for(i = 0; i < image->cycleInfoLength; i++)
     {
         ILBM_CycleInfo *cycleInfo = image->cycleInfo[i];
 
-        if(cycleInfo->direction != 0 && ticks >= ccrtTimes[i])
+        if(cycleInfoIsActive(cycleInfo))
+            advanceCycleInfo(rangeTimes, i, cycleInfo, time);
+    }
+
+    return isDirty(rangeTimes);
+}
+
+amiVideo_Bool SDL_ILBM_materializeRanges(SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image, amiVideo_Palette *palette, unsigned int *first, unsigned int *count)
+{
+    if(isDirty(rangeTimes))
+    {
+        unsigned int i;
+        amiVideo_Color *color = palette->bitplaneFormat.color;
+
+        if(rangeTimes->overlapping)
         {
-            shiftCycleInfo(palette, cycleInfo);
-            ccrtTimes[i] = computeCycleInfoTime(ticks, cycleInfo); /* Update time */
+            /* Colors shared by several ranges depend on the order in which they have been shifted => rotate the current palette */
+            if(rangeTimes->restoreBaseColors)
+            {
+                memcpy(color, rangeTimes->baseColors, rangeTimes->baseColorsLength * sizeof(amiVideo_Color));
+                memset(rangeTimes->appliedOffsets, '\0', SDL_ILBM_countRanges(image) * sizeof(unsigned int));
+                rangeTimes->restoreBaseColors = FALSE;
+            }
+
+            rotateRanges(rangeTimes, image, color, rangeTimes->baseColorsLength);
         }
+        else
+        {
+            /* Active ranges are disjoint => each of them can be rebuilt from the base colors independently. Inactive ranges keep their colors */
+
+            for(i = 0; i < image->colorRangeLength; i++)
+            {
+                ILBM_ColorRange *colorRange = image->colorRange[i];
+
+                if(colorRangeIsActive(colorRange) && rangeIsValid(rangeTimes, colorRange->low, colorRange->high) && intersectsDirtySpan(rangeTimes, colorRange->low, colorRange->high))
+                    materializeContiguousRange(rangeTimes, color, colorRange->low, colorRange->high, rangeTimes->crngOffsets[i]);
+            }
+
+            for(i = 0; i < image->drangeLength; i++)
+            {
+                ILBM_DRange *drange = image->drange[i];
+
+                if(drangeIsActive(drange) && drangeFits(drange, rangeTimes->baseColorsLength))
+                    materializeDRange(rangeTimes, color, drange, rangeTimes->drngOffsets[i]);
+            }
+
+            for(i = 0; i < image->cycleInfoLength; i++)
+            {
+                ILBM_CycleInfo *cycleInfo = image->cycleInfo[i];
+
+                if(cycleInfoIsActive(cycleInfo) && rangeIsValid(rangeTimes, cycleInfo->start, cycleInfo->end) && intersectsDirtySpan(rangeTimes, cycleInfo->start, cycleInfo->end))
+                    materializeContiguousRange(rangeTimes, color, cycleInfo->start, cycleInfo->end, rangeTimes->ccrtOffsets[i]);
+            }
+        }
+
+        /* Report the affected span and start over */
+        return SDL_ILBM_takeDirtySpan(rangeTimes, first, count);
+    }
+    else
+    {
+        *first = 0;
+        *count = 0;
+        return FALSE;
+    }
+}
+
+amiVideo_Bool SDL_ILBM_takeDirtySpan(SDL_ILBM_RangeTimes *rangeTimes, unsigned int *first, unsigned int *count)
+{
+    if(isDirty(rangeTimes))
+    {
+        *first = rangeTimes->dirtyLow;
+        *count = rangeTimes->dirtyHigh - rangeTimes->dirtyLow + 1;
+        clearDirty(rangeTimes);
+
+        return TRUE;
+    }
+    else
+    {
+        *first = 0;
+        *count = 0;
+        return FALSE;
+    }
+}
+
+void SDL_ILBM_invalidateRanges(SDL_ILBM_RangeTimes *rangeTimes)
+{
+    rangeTimes->restoreBaseColors = rangeTimes->overlapping;
+
+    if(rangeTimes->baseColorsLength > 0)
+        markDirty(rangeTimes, 0, rangeTimes->baseColorsLength - 1);
+}
+
+void SDL_ILBM_resetRangeOffsets(SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image)
+{
+    memset(rangeTimes->crngOffsets, '\0', image->colorRangeLength * sizeof(unsigned int));
+    memset(rangeTimes->drngOffsets, '\0', image->drangeLength * sizeof(unsigned int));
+    memset(rangeTimes->ccrtOffsets, '\0', image->cycleInfoLength * sizeof(unsigned int));
+
+    /* Every range must be materialized again to restore its base colors */
+    SDL_ILBM_invalidateRanges(rangeTimes);
+
+    /* Restart cycling from the current time */
+    SDL_ILBM_seekRanges(rangeTimes, image, 0);
+}
+
+unsigned int SDL_ILBM_countRanges(const ILBM_Image *image)
+{
+    return image->colorRangeLength + image->drangeLength + image->cycleInfoLength;
+}
+
+void SDL_ILBM_getRangeOffsets(const SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image, unsigned int *offsets)
+{
+    memcpy(offsets, rangeTimes->crngOffsets, image->colorRangeLength * sizeof(unsigned int));
+    memcpy(offsets + image->colorRangeLength, rangeTimes->drngOffsets, image->drangeLength * sizeof(unsigned int));
+    memcpy(offsets + image->colorRangeLength + image->drangeLength, rangeTimes->ccrtOffsets, image->cycleInfoLength * sizeof(unsigned int));
+}
+
+static amiVideo_Bool rangeHasWrapped(const Interval interval, const unsigned int length, const Uint32 time)
+{
+    return (interval.numerator == 0 || (time * interval.denominator) % (interval.numerator * length) == 0);
+}
+
+amiVideo_Bool SDL_ILBM_rangesHaveWrapped(const SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image, const Uint32 time)
+{
+    unsigned int i;
+
+    /* All ranges are back at the start of their first step => from here on, the same states follow as from the start */
+
+    if(time == 0)
+        return FALSE;
+
+    for(i = 0; i < image->colorRangeLength; i++)
+    {
+        ILBM_ColorRange *colorRange = image->colorRange[i];
+
+        if(colorRangeIsActive(colorRange) && rangeIsValid(rangeTimes, colorRange->low, colorRange->high)
+            && !rangeHasWrapped(computeColorRangeInterval(colorRange), colorRange->high - colorRange->low + 1, time))
+            return FALSE;
+    }
+
+    for(i = 0; i < image->drangeLength; i++)
+    {
+        ILBM_DRange *drange = image->drange[i];
+
+        if(drangeIsActive(drange) && drange->min < drange->max
+            && !rangeHasWrapped(computeDRangeInterval(drange), drange->max - drange->min + 1, time))
+            return FALSE;
+    }
+
+    for(i = 0; i < image->cycleInfoLength; i++)
+    {
+        ILBM_CycleInfo *cycleInfo = image->cycleInfo[i];
+
+        if(cycleInfoIsActive(cycleInfo) && rangeIsValid(rangeTimes, cycleInfo->start, cycleInfo->end)
+            && !rangeHasWrapped(computeCycleInfoInterval(cycleInfo), cycleInfo->end - cycleInfo->start + 1, time))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+static Uint32 selectEarliestTime(const Uint32 earliestTime, const Uint32 time, const Interval interval)
+{
+    if(interval.numerator > 0 && time < earliestTime)
+        return time;
+    else
+        return earliestTime;
+}
+
+Uint32 SDL_ILBM_computeNextRangeTime(const SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image)
+{
+    unsigned int i;
+    Uint32 nextTime = (Uint32)-1;
+
+    for(i = 0; i < image->colorRangeLength; i++)
+    {
+        if(colorRangeIsActive(image->colorRange[i]))
+            nextTime = selectEarliestTime(nextTime, rangeTimes->crngTimes[i] - rangeTimes->startTicks, computeColorRangeInterval(image->colorRange[i]));
+    }
+
+    for(i = 0; i < image->drangeLength; i++)
+    {
+        if(drangeIsActive(image->drange[i]))
+            nextTime = selectEarliestTime(nextTime, rangeTimes->drngTimes[i] - rangeTimes->startTicks, computeDRangeInterval(image->drange[i]));
+    }
+
+    for(i = 0; i < image->cycleInfoLength; i++)
+    {
+        if(cycleInfoIsActive(image->cycleInfo[i]))
+            nextTime = selectEarliestTime(nextTime, rangeTimes->ccrtTimes[i] - rangeTimes->startTicks, computeCycleInfoInterval(image->cycleInfo[i]));
+    }
+
+    return nextTime;
+}
+
+/* The period of a range is its interval multiplied by its length. The period of all ranges is the least common multiple of these fractions */
+
+#define MAX_PERIOD 0xffffffffUL
+
+static Uint64 computeGCD(Uint64 a, Uint64 b)
+{
+    while(b != 0)
+    {
+        Uint64 remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+
+    return a;
+}
+
+static amiVideo_Bool addPeriod(Interval *period, const Interval interval, const unsigned int length)
+{
+    Uint64 numerator = interval.numerator * length;
+    Uint64 denominator = interval.denominator;
+    Uint64 gcd;
+
+    if(numerator == 0)
+        return TRUE; /* Ranges that never advance do not contribute */
+
+    gcd = computeGCD(numerator, denominator);
+    numerator /= gcd;
+    denominator /= gcd;
+
+    if(period->numerator == 0)
+    {
+        period->numerator = numerator;
+        period->denominator = denominator;
+    }
+    else
+    {
+        /* lcm(a/b, c/d) = lcm(a, c) / gcd(b, d) */
+        Uint64 factor = numerator / computeGCD(period->numerator, numerator);
+
+        if(period->numerator > MAX_PERIOD * period->denominator / factor)
+            return FALSE; /* The period becomes too big to be useful */
+
+        period->numerator *= factor;
+        period->denominator = computeGCD(period->denominator, denominator);
+    }
+
+    return TRUE;
+}
+
+Uint32 SDL_ILBM_computeCyclePeriod(const SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image)
+{
+    unsigned int i;
+    Interval period;
+
+    period.numerator = 0;
+    period.denominator = 1;
+
+    for(i = 0; i < image->colorRangeLength; i++)
+    {
+        ILBM_ColorRange *colorRange = image->colorRange[i];
+
+        if(colorRangeIsActive(colorRange) && rangeIsValid(rangeTimes, colorRange->low, colorRange->high)
+            && !addPeriod(&period, computeColorRangeInterval(colorRange), colorRange->high - colorRange->low + 1))
+            return (Uint32)-1;
+    }
+
+    for(i = 0; i < image->drangeLength; i++)
+    {
+        ILBM_DRange *drange = image->drange[i];
+
+        if(drangeIsActive(drange) && drange->min < drange->max
+            && !addPeriod(&period, computeDRangeInterval(drange), drange->max - drange->min + 1))
+            return (Uint32)-1;
+    }
+
+    for(i = 0; i < image->cycleInfoLength; i++)
+    {
+        ILBM_CycleInfo *cycleInfo = image->cycleInfo[i];
+
+        if(cycleInfoIsActive(cycleInfo) && rangeIsValid(rangeTimes, cycleInfo->start, cycleInfo->end)
+            && !addPeriod(&period, computeCycleInfoInterval(cycleInfo), cycleInfo->end - cycleInfo->start + 1))
+            return (Uint32)-1;
+    }
+
+    /* Round up to whole milliseconds */
+    if(period.numerator / period.denominator >= MAX_PERIOD)
+        return (Uint32)-1;
+    else
+        return (Uint32)((period.numerator + period.denominator - 1) / period.denominator);
+}
+
+static Uint32 computeStepsPerSecond(const Interval interval)
+{
+    if(interval.numerator > 0)
+        return (Uint32)(((Uint64)MILLIS_PER_SECOND * interval.denominator + interval.numerator - 1) / interval.numerator); /* Round up, so that slow ranges still count */
+    else
+        return 0;
+}
+
+Uint32 SDL_ILBM_computeRangeStepsPerSecond(const ILBM_Image *image)
+{
+    unsigned int i;
+    Uint32 stepsPerSecond = 0;
+
+    /* Every range that advances changes the palette, so the steps of all ranges add up */
+
+    for(i = 0; i < image->colorRangeLength; i++)
+    {
+        ILBM_ColorRange *colorRange = image->colorRange[i];
+
+        if(colorRangeIsActive(colorRange) && colorRange->low < colorRange->high)
+            stepsPerSecond += computeStepsPerSecond(computeColorRangeInterval(colorRange));
+    }
+
+    for(i = 0; i < image->drangeLength; i++)
+    {
+        ILBM_DRange *drange = image->drange[i];
+
+        if(drangeIsActive(drange) && drange->min < drange->max)
+            stepsPerSecond += computeStepsPerSecond(computeDRangeInterval(drange));
     }
+
+    for(i = 0; i < image->cycleInfoLength; i++)
+    {
+        ILBM_CycleInfo *cycleInfo = image->cycleInfo[i];
+
+        if(cycleInfoIsActive(cycleInfo) && cycleInfo->start < cycleInfo->end)
+            stepsPerSecond += computeStepsPerSecond(computeCycleInfoInterval(cycleInfo));
+    }
+
+    return stepsPerSecond;
+}
+
+amiVideo_Bool SDL_ILBM_rangesAreEqual(const ILBM_Image *image1, const ILBM_Image *image2)
+{
+    unsigned int i;
+
+    if(image1->colorRangeLength != image2->colorRangeLength || image1->drangeLength != image2->drangeLength || image1->cycleInfoLength != image2->cycleInfoLength)
+        return FALSE;
+
+    for(i = 0; i < image1->colorRangeLength; i++)
+    {
+        ILBM_ColorRange *colorRange1 = image1->colorRange[i];
+        ILBM_ColorRange *colorRange2 = image2->colorRange[i];
+
+        if(colorRange1->rate != colorRange2->rate || colorRange1->active != colorRange2->active || colorRange1->low != colorRange2->low || colorRange1->high != colorRange2->high)
+            return FALSE;
+    }
+
+    for(i = 0; i < image1->drangeLength; i++)
+    {
+        ILBM_DRange *drange1 = image1->drange[i];
+        ILBM_DRange *drange2 = image2->drange[i];
+
+        if(drange1->min != drange2->min || drange1->max != drange2->max || drange1->rate != drange2->rate || drange1->flags != drange2->flags || drange1->nregs != drange2->nregs
+            || memcmp(drange1->dindex, drange2->dindex, drange1->nregs * sizeof(ILBM_DIndex)) != 0)
+            return FALSE;
+    }
+
+    for(i = 0; i < image1->cycleInfoLength; i++)
+    {
+        ILBM_CycleInfo *cycleInfo1 = image1->cycleInfo[i];
+        ILBM_CycleInfo *cycleInfo2 = image2->cycleInfo[i];
+
+        if(cycleInfo1->direction != cycleInfo2->direction || cycleInfo1->start != cycleInfo2->start || cycleInfo1->end != cycleInfo2->end
+            || cycleInfo1->seconds != cycleInfo2->seconds || cycleInfo1->microSeconds != cycleInfo2->microSeconds)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+amiVideo_Bool SDL_ILBM_baseColorsAreEqual(const SDL_ILBM_RangeTimes *rangeTimes1, const SDL_ILBM_RangeTimes *rangeTimes2)
+{
+    return (rangeTimes1->baseColorsLength == rangeTimes2->baseColorsLength && memcmp(rangeTimes1->baseColors, rangeTimes2->baseColors, rangeTimes1->baseColorsLength * sizeof(amiVideo_Color)) == 0);
+}
+
+void SDL_ILBM_copyRangeTimes(SDL_ILBM_RangeTimes *destRangeTimes, const SDL_ILBM_RangeTimes *srcRangeTimes, const ILBM_Image *image)
+{
+    memcpy(destRangeTimes->crngTimes, srcRangeTimes->crngTimes, image->colorRangeLength * sizeof(Uint32));
+    memcpy(destRangeTimes->drngTimes, srcRangeTimes->drngTimes, image->drangeLength * sizeof(Uint32));
+    memcpy(destRangeTimes->ccrtTimes, srcRangeTimes->ccrtTimes, image->cycleInfoLength * sizeof(Uint32));
+    memcpy(destRangeTimes->crngOffsets, srcRangeTimes->crngOffsets, image->colorRangeLength * sizeof(unsigned int));
+    memcpy(destRangeTimes->drngOffsets, srcRangeTimes->drngOffsets, image->drangeLength * sizeof(unsigned int));
+    memcpy(destRangeTimes->ccrtOffsets, srcRangeTimes->ccrtOffsets, image->cycleInfoLength * sizeof(unsigned int));
+    memcpy(destRangeTimes->appliedOffsets, srcRangeTimes->appliedOffsets, SDL_ILBM_countRanges(image) * sizeof(unsigned int));
+    destRangeTimes->restoreBaseColors = srcRangeTimes->restoreBaseColors;
+    destRangeTimes->startTicks = srcRangeTimes->startTicks;
 }
@@ -30,18 +30,73 @@ typedef struct SDL_ILBM_RangeTimes SDL_ILBM_RangeTimes;
 #include <SDL.h>
 #include <libilbm/ilbmimage.h>
 #include <libamivideo/palette.h>
+#include "allocator.h"
 
 struct SDL_ILBM_RangeTimes
 {
     Uint32 *crngTimes;
     Uint32 *drngTimes;
     Uint32 *ccrtTimes;
+
+    /* Rotation offsets of each range relative to the base colors */
+    unsigned int *crngOffsets;
+    unsigned int *drngOffsets;
+    unsigned int *ccrtOffsets;
+
+    /* Offsets that have been applied to the palette by rotating it in place, in the same order as the offsets above */
+    unsigned int *appliedOffsets;
+
+    /* Unshifted bitplane colors of the palette, from which the effective palette is materialized */
+    amiVideo_Color *baseColors;
+    unsigned int baseColorsLength;
+
+    /* Indicates whether active ranges share colors. Such ranges are rotated in place, in declaration order, as if the palette has been shifted step by step */
+    amiVideo_Bool overlapping;
+
+    /* Indicates whether the palette must be reset to the base colors before the ranges are rotated in place */
+    amiVideo_Bool restoreBaseColors;
+
+    /* Block containing all arrays above or NULL if they reside in an arena */
+    void *memory;
+
+    /* Time at which cycling has started, from which the offsets of the ranges are computed */
+    Uint32 startTicks;
+
+    /* Span of palette indexes that have been shifted, but not yet materialized */
+    unsigned int dirtyLow;
+    unsigned int dirtyHigh;
 };
 
+size_t SDL_ILBM_computeRangeTimesSize(const ILBM_Image *image, const unsigned int numOfColors);
+
 void SDL_ILBM_initRangeTimes(SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image);
 
+amiVideo_Bool SDL_ILBM_initRangeTimesFromPalette(SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image, const amiVideo_Palette *palette);
+
+amiVideo_Bool SDL_ILBM_initRangeTimesInArena(SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image, const amiVideo_Palette *palette, SDL_ILBM_Arena *arena);
+
 void SDL_ILBM_cleanupRangeTimes(SDL_ILBM_RangeTimes *rangeTimes);
 
 void SDL_ILBM_shiftActiveRanges(SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image, amiVideo_Palette *palette);
 
+amiVideo_Bool SDL_ILBM_shiftActiveRangesAt(SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image, const Uint32 ticks);
+
+amiVideo_Bool SDL_ILBM_seekRanges(SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image, const Uint32 time);
+
+amiVideo_Bool SDL_ILBM_materializeRanges(SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image, amiVideo_Palette *palette, unsigned int *first, unsigned int *count);
+
+void SDL_ILBM_resetRangeOffsets(SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image);
+
+Uint32 SDL_ILBM_computeNextRangeTime(const SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image);
+
+Uint32 SDL_ILBM_computeCyclePeriod(const SDL_ILBM_RangeTimes *rangeTimes, const ILBM_Image *image);
+
+Uint32 SDL_ILBM_computeRangeStepsPerSecond(const ILBM_Image *image);
+
+amiVideo_Bool SDL_ILBM_rangesAreEqual(const ILBM_Image *image1, const ILBM_Image *image2);
+
+amiVideo_Bool SDL_ILBM_baseColorsAreEqual(const SDL_ILBM_RangeTimes *rangeTimes1, const SDL_ILBM_RangeTimes *rangeTimes2);
+
+void SDL_ILBM_copyRangeTimes(SDL_ILBM_RangeTimes *destRangeTimes, const SDL_ILBM_RangeTimes *srcRangeTimes, const ILBM_Image *image);
+
 #endif
@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#include "cyclegroup.h"
+#include <stdlib.h>
+
+void SDL_ILBM_initCycleGroup(SDL_ILBM_CycleGroup *cycleGroup)
+{
+    cycleGroup->palettes = NULL;
+    cycleGroup->palettesLength = 0;
+}
+
+SDL_ILBM_CycleGroup *SDL_ILBM_createCycleGroup(void)
+{
+    SDL_ILBM_CycleGroup *cycleGroup = (SDL_ILBM_CycleGroup*)SDL_ILBM_malloc(sizeof(SDL_ILBM_CycleGroup));
+
+    if(cycleGroup != NULL)
+        SDL_ILBM_initCycleGroup(cycleGroup);
+
+    return cycleGroup;
+}
+
+void SDL_ILBM_cleanupCycleGroup(SDL_ILBM_CycleGroup *cycleGroup)
+{
+    unsigned int i;
+
+    for(i = 0; i < cycleGroup->palettesLength; i++)
+    {
+        SDL_ILBM_CycleGroupPalette *palette = &cycleGroup->palettes[i];
+        unsigned int j;
+
+        for(j = 0; j < palette->imagesLength; j++)
+            palette->images[j]->cycleGroup = NULL;
+
+        SDL_ILBM_free(palette->images);
+    }
+
+    SDL_ILBM_free(cycleGroup->palettes);
+}
+
+void SDL_ILBM_freeCycleGroup(SDL_ILBM_CycleGroup *cycleGroup)
+{
+    if(cycleGroup != NULL)
+    {
+        SDL_ILBM_cleanupCycleGroup(cycleGroup);
+        SDL_ILBM_free(cycleGroup);
+    }
+}
+
+static amiVideo_Bool imagesSharePalette(const SDL_ILBM_Image *image1, const SDL_ILBM_Image *image2)
+{
+    return (SDL_ILBM_baseColorsAreEqual(&image1->rangeTimes, &image2->rangeTimes) && SDL_ILBM_rangesAreEqual(image1->image, image2->image));
+}
+
+static SDL_ILBM_CycleGroupPalette *searchPalette(SDL_ILBM_CycleGroup *cycleGroup, const SDL_ILBM_Image *image)
+{
+    unsigned int i;
+
+    for(i = 0; i < cycleGroup->palettesLength; i++)
+    {
+        SDL_ILBM_CycleGroupPalette *palette = &cycleGroup->palettes[i];
+
+        if(imagesSharePalette(palette->images[0], image))
+            return palette;
+    }
+
+    return NULL;
+}
+
+static SDL_ILBM_CycleGroupPalette *addPalette(SDL_ILBM_CycleGroup *cycleGroup)
+{
+    SDL_ILBM_CycleGroupPalette *palettes = (SDL_ILBM_CycleGroupPalette*)SDL_ILBM_realloc(cycleGroup->palettes, (cycleGroup->palettesLength + 1) * sizeof(SDL_ILBM_CycleGroupPalette));
+
+    if(palettes == NULL)
+        return NULL;
+    else
+    {
+        SDL_ILBM_CycleGroupPalette *palette = &palettes[cycleGroup->palettesLength];
+
+        palette->images = NULL;
+        palette->imagesLength = 0;
+
+        cycleGroup->palettes = palettes;
+        cycleGroup->palettesLength++;
+
+        return palette;
+    }
+}
+
+static amiVideo_Bool addImageToPalette(SDL_ILBM_CycleGroupPalette *palette, SDL_ILBM_Image *image)
+{
+    SDL_ILBM_Image **images = (SDL_ILBM_Image**)SDL_ILBM_realloc(palette->images, (palette->imagesLength + 1) * sizeof(SDL_ILBM_Image*));
+
+    if(images == NULL)
+        return FALSE;
+    else
+    {
+        images[palette->imagesLength] = image;
+        palette->images = images;
+        palette->imagesLength++;
+        return TRUE;
+    }
+}
+
+amiVideo_Bool SDL_ILBM_addImageToCycleGroup(SDL_ILBM_CycleGroup *cycleGroup, SDL_ILBM_Image *image)
+{
+    SDL_ILBM_CycleGroupPalette *palette;
+
+    if(image->cycleGroup != NULL)
+        return FALSE; /* An image can only be cycled by one group */
+
+    palette = searchPalette(cycleGroup, image);
+
+    if(palette == NULL)
+    {
+        /* This is the first image with these colors and ranges => it becomes the one that gets cycled */
+        palette = addPalette(cycleGroup);
+
+        if(palette == NULL)
+            return FALSE;
+        else if(!addImageToPalette(palette, image))
+        {
+            cycleGroup->palettesLength--;
+            return FALSE;
+        }
+    }
+    else
+    {
+        SDL_ILBM_Image *leader = palette->images[0];
+
+        if(!addImageToPalette(palette, image))
+            return FALSE;
+
+        /* Adopt the current state of the images that share the palette */
+        SDL_ILBM_copyRangeTimes(&image->rangeTimes, &leader->rangeTimes, image->image);
+        SDL_ILBM_copyColors(image, leader, 0, image->rangeTimes.baseColorsLength);
+    }
+
+    image->cycleGroup = cycleGroup;
+    return TRUE;
+}
+
+void SDL_ILBM_removeImageFromCycleGroup(SDL_ILBM_CycleGroup *cycleGroup, SDL_ILBM_Image *image)
+{
+    unsigned int i;
+
+    for(i = 0; i < cycleGroup->palettesLength; i++)
+    {
+        SDL_ILBM_CycleGroupPalette *palette = &cycleGroup->palettes[i];
+        unsigned int j;
+
+        for(j = 0; j < palette->imagesLength; j++)
+        {
+            if(palette->images[j] == image)
+            {
+                image->cycleGroup = NULL;
+
+                /* Only the first image's ranges have been advanced => let the image continue from the group's state */
+                if(j > 0)
+                    SDL_ILBM_copyRangeTimes(&image->rangeTimes, &palette->images[0]->rangeTimes, image->image);
+                else if(palette->imagesLength > 1)
+                    SDL_ILBM_copyRangeTimes(&palette->images[1]->rangeTimes, &image->rangeTimes, image->image); /* The next image takes over */
+
+                palette->imagesLength--;
+                palette->images[j] = palette->images[palette->imagesLength];
+
+                /* Keep the image whose ranges were handed over in front */
+                if(j == 0 && palette->imagesLength > 1)
+                {
+                    SDL_ILBM_Image *temp = palette->images[0];
+                    palette->images[0] = palette->images[1];
+                    palette->images[1] = temp;
+                }
+
+                /* Remove the palette if no images refer to it anymore */
+                if(palette->imagesLength == 0)
+                {
+                    SDL_ILBM_free(palette->images);
+                    cycleGroup->palettesLength--;
+                    cycleGroup->palettes[i] = cycleGroup->palettes[cycleGroup->palettesLength];
+                }
+
+                return;
+            }
+        }
+    }
+}
+
+amiVideo_Bool SDL_ILBM_cycleGroupColors(SDL_ILBM_CycleGroup *cycleGroup)
+{
+    unsigned int i;
+    amiVideo_Bool changed = FALSE;
+    Uint32 ticks = SDL_GetTicks();
+
+    for(i = 0; i < cycleGroup->palettesLength; i++)
+    {
+        SDL_ILBM_CycleGroupPalette *palette = &cycleGroup->palettes[i];
+        SDL_ILBM_Image *leader = palette->images[0];
+        unsigned int first, count;
+
+        /* Shift the ranges once, and propagate the result to all other images sharing the palette */
+        if(SDL_ILBM_cycleColorsAt(leader, ticks, &first, &count))
+        {
+            unsigned int j;
+
+            for(j = 1; j < palette->imagesLength; j++)
+                SDL_ILBM_copyColors(palette->images[j], leader, first, count);
+
+            changed = TRUE;
+        }
+    }
+
+    return changed;
+}
+
+void SDL_ILBM_resetGroupColors(SDL_ILBM_CycleGroup *cycleGroup)
+{
+    unsigned int i;
+
+    for(i = 0; i < cycleGroup->palettesLength; i++)
+    {
+        SDL_ILBM_CycleGroupPalette *palette = &cycleGroup->palettes[i];
+        SDL_ILBM_Image *leader = palette->images[0];
+        unsigned int j;
+
+        SDL_ILBM_resetColors(leader);
+
+        for(j = 1; j < palette->imagesLength; j++)
+            SDL_ILBM_copyColors(palette->images[j], leader, 0, leader->rangeTimes.baseColorsLength);
+    }
+}
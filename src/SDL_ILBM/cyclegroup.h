@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#ifndef __SDL_ILBM_CYCLEGROUP_H
+#define __SDL_ILBM_CYCLEGROUP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SDL_ILBM_CycleGroup SDL_ILBM_CycleGroup;
+
+#include <SDL.h>
+#include "image.h"
+
+/**
+ * @brief A collection of images in a cycle group sharing identical colors and color ranges
+ */
+typedef struct
+{
+    /** Images sharing the palette. The color ranges of the first image are advanced on behalf of all of them */
+    SDL_ILBM_Image **images;
+
+    /** Specifies the length of the images array */
+    unsigned int imagesLength;
+}
+SDL_ILBM_CycleGroupPalette;
+
+/**
+ * @brief Cycles the colors of many images at once
+ */
+struct SDL_ILBM_CycleGroup
+{
+    /** An array of distinct palettes */
+    SDL_ILBM_CycleGroupPalette *palettes;
+
+    /** Specifies the length of the palettes array */
+    unsigned int palettesLength;
+};
+
+/**
+ * Initializes a preallocated empty cycle group.
+ *
+ * @param cycleGroup Preallocated cycle group
+ */
+void SDL_ILBM_initCycleGroup(SDL_ILBM_CycleGroup *cycleGroup);
+
+/**
+ * Creates an empty cycle group.
+ *
+ * @return An SDL_ILBM_CycleGroup instance or NULL in case of an error. The result must be freed with SDL_ILBM_freeCycleGroup()
+ */
+SDL_ILBM_CycleGroup *SDL_ILBM_createCycleGroup(void);
+
+/**
+ * Clears the properties of the provided cycle group from memory. The images
+ * themselves are not freed, but no longer belong to the group.
+ *
+ * @param cycleGroup An SDL_ILBM_CycleGroup instance
+ */
+void SDL_ILBM_cleanupCycleGroup(SDL_ILBM_CycleGroup *cycleGroup);
+
+/**
+ * Frees the provided cycle group from memory. The images themselves are not
+ * freed.
+ *
+ * @param cycleGroup An SDL_ILBM_CycleGroup instance
+ */
+void SDL_ILBM_freeCycleGroup(SDL_ILBM_CycleGroup *cycleGroup);
+
+/**
+ * Adds an image to the cycle group. If the group already contains an image
+ * with identical colors and color ranges, the image adopts its palette and
+ * both will share the work of cycling from then on. An image belongs to at
+ * most one group. Destroying or freeing the image removes it from its group.
+ *
+ * @param cycleGroup An SDL_ILBM_CycleGroup instance
+ * @param image An SDL_ILBM_Image instance
+ * @return TRUE if the image was added, or FALSE if it already belongs to a group or in case of an error
+ */
+amiVideo_Bool SDL_ILBM_addImageToCycleGroup(SDL_ILBM_CycleGroup *cycleGroup, SDL_ILBM_Image *image);
+
+/**
+ * Removes an image from the cycle group. Its color ranges continue from the
+ * state they had in the group.
+ *
+ * @param cycleGroup An SDL_ILBM_CycleGroup instance
+ * @param image An SDL_ILBM_Image instance
+ */
+void SDL_ILBM_removeImageFromCycleGroup(SDL_ILBM_CycleGroup *cycleGroup, SDL_ILBM_Image *image);
+
+/**
+ * Cycles the colors of all images in the group using a single time sample.
+ * Each distinct palette is shifted once and only the images whose palette has
+ * changed are updated.
+ *
+ * @param cycleGroup An SDL_ILBM_CycleGroup instance
+ * @return TRUE if the palette of any image has changed, else FALSE
+ */
+amiVideo_Bool SDL_ILBM_cycleGroupColors(SDL_ILBM_CycleGroup *cycleGroup);
+
+/**
+ * Resets the colors of all images in the group back to normal.
+ *
+ * @param cycleGroup An SDL_ILBM_CycleGroup instance
+ */
+void SDL_ILBM_resetGroupColors(SDL_ILBM_CycleGroup *cycleGroup);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#include "cyclerenderer.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* The slot holds the index of a frame. This flag indicates that the worker thread has finished it, but the main thread has not taken it yet */
+#define FRESH_FRAME 0x4
+#define FRAME_INDEX_MASK 0x3
+
+/* Longest time the worker thread sleeps at once, so that it notices in time that it must stop */
+#define MAX_SLEEP_TIME 10
+
+/* Time the worker thread waits before checking again whether there are active ranges */
+#define IDLE_TIME 100
+
+static void copyFrame(SDL_Surface *frame, SDL_Surface *surface)
+{
+    unsigned int rowSize = surface->w * surface->format->BytesPerPixel;
+    int y;
+
+    if(SDL_MUSTLOCK(surface) && SDL_LockSurface(surface) != 0)
+        return;
+
+    if(SDL_MUSTLOCK(frame) && SDL_LockSurface(frame) != 0)
+    {
+        if(SDL_MUSTLOCK(surface))
+            SDL_UnlockSurface(surface);
+
+        return;
+    }
+
+    for(y = 0; y < surface->h; y++)
+        memcpy((Uint8*)frame->pixels + y * frame->pitch, (const Uint8*)surface->pixels + y * surface->pitch, rowSize);
+
+    if(SDL_MUSTLOCK(frame))
+        SDL_UnlockSurface(frame);
+
+    if(SDL_MUSTLOCK(surface))
+        SDL_UnlockSurface(surface);
+}
+
+static void resetFrames(SDL_ILBM_CycleRenderer *cycleRenderer)
+{
+    unsigned int i;
+
+    for(i = 0; i < SDL_ILBM_NUM_OF_CYCLED_FRAMES; i++)
+        copyFrame(cycleRenderer->frames[i], cycleRenderer->image->surface);
+
+    cycleRenderer->front = 0;
+    SDL_AtomicSet(&cycleRenderer->slot, 1);
+    cycleRenderer->back = 2;
+    cycleRenderer->latest = cycleRenderer->back;
+}
+
+amiVideo_Bool SDL_ILBM_initCycleRenderer(SDL_ILBM_CycleRenderer *cycleRenderer, SDL_ILBM_Image *image)
+{
+    SDL_PixelFormat *format = image->surface->format;
+    unsigned int i;
+
+    cycleRenderer->image = image;
+    cycleRenderer->surface = image->surface;
+    cycleRenderer->thread = NULL;
+    SDL_AtomicSet(&cycleRenderer->dueTicks, 0);
+    SDL_AtomicSet(&cycleRenderer->quit, FALSE);
+    memset(cycleRenderer->frames, '\0', sizeof(cycleRenderer->frames));
+
+    if(image->format == SDL_ILBM_CHUNKY_FORMAT)
+        return FALSE; /* Chunky images only update their palettes, which does not have to be offloaded */
+
+    for(i = 0; i < SDL_ILBM_NUM_OF_CYCLED_FRAMES; i++)
+    {
+        cycleRenderer->frames[i] = SDL_CreateRGBSurface(0, image->surface->w, image->surface->h, format->BitsPerPixel, format->Rmask, format->Gmask, format->Bmask, format->Amask);
+
+        if(cycleRenderer->frames[i] == NULL)
+        {
+            SDL_ILBM_cleanupCycleRenderer(cycleRenderer);
+            return FALSE;
+        }
+    }
+
+    resetFrames(cycleRenderer);
+    return TRUE;
+}
+
+SDL_ILBM_CycleRenderer *SDL_ILBM_createCycleRenderer(SDL_ILBM_Image *image)
+{
+    SDL_ILBM_CycleRenderer *cycleRenderer = (SDL_ILBM_CycleRenderer*)SDL_ILBM_malloc(sizeof(SDL_ILBM_CycleRenderer));
+
+    if(cycleRenderer != NULL)
+    {
+        if(!SDL_ILBM_initCycleRenderer(cycleRenderer, image))
+        {
+            SDL_ILBM_free(cycleRenderer);
+            return NULL;
+        }
+    }
+
+    return cycleRenderer;
+}
+
+void SDL_ILBM_cleanupCycleRenderer(SDL_ILBM_CycleRenderer *cycleRenderer)
+{
+    unsigned int i;
+
+    SDL_ILBM_stopCycleRenderer(cycleRenderer);
+
+    for(i = 0; i < SDL_ILBM_NUM_OF_CYCLED_FRAMES; i++)
+        SDL_FreeSurface(cycleRenderer->frames[i]);
+}
+
+void SDL_ILBM_freeCycleRenderer(SDL_ILBM_CycleRenderer *cycleRenderer)
+{
+    if(cycleRenderer != NULL)
+    {
+        SDL_ILBM_cleanupCycleRenderer(cycleRenderer);
+        SDL_ILBM_free(cycleRenderer);
+    }
+}
+
+/* Sleeps until a given moment in time, unless the worker thread must stop earlier */
+
+static amiVideo_Bool waitUntil(SDL_ILBM_CycleRenderer *cycleRenderer, const Uint32 ticks)
+{
+    Uint32 now;
+
+    while((now = SDL_GetTicks()) < ticks)
+    {
+        Uint32 sleepTime = ticks - now;
+
+        if(SDL_AtomicGet(&cycleRenderer->quit))
+            return FALSE;
+
+        SDL_Delay(sleepTime > MAX_SLEEP_TIME ? MAX_SLEEP_TIME : sleepTime);
+    }
+
+    return !SDL_AtomicGet(&cycleRenderer->quit);
+}
+
+/* Hands the back frame over to the main thread and continues with the frame the main thread has not taken or has released */
+
+static void publishFrame(SDL_ILBM_CycleRenderer *cycleRenderer)
+{
+    int slot;
+
+    SDL_MemoryBarrierRelease(); /* The pixels of the frame must be visible before the main thread can take it */
+    slot = SDL_AtomicSet(&cycleRenderer->slot, cycleRenderer->back | FRESH_FRAME);
+    SDL_MemoryBarrierAcquire(); /* The main thread must be done with the released frame before it is overwritten */
+    cycleRenderer->back = slot & FRAME_INDEX_MASK;
+
+    /* Render the next frame directly into the frame that has been released */
+    SDL_ILBM_redirectImage(cycleRenderer->image, cycleRenderer->frames[cycleRenderer->back]);
+}
+
+static int renderFrames(void *data)
+{
+    SDL_ILBM_CycleRenderer *cycleRenderer = (SDL_ILBM_CycleRenderer*)data;
+    SDL_ILBM_Image *image = cycleRenderer->image;
+
+    while(!SDL_AtomicGet(&cycleRenderer->quit))
+    {
+        Uint32 nextTime = SDL_ILBM_computeNextRangeTime(&image->rangeTimes, image->image);
+
+        if(nextTime == (Uint32)-1)
+        {
+            Uint32 idleTicks = SDL_GetTicks() + IDLE_TIME;
+
+            SDL_AtomicSet(&cycleRenderer->dueTicks, (int)idleTicks);
+            waitUntil(cycleRenderer, idleTicks); /* No active ranges => nothing to render */
+        }
+        else
+        {
+            unsigned int first, count;
+            Uint32 now = SDL_GetTicks();
+            Uint32 deadline = image->rangeTimes.startTicks + nextTime;
+
+            /* If the worker has fallen behind, skip the frames that have been missed */
+            if(deadline < now)
+                deadline = now;
+
+            SDL_AtomicSet(&cycleRenderer->dueTicks, (int)deadline);
+
+            /* Render the frame into the back frame before the moment its colors change, and hand it over once that moment has arrived */
+            if(SDL_ILBM_cycleColorsAt(image, deadline, &first, &count))
+            {
+                cycleRenderer->latest = cycleRenderer->back;
+
+                if(waitUntil(cycleRenderer, deadline))
+                    publishFrame(cycleRenderer);
+            }
+            else
+                waitUntil(cycleRenderer, deadline);
+        }
+    }
+
+    return 0;
+}
+
+amiVideo_Bool SDL_ILBM_startCycleRenderer(SDL_ILBM_CycleRenderer *cycleRenderer)
+{
+    if(cycleRenderer->thread != NULL)
+        return TRUE; /* Already running */
+
+    /* Start from the current state of the image, which may have been changed while the renderer was stopped */
+    resetFrames(cycleRenderer);
+    SDL_AtomicSet(&cycleRenderer->quit, FALSE);
+    SDL_AtomicSet(&cycleRenderer->dueTicks, (int)SDL_GetTicks());
+
+    /* The worker thread renders the frames directly, instead of rendering the surface of the image and copying it */
+    SDL_ILBM_redirectImage(cycleRenderer->image, cycleRenderer->frames[cycleRenderer->back]);
+
+    cycleRenderer->thread = SDL_CreateThread(renderFrames, "SDL_ILBM cycle renderer", cycleRenderer);
+
+    if(cycleRenderer->thread == NULL)
+    {
+        SDL_ILBM_redirectImage(cycleRenderer->image, cycleRenderer->surface);
+        return FALSE;
+    }
+    else
+        return TRUE;
+}
+
+void SDL_ILBM_stopCycleRenderer(SDL_ILBM_CycleRenderer *cycleRenderer)
+{
+    if(cycleRenderer->thread != NULL)
+    {
+        SDL_AtomicSet(&cycleRenderer->quit, TRUE);
+        SDL_WaitThread(cycleRenderer->thread, NULL);
+        cycleRenderer->thread = NULL;
+
+        /* Give the image its own surface back, showing the state its ranges have reached */
+        copyFrame(cycleRenderer->surface, cycleRenderer->frames[cycleRenderer->latest]);
+        SDL_ILBM_redirectImage(cycleRenderer->image, cycleRenderer->surface);
+    }
+}
+
+amiVideo_Bool SDL_ILBM_takeCycledFrame(SDL_ILBM_CycleRenderer *cycleRenderer)
+{
+    if(SDL_AtomicGet(&cycleRenderer->slot) & FRESH_FRAME)
+    {
+        /* Release the presented frame to the worker thread in exchange for the fresh one */
+        int slot;
+
+        SDL_MemoryBarrierRelease();
+        slot = SDL_AtomicSet(&cycleRenderer->slot, cycleRenderer->front);
+        SDL_MemoryBarrierAcquire(); /* Do not read the pixels of the fresh frame before they are visible */
+        cycleRenderer->front = slot & FRAME_INDEX_MASK;
+        return TRUE;
+    }
+    else
+        return FALSE;
+}
+
+Uint32 SDL_ILBM_computeCycledFrameDelay(SDL_ILBM_CycleRenderer *cycleRenderer)
+{
+    Uint32 dueTicks = (Uint32)SDL_AtomicGet(&cycleRenderer->dueTicks);
+    Uint32 now = SDL_GetTicks();
+
+    if(dueTicks > now)
+        return dueTicks - now;
+    else
+        return 0;
+}
+
+SDL_Surface *SDL_ILBM_getCycledFrame(const SDL_ILBM_CycleRenderer *cycleRenderer)
+{
+    return cycleRenderer->frames[cycleRenderer->front];
+}
+
+amiVideo_Bool SDL_ILBM_blitCycledFrameToTexture(const SDL_ILBM_CycleRenderer *cycleRenderer, Uint32 format, void *pixels, int pitch)
+{
+    SDL_Surface *frame = SDL_ILBM_getCycledFrame(cycleRenderer);
+    return (SDL_ConvertPixels(frame->w, frame->h, frame->format->format, frame->pixels, frame->pitch, format, pixels, pitch) == 0);
+}
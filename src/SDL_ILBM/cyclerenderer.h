@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#ifndef __SDL_ILBM_CYCLERENDERER_H
+#define __SDL_ILBM_CYCLERENDERER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SDL_ILBM_CycleRenderer SDL_ILBM_CycleRenderer;
+
+#include <SDL.h>
+#include "image.h"
+
+/** Amount of frames a cycle renderer maintains: one being presented, one ready to be taken and one being rendered */
+#define SDL_ILBM_NUM_OF_CYCLED_FRAMES 3
+
+/**
+ * @brief Cycles the colors of an RGB image and renders its frames on a worker
+ * thread. Each frame is rendered ahead of the moment its colors change and is
+ * handed over to the main thread through a lock-free slot when that moment has
+ * arrived, so that the main thread only has to upload and present it.
+ */
+struct SDL_ILBM_CycleRenderer
+{
+    /** Image whose colors are cycled. It is owned by the worker thread while the renderer runs */
+    SDL_ILBM_Image *image;
+
+    /** Surfaces into which the frames are rendered */
+    SDL_Surface *frames[SDL_ILBM_NUM_OF_CYCLED_FRAMES];
+
+    /** Surface of the image, which the image renders to again once the worker thread has stopped */
+    SDL_Surface *surface;
+
+    /** Index of the frame that is presented by the main thread */
+    unsigned int front;
+
+    /** Index of the frame that is rendered by the worker thread */
+    unsigned int back;
+
+    /** Index of the frame that the worker thread has rendered most recently */
+    unsigned int latest;
+
+    /** Moment at which the worker thread is expected to hand over the next frame */
+    SDL_atomic_t dueTicks;
+
+    /** Index of the frame that is exchanged between both threads, including a flag indicating whether it has not been taken yet */
+    SDL_atomic_t slot;
+
+    /** Indicates whether the worker thread must stop */
+    SDL_atomic_t quit;
+
+    /** The worker thread or NULL if the renderer is not running */
+    SDL_Thread *thread;
+};
+
+/**
+ * Initializes a preallocated cycle renderer for an image. Only images having
+ * the RGB format are supported, as chunky images only update their palettes.
+ *
+ * @param cycleRenderer Preallocated cycle renderer
+ * @param image An SDL_ILBM_Image instance having the RGB format
+ * @return TRUE if the initialization succeeds, else FALSE
+ */
+amiVideo_Bool SDL_ILBM_initCycleRenderer(SDL_ILBM_CycleRenderer *cycleRenderer, SDL_ILBM_Image *image);
+
+/**
+ * Creates a cycle renderer for an image.
+ *
+ * @param image An SDL_ILBM_Image instance having the RGB format
+ * @return An SDL_ILBM_CycleRenderer instance or NULL in case of an error. The result must be freed with SDL_ILBM_freeCycleRenderer()
+ */
+SDL_ILBM_CycleRenderer *SDL_ILBM_createCycleRenderer(SDL_ILBM_Image *image);
+
+/**
+ * Stops the provided cycle renderer and clears its properties from memory.
+ * The image itself is not freed.
+ *
+ * @param cycleRenderer An SDL_ILBM_CycleRenderer instance
+ */
+void SDL_ILBM_cleanupCycleRenderer(SDL_ILBM_CycleRenderer *cycleRenderer);
+
+/**
+ * Stops the provided cycle renderer and frees it from memory.
+ *
+ * @param cycleRenderer An SDL_ILBM_CycleRenderer instance
+ */
+void SDL_ILBM_freeCycleRenderer(SDL_ILBM_CycleRenderer *cycleRenderer);
+
+/**
+ * Starts a worker thread that cycles the colors of the image and renders its
+ * frames. While it runs, the image must not be modified or read by any other
+ * thread.
+ *
+ * @param cycleRenderer An SDL_ILBM_CycleRenderer instance
+ * @return TRUE if the worker thread has been started, else FALSE
+ */
+amiVideo_Bool SDL_ILBM_startCycleRenderer(SDL_ILBM_CycleRenderer *cycleRenderer);
+
+/**
+ * Stops the worker thread and waits for it to finish. Afterwards, the image
+ * can be used by the caller again and its surface shows the most recently
+ * rendered frame.
+ *
+ * @param cycleRenderer An SDL_ILBM_CycleRenderer instance
+ */
+void SDL_ILBM_stopCycleRenderer(SDL_ILBM_CycleRenderer *cycleRenderer);
+
+/**
+ * Checks whether the worker thread has finished a new frame and takes it, so
+ * that it becomes the frame returned by SDL_ILBM_getCycledFrame(). This
+ * function must be invoked by a single thread only.
+ *
+ * @param cycleRenderer An SDL_ILBM_CycleRenderer instance
+ * @return TRUE if a new frame has been taken, else FALSE
+ */
+amiVideo_Bool SDL_ILBM_takeCycledFrame(SDL_ILBM_CycleRenderer *cycleRenderer);
+
+/**
+ * Computes how long it takes until the worker thread is expected to hand over
+ * the next frame, so that the caller can sleep in the meantime.
+ *
+ * @param cycleRenderer An SDL_ILBM_CycleRenderer instance
+ * @return The amount of milliseconds until the next frame is due, or 0 if it is due already
+ */
+Uint32 SDL_ILBM_computeCycledFrameDelay(SDL_ILBM_CycleRenderer *cycleRenderer);
+
+/**
+ * Returns the most recently taken frame.
+ *
+ * @param cycleRenderer An SDL_ILBM_CycleRenderer instance
+ * @return A surface with the same dimensions and format as the image's surface. It remains valid until the next frame is taken
+ */
+SDL_Surface *SDL_ILBM_getCycledFrame(const SDL_ILBM_CycleRenderer *cycleRenderer);
+
+/**
+ * Blits the most recently taken frame to an SDL texture so that it can be
+ * rendered to a window.
+ *
+ * @param cycleRenderer An SDL_ILBM_CycleRenderer instance
+ * @param format One of the enumerated SDL texture formats
+ * @param pixels Point to the pixel surface area
+ * @param pitch The size of each scanline in bytes
+ * @return TRUE in case success, else FALSE
+ */
+amiVideo_Bool SDL_ILBM_blitCycledFrameToTexture(const SDL_ILBM_CycleRenderer *cycleRenderer, Uint32 format, void *pixels, int pitch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
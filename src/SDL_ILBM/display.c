@@ -25,23 +25,72 @@
 #include "display.h"
 #include <stdlib.h>
 #include <SDL.h>
+#include <libamivideo/viewportmode.h>
+
+/* Computes by how much the renderer has to stretch an uncorrected image to correct its aspect ratio */
+
+static void selectScaleFactors(SDL_ILBM_Display *display, const SDL_ILBM_Image *image, const unsigned int lowresPixelScaleFactor)
+{
+    int width = image->image->bitMapHeader->w;
+    int height = image->image->bitMapHeader->h;
+
+    if(image->lowresPixelScaleFactor > 1 || lowresPixelScaleFactor == 1 || width == 0 || height == 0)
+    {
+        /* The surface is already corrected or does not need to be corrected */
+        display->scaleX = 1;
+        display->scaleY = 1;
+    }
+    else
+    {
+        unsigned int realLowresPixelScaleFactor;
+        int correctedWidth, correctedHeight;
+
+        if(lowresPixelScaleFactor == 0)
+            realLowresPixelScaleFactor = amiVideo_autoSelectLowresPixelScaleFactor(image->screen.viewportMode);
+        else
+            realLowresPixelScaleFactor = lowresPixelScaleFactor;
+
+        correctedWidth = amiVideo_calculateCorrectedWidth(realLowresPixelScaleFactor, width, image->screen.viewportMode);
+        correctedHeight = amiVideo_calculateCorrectedHeight(realLowresPixelScaleFactor, height, image->screen.viewportMode);
+
+        if(correctedWidth >= width && correctedHeight >= height && correctedWidth % width == 0 && correctedHeight % height == 0)
+        {
+            display->scaleX = correctedWidth / width;
+            display->scaleY = correctedHeight / height;
+        }
+        else
+        {
+            /* Pixels can only be replicated a whole number of times => display the image as it is */
+            display->scaleX = 1;
+            display->scaleY = 1;
+        }
+    }
+}
 
 int SDL_ILBM_initDisplay(SDL_ILBM_Display *display, const SDL_ILBM_Image *image, const int stretch)
+{
+    return SDL_ILBM_initScaledDisplay(display, image, stretch, 1);
+}
+
+int SDL_ILBM_initScaledDisplay(SDL_ILBM_Display *display, const SDL_ILBM_Image *image, const int stretch, const unsigned int lowresPixelScaleFactor)
 {
     display->image = image;
+    display->arena = NULL;
+
+    selectScaleFactors(display, image, lowresPixelScaleFactor);
 
     /* Determine the appropriate dimensions of the display */
     if(stretch)
     {
-        display->width = image->surface->w;
-        display->height = image->surface->h;
+        display->width = image->surface->w * display->scaleX;
+        display->height = image->surface->h * display->scaleY;
     }
     else
     {
         if(image->lowresPixelScaleFactor == 1)
         {
-            display->width = image->image->bitMapHeader->pageWidth;
-            display->height = image->image->bitMapHeader->pageHeight;
+            display->width = image->image->bitMapHeader->pageWidth * display->scaleX;
+            display->height = image->image->bitMapHeader->pageHeight * display->scaleY;
         }
         else
         {
@@ -50,35 +99,43 @@ int SDL_ILBM_initDisplay(SDL_ILBM_Display *display, const SDL_ILBM_Image *image,
         }
     }
 
-    /* Allocate a conversion surface, if needed */
-
-    if(image->format == SDL_ILBM_CHUNKY_FORMAT)
-    {
-        display->mustFreeBlitSurface = TRUE;
-        display->blitSurface = SDL_CreateRGBSurface(0, image->surface->w, image->surface->h, 32, 0, 0, 0, 0);
-
-        return (display->blitSurface != NULL);
-    }
-    else
-    {
-        display->mustFreeBlitSurface = FALSE;
-        display->blitSurface = image->surface;
+    /* The pixels are rendered directly into the texture, so no conversion surface is needed */
+    display->mustFreeBlitSurface = FALSE;
+    display->blitSurface = image->surface;
 
-        return TRUE;
-    }
+    return TRUE;
 }
 
 SDL_ILBM_Display *SDL_ILBM_createDisplay(const SDL_ILBM_Image *image, const int stretch)
 {
-    SDL_ILBM_Display *display = (SDL_ILBM_Display*)malloc(sizeof(SDL_ILBM_Image));
+    return SDL_ILBM_createScaledDisplay(image, stretch, 1);
+}
+
+SDL_ILBM_Display *SDL_ILBM_createScaledDisplay(const SDL_ILBM_Image *image, const int stretch, const unsigned int lowresPixelScaleFactor)
+{
+    SDL_ILBM_Arena *arena = image->arena;
+    SDL_ILBM_Display *display = NULL;
+
+    /* Keep the display close to the bookkeeping of its image, as long as its arena has room left */
+    if(arena != NULL)
+        display = (SDL_ILBM_Display*)SDL_ILBM_allocateFromArena(arena, sizeof(SDL_ILBM_Display));
+
+    if(display == NULL)
+    {
+        display = (SDL_ILBM_Display*)SDL_ILBM_malloc(sizeof(SDL_ILBM_Display));
+        arena = NULL;
+    }
 
     if(display != NULL)
     {
-        if(!SDL_ILBM_initDisplay(display, image, stretch))
+        if(!SDL_ILBM_initScaledDisplay(display, image, stretch, lowresPixelScaleFactor))
         {
+            display->arena = arena;
             SDL_ILBM_freeDisplay(display);
             return NULL;
         }
+
+        display->arena = arena;
     }
 
     return display;
@@ -95,7 +152,9 @@ void SDL_ILBM_freeDisplay(SDL_ILBM_Display *display)
     if(display != NULL)
     {
         SDL_ILBM_destroyDisplay(display);
-        free(display);
+
+        if(display->arena == NULL)
+            SDL_ILBM_free(display); /* Displays in an arena are freed along with their image */
     }
 }
 
@@ -109,25 +168,46 @@ int SDL_ILBM_renderSetLogicalSize(SDL_Renderer *renderer, const SDL_ILBM_Display
     return SDL_RenderSetLogicalSize(renderer, display->width, display->height);
 }
 
-SDL_Texture *SDL_ILBM_createTexture(SDL_Renderer *renderer, Uint32 format, int access, const SDL_ILBM_Display *display)
+static amiVideo_Bool textureFormatHasFastPath(const Uint32 format)
 {
-    return SDL_CreateTexture(renderer, format, access, display->blitSurface->w, display->blitSurface->h);
+    return (!SDL_ISPIXELFORMAT_FOURCC(format) && !SDL_ISPIXELFORMAT_INDEXED(format) && SDL_BYTESPERPIXEL(format) == 4);
 }
 
-amiVideo_Bool SDL_ILBM_blitDisplayToTexture(SDL_ILBM_Display *display, Uint32 format, void *pixels, int pitch)
+Uint32 SDL_ILBM_selectTextureFormat(SDL_Renderer *renderer, const SDL_ILBM_Display *display)
 {
-    if(display->mustFreeBlitSurface)
+    SDL_RendererInfo info;
+    Uint32 preferredFormat = SDL_PIXELFORMAT_UNKNOWN;
+
+    if(SDL_GetRendererInfo(renderer, &info) == 0)
     {
-        if(SDL_BlitSurface(display->image->surface, NULL, display->blitSurface, NULL) < 0) /* Convert the picture surface's format to the window surface format by blitting it */
-            return FALSE;
-    }
+        Uint32 i;
 
-    /* Transfer and convert the pixels to the texture */
+        /* The renderer lists its texture formats in the order of its preference */
+        for(i = 0; i < info.num_texture_formats; i++)
+        {
+            Uint32 format = info.texture_formats[i];
 
-    if(SDL_ConvertPixels(display->blitSurface->w, display->blitSurface->h, display->blitSurface->format->format, display->blitSurface->pixels, display->blitSurface->pitch, format, pixels, pitch) < 0)
-        return FALSE;
+            if(format == display->blitSurface->format->format)
+                return format; /* The rows of the surface can be copied to the texture as they are */
+            else if(preferredFormat == SDL_PIXELFORMAT_UNKNOWN && textureFormatHasFastPath(format))
+                preferredFormat = format;
+        }
+    }
+
+    if(preferredFormat == SDL_PIXELFORMAT_UNKNOWN)
+        return SDL_PIXELFORMAT_ARGB8888;
     else
-        return TRUE;
+        return preferredFormat;
+}
+
+SDL_Texture *SDL_ILBM_createTexture(SDL_Renderer *renderer, Uint32 format, int access, const SDL_ILBM_Display *display)
+{
+    return SDL_CreateTexture(renderer, format, access, display->blitSurface->w, display->blitSurface->h);
+}
+
+amiVideo_Bool SDL_ILBM_blitDisplayToTexture(SDL_ILBM_Display *display, Uint32 format, void *pixels, int pitch)
+{
+    return (SDL_ILBM_renderInto(display->image, pixels, pitch, format, NULL) == 0); /* Convert the picture surface's pixels directly into the texture's format */
 }
 
 int SDL_ILBM_renderCopy(SDL_Renderer *renderer, SDL_Texture *texture, int x, int y, const SDL_ILBM_Display *display)
@@ -135,8 +215,8 @@ int SDL_ILBM_renderCopy(SDL_Renderer *renderer, SDL_Texture *texture, int x, int
     SDL_Rect srcrect;
     srcrect.x = x;
     srcrect.y = y;
-    srcrect.w = display->width;
-    srcrect.h = display->height;
+    srcrect.w = display->width / display->scaleX; /* The renderer stretches the visible part of the texture to the dimensions of the display */
+    srcrect.h = display->height / display->scaleY;
 
     return SDL_RenderCopy(renderer, texture, &srcrect, NULL);
 }
@@ -47,11 +47,20 @@ struct SDL_ILBM_Display
     /** The height of the display (corresponds to the page height or the image height) */
     int height;
 
-    /** A surface used for converting the image to a 32-bit surface format so that it can blitted to a texture */
+    /** The surface of the image that is blitted to a texture, which determines the dimensions of the texture */
     SDL_Surface *blitSurface;
 
-    /** Indicates whether the blit surface must be freed while freeing the SDL_ILBM_Display struct */
+    /** Indicates whether the blit surface must be freed while freeing the SDL_ILBM_Display struct. The blit surface refers to the image's surface, so it is always FALSE */
     int mustFreeBlitSurface;
+
+    /** Factor by which the renderer stretches the texture horizontally to correct the aspect ratio. It is 1 if the image itself is corrected */
+    int scaleX;
+
+    /** Factor by which the renderer stretches the texture vertically to correct the aspect ratio. It is 1 if the image itself is corrected */
+    int scaleY;
+
+    /** Arena of the image from which the display has been allocated or NULL if it has been allocated separately */
+    SDL_ILBM_Arena *arena;
 };
 
 /**
@@ -65,7 +74,25 @@ struct SDL_ILBM_Display
 int SDL_ILBM_initDisplay(SDL_ILBM_Display *display, const SDL_ILBM_Image *image, const int stretch);
 
 /**
- * Creates a display window for displaying a provided image.
+ * Initializes a preallocated display with an uncorrected image to display, of
+ * which the aspect ratio is corrected by the renderer. The texture keeps the
+ * dimensions of the image, whereas the display has the corrected dimensions.
+ * If the image is already corrected, the display behaves the same as one
+ * initialized with SDL_ILBM_initDisplay().
+ *
+ * @param display Preallocated display struct
+ * @param image SDL_ILBM_Image to display in the window, preferably created with a lowres pixel scale factor of 1
+ * @param strech TRUE to indicate the display's dimensions should correspond to the image, FALSE to indicate the display's dimensions should correspond to the page
+ * @param lowresPixelScaleFactor Specifies the width of a lowres pixel on the display or 0 to pick it automatically
+ * @param return TRUE if the initialization succeeds, else FALSE
+ */
+int SDL_ILBM_initScaledDisplay(SDL_ILBM_Display *display, const SDL_ILBM_Image *image, const int stretch, const unsigned int lowresPixelScaleFactor);
+
+/**
+ * Creates a display window for displaying a provided image. If the image has
+ * been composed in arena mode, the display is allocated from the image's
+ * arena and becomes invalid once the image is freed. In that case, the display
+ * must be freed before the image.
  *
  * @param image SDL_ILBM_Image to display in the window
  * @param strech TRUE to indicate the display's dimensions should correspond to the image, FALSE to indicate the display's dimensions should correspond to the page
@@ -73,6 +100,18 @@ int SDL_ILBM_initDisplay(SDL_ILBM_Display *display, const SDL_ILBM_Image *image,
  */
 SDL_ILBM_Display *SDL_ILBM_createDisplay(const SDL_ILBM_Image *image, const int stretch);
 
+/**
+ * Creates a display window for displaying a provided uncorrected image, of which
+ * the aspect ratio is corrected by the renderer. Like SDL_ILBM_createDisplay(),
+ * the display must be freed before an image composed in arena mode.
+ *
+ * @param image SDL_ILBM_Image to display in the window, preferably created with a lowres pixel scale factor of 1
+ * @param strech TRUE to indicate the display's dimensions should correspond to the image, FALSE to indicate the display's dimensions should correspond to the page
+ * @param lowresPixelScaleFactor Specifies the width of a lowres pixel on the display or 0 to pick it automatically
+ * @return An SDL_ILBM_Display struct or NULL in case of an error. The result should be freed by invoking SDL_ILBM_freeDisplay()
+ */
+SDL_ILBM_Display *SDL_ILBM_createScaledDisplay(const SDL_ILBM_Image *image, const int stretch, const unsigned int lowresPixelScaleFactor);
+
 /**
  * Removes the display properties from memory
  *
@@ -81,7 +120,8 @@ SDL_ILBM_Display *SDL_ILBM_createDisplay(const SDL_ILBM_Image *image, const int
 void SDL_ILBM_destroyDisplay(SDL_ILBM_Display *display);
 
 /**
- * Frees a display from memory
+ * Frees a display from memory. A display allocated from an image's arena must
+ * be freed before its image.
  *
  * @param display An SDL_ILBM_Display instance
  */
@@ -110,6 +150,19 @@ SDL_Window *SDL_ILBM_createWindow(const char *title, int x, int y, const SDL_ILB
  */
 int SDL_ILBM_renderSetLogicalSize(SDL_Renderer *renderer, const SDL_ILBM_Display *display);
 
+/**
+ * Selects the texture format of the renderer into which an image can be
+ * converted the cheapest. A format identical to the image's surface is picked
+ * first, so that the image can be copied to the texture as it is. Otherwise,
+ * the 32-bit format most preferred by the renderer is picked, so that the
+ * driver does not have to convert the pixels again while uploading them.
+ *
+ * @param renderer An SDL_Renderer instance
+ * @param display An SDL_ILBM_Display instance
+ * @return One of the enumerated SDL texture formats
+ */
+Uint32 SDL_ILBM_selectTextureFormat(SDL_Renderer *renderer, const SDL_ILBM_Display *display);
+
 /**
  * Construct a texture that can be used for hardware rendering from a display.
  * This function is basically a wrapper around SDL's SDL_CreateTexture()
@@ -134,13 +187,14 @@ amiVideo_Bool SDL_ILBM_blitDisplayToTexture(SDL_ILBM_Display *display, Uint32 fo
 
 /**
  * Renders the texture to a window while taking the window's dimensions and the
- * viewer's offset into account clipping where necessary. This function is
- * basically a wrapper around SDL's SDL_RenderCopy()
+ * viewer's offset into account clipping where necessary. For displays that are
+ * scaled by the renderer, the texture is stretched to correct the aspect ratio.
+ * This function is basically a wrapper around SDL's SDL_RenderCopy()
  *
  * @param renderer An SDL_Renderer instance
  * @param texture SDL texture to render
- * @param x The x offset of the viewer
- * @param y The y offset of the viewer
+ * @param x The x offset of the viewer in texture pixels
+ * @param y The y offset of the viewer in texture pixels
  * @param display An SDL_ILBM_Display instance
  * @return 0 in case of success, or a value below zero if an error occurs
  */
@@ -24,10 +24,16 @@
 
 #include "image.h"
 #include <stdlib.h>
+#include <string.h>
 #include <libamivideo/viewportmode.h>
 #include "image2amivideo.h"
 #include "amivideo2surface.h"
 #include "render.h"
+#include "scanline.h"
+#include "c2p.h"
+#include "display.h"
+#include "cyclegroup.h"
+#include "rangestate.h"
 
 /* Choose appropriate lowres pixel scale factor */
 
@@ -39,40 +45,158 @@ static int selectLowresPixelScaleFactor(const unsigned int lowresPixelScaleFacto
         return amiVideo_autoSelectLowresPixelScaleFactor(viewportMode);
 }
 
+/* Relative costs per pixel of the work that must be done for a cyclable image, used to pick its cheapest representation */
+
+#define DISPLAY_PIXEL_COST 1 /* Blitting or uploading a true color pixel to the display */
+#define EXPAND_PIXEL_COST 2 /* Looking up a chunky pixel in the palette while blitting it to a true color display */
+#define BITPLANE_PIXEL_COST 1 /* Decoding a single bitplane of a pixel while re-rendering an RGB surface */
+#define LOOKUP_PIXEL_COST 2 /* Looking up the color of a pixel while re-rendering an RGB surface */
+#define FRAMES_PER_SECOND 60 /* Cycling images are presented every frame */
+
+static Uint64 computeSurfacePixels(const ILBM_Image *image, const amiVideo_Screen *screen, const unsigned int lowresPixelScaleFactor)
+{
+    if(lowresPixelScaleFactor > 1)
+        return (Uint64)amiVideo_calculateCorrectedWidth(lowresPixelScaleFactor, image->bitMapHeader->w, screen->viewportMode) * amiVideo_calculateCorrectedHeight(lowresPixelScaleFactor, image->bitMapHeader->h, screen->viewportMode);
+    else
+        return (Uint64)image->bitMapHeader->w * image->bitMapHeader->h;
+}
+
+static Uint64 estimateChunkyCost(const amiVideo_Screen *screen, const Uint64 pixels, const Uint32 changesPerSecond)
+{
+    /* A change only pushes the palette, but the display path has to expand all pixels to true color before presenting them every frame */
+    return FRAMES_PER_SECOND * pixels * (EXPAND_PIXEL_COST + DISPLAY_PIXEL_COST) + (Uint64)changesPerSecond * screen->palette.chunkyFormat.numOfColors;
+}
+
+static Uint64 estimateRGBCost(const ILBM_Image *image, const amiVideo_Screen *screen, const Uint64 pixels, const Uint32 changesPerSecond)
+{
+    /* The surface is presented as it is every frame, but every change re-renders all pixels */
+    Uint64 pixelCost = LOOKUP_PIXEL_COST;
+
+    if(!ILBM_imageIsPBM(image))
+        pixelCost += screen->bitplaneDepth * BITPLANE_PIXEL_COST;
+
+    return FRAMES_PER_SECOND * pixels * DISPLAY_PIXEL_COST + (Uint64)changesPerSecond * pixels * pixelCost;
+}
+
+static SDL_atomic_t indexedResidency;
+
+void SDL_ILBM_setIndexedResidency(const amiVideo_Bool enabled)
+{
+    SDL_AtomicSet(&indexedResidency, enabled);
+}
+
+amiVideo_Bool SDL_ILBM_getIndexedResidency(void)
+{
+    return SDL_AtomicGet(&indexedResidency);
+}
+
 /* Choose appropriate color format */
 
-static amiVideo_ColorFormat selectColorFormat(const SDL_ILBM_Format format, const amiVideo_Screen *screen)
+static amiVideo_ColorFormat selectColorFormat(const SDL_ILBM_Format format, const ILBM_Image *image, const amiVideo_Screen *screen, const unsigned int lowresPixelScaleFactor, const amiVideo_Bool indexed, const amiVideo_Bool cycled)
 {
-    if(format == SDL_ILBM_AUTO_FORMAT)
+    if(indexed && amiVideo_autoSelectColorFormat(screen) == AMIVIDEO_CHUNKY_FORMAT)
+        return AMIVIDEO_CHUNKY_FORMAT; /* Keep only the indices and the palette, which are expanded to true color while blitting */
+    else if(format == SDL_ILBM_AUTO_FORMAT)
         return amiVideo_autoSelectColorFormat(screen);
+    else if(format == SDL_ILBM_CHEAPEST_FORMAT)
+    {
+        amiVideo_ColorFormat colorFormat = amiVideo_autoSelectColorFormat(screen);
+
+        /* Images that can be represented as chunky pixels may still be cheaper to cycle as RGB surfaces if their ranges change slowly. One-shot surfaces are never cycled, so they stay in the most memory efficient format */
+        if(cycled && colorFormat == AMIVIDEO_CHUNKY_FORMAT)
+        {
+            Uint32 changesPerSecond = SDL_ILBM_computeRangeStepsPerSecond(image);
+
+            if(changesPerSecond > 0)
+            {
+                Uint64 pixels = computeSurfacePixels(image, screen, lowresPixelScaleFactor);
+
+                if(changesPerSecond > FRAMES_PER_SECOND)
+                    changesPerSecond = FRAMES_PER_SECOND; /* Changes within the same frame are displayed at once */
+
+                if(estimateRGBCost(image, screen, pixels, changesPerSecond) < estimateChunkyCost(screen, pixels, changesPerSecond))
+                    return AMIVIDEO_RGB_FORMAT;
+            }
+        }
+
+        return colorFormat;
+    }
     else
         return format;
 }
 
-static SDL_Surface *createSurfaceFromScreen(amiVideo_Screen *screen, ILBM_Image *image, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format)
+/* Choose the strategy to update the image each time a color cycles */
+
+static SDL_ILBM_Strategy selectStrategy(const ILBM_Image *image, const SDL_ILBM_Format format)
+{
+    if(SDL_ILBM_computeRangeStepsPerSecond(image) == 0)
+        return SDL_ILBM_STATIC_STRATEGY;
+    else if(format == SDL_ILBM_CHUNKY_FORMAT)
+        return SDL_ILBM_PALETTE_STRATEGY;
+    else
+        return SDL_ILBM_RERENDER_STRATEGY;
+}
+
+/* Checks whether the surface can be rendered directly from the body, one scanline at a time */
+
+static amiVideo_Bool scanlinesCanBeRendered(const ILBM_Image *image, const amiVideo_Screen *screen, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format)
+{
+    if(lowresPixelScaleFactor > 1 || !SDL_ILBM_scanlinesCanBeRendered(image, screen, (amiVideo_ColorFormat)format))
+        return FALSE;
+    else if(format == SDL_ILBM_CHUNKY_FORMAT)
+        return TRUE;
+    else
+        return (SDL_ILBM_computeRangeStepsPerSecond(image) == 0); /* Cycling RGB surfaces are re-rendered from the bitplanes, so these must be attached */
+}
+
+static SDL_Surface *createSurfaceFromScreen(amiVideo_Screen *screen, ILBM_Image *image, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format, const amiVideo_Bool shareBody, SDL_ILBM_BufferPool *bufferPool, const amiVideo_Bool indexed, const amiVideo_Bool cycled)
 {
     unsigned int realLowresPixelScaleFactor;
     SDL_ILBM_Format realFormat;
     SDL_Surface *surface;
 
-    /* Attach the image to screen conversion pipeline */
-    SDL_ILBM_attachImageToScreen(image, screen);
+    /* Initialize the screen conversion pipeline with the image's properties */
+    SDL_ILBM_initScreenFromImage(image, screen);
 
     /* Calculate real values */
     realLowresPixelScaleFactor = selectLowresPixelScaleFactor(lowresPixelScaleFactor, screen->viewportMode);
-    realFormat = selectColorFormat(format, screen);
+    realFormat = selectColorFormat(format, image, screen, realLowresPixelScaleFactor, indexed, cycled);
 
     /* Create and render the surface */
+    if(scanlinesCanBeRendered(image, screen, realLowresPixelScaleFactor, realFormat))
+    {
+        /* Decompress and convert the body row by row, without unpacking and deinterleaving the entire body first */
+        if(realFormat == SDL_ILBM_CHUNKY_FORMAT)
+        {
+            surface = SDL_ILBM_createUncorrectedChunkySurfaceFromScreenWithPool(screen, bufferPool);
+
+            if(surface != NULL)
+                SDL_ILBM_renderScanlinesToChunkySurface(image, surface);
+        }
+        else
+        {
+            surface = SDL_ILBM_createUncorrectedRGBSurfaceFromScreenWithPool(screen, image, bufferPool);
+
+            if(surface != NULL)
+                SDL_ILBM_renderScanlinesToRGBSurface(image, screen, surface);
+        }
+
+        return surface;
+    }
+
+    /* Attach the pixels of the image to the screen conversion pipeline */
+    SDL_ILBM_attachPixelsToScreen(image, screen);
+
     if(realLowresPixelScaleFactor > 1)
     {
         if(realFormat == SDL_ILBM_CHUNKY_FORMAT)
         {
-            surface = SDL_ILBM_createCorrectedChunkySurfaceFromScreen(screen, image, realLowresPixelScaleFactor);
+            surface = SDL_ILBM_createCorrectedChunkySurfaceFromScreenWithPool(screen, image, realLowresPixelScaleFactor, bufferPool);
             SDL_ILBM_renderCorrectedChunkyImage(image, screen, surface);
         }
         else
         {
-            surface = SDL_ILBM_createCorrectedRGBSurfaceFromScreen(screen, image, realLowresPixelScaleFactor);
+            surface = SDL_ILBM_createCorrectedRGBSurfaceFromScreenWithPool(screen, image, realLowresPixelScaleFactor, bufferPool);
             SDL_ILBM_renderCorrectedRGBImage(image, screen, surface);
         }
     }
@@ -80,12 +204,16 @@ static SDL_Surface *createSurfaceFromScreen(amiVideo_Screen *screen, ILBM_Image
     {
         if(realFormat == SDL_ILBM_CHUNKY_FORMAT)
         {
-            surface = SDL_ILBM_createUncorrectedChunkySurfaceFromScreen(screen);
+            /* The decoded body of a PBM already consists of chunky pixels => wrap a surface around it, if it may refer to the body */
+            if(shareBody && ILBM_imageIsPBM(image) && (surface = SDL_ILBM_createUncorrectedChunkySurfaceFromBody(screen, image)) != NULL)
+                return surface;
+
+            surface = SDL_ILBM_createUncorrectedChunkySurfaceFromScreenWithPool(screen, bufferPool);
             SDL_ILBM_renderUncorrectedChunkyImage(image, screen, surface);
         }
         else
         {
-            surface = SDL_ILBM_createUncorrectedRGBSurfaceFromScreen(screen, image);
+            surface = SDL_ILBM_createUncorrectedRGBSurfaceFromScreenWithPool(screen, image, bufferPool);
             SDL_ILBM_renderUncorrectedRGBImage(image, screen, surface);
         }
     }
@@ -96,29 +224,208 @@ static SDL_Surface *createSurfaceFromScreen(amiVideo_Screen *screen, ILBM_Image
 SDL_Surface *SDL_ILBM_createSurface(ILBM_Image *image, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format)
 {
     amiVideo_Screen screen;
-    return createSurfaceFromScreen(&screen, image, lowresPixelScaleFactor, format);
+    return createSurfaceFromScreen(&screen, image, lowresPixelScaleFactor, format, FALSE, NULL, FALSE, FALSE); /* The caller owns the surface, which may outlive the image, in the requested format */
 }
 
-static int updateChunkyPalette(const ILBM_Image *image, amiVideo_Screen *screen, SDL_Surface *surface)
+SDL_ILBM_Format SDL_ILBM_computeSurfaceDimensions(const ILBM_Image *image, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format, int *width, int *height)
 {
-    amiVideo_convertBitplaneColorsToChunkyFormat(&screen->palette);
-    return SDL_ILBM_setSurfacePaletteFromScreenPalette(&screen->palette, surface);
+    amiVideo_Screen screen;
+    unsigned int realLowresPixelScaleFactor;
+    SDL_ILBM_Format realFormat;
+
+    /* Only the properties of the image are needed to make the same choices as composing it */
+    SDL_ILBM_initScreenFromImage(image, &screen);
+
+    realLowresPixelScaleFactor = selectLowresPixelScaleFactor(lowresPixelScaleFactor, screen.viewportMode);
+    realFormat = (SDL_ILBM_Format)selectColorFormat(format, image, &screen, realLowresPixelScaleFactor, SDL_ILBM_getIndexedResidency(), TRUE);
+
+    if(realLowresPixelScaleFactor > 1)
+    {
+        *width = amiVideo_calculateCorrectedWidth(realLowresPixelScaleFactor, image->bitMapHeader->w, screen.viewportMode);
+        *height = amiVideo_calculateCorrectedHeight(realLowresPixelScaleFactor, image->bitMapHeader->h, screen.viewportMode);
+    }
+    else
+    {
+        *width = image->bitMapHeader->w;
+        *height = image->bitMapHeader->h;
+    }
+
+    amiVideo_cleanupScreen(&screen);
+
+    return realFormat;
 }
 
-amiVideo_Bool SDL_ILBM_initImage(SDL_ILBM_Image *image, ILBM_Image *ilbmImage, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format)
+amiVideo_Bool SDL_ILBM_composingUnpacksBody(const ILBM_Image *image, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format)
+{
+    amiVideo_Screen screen;
+    unsigned int realLowresPixelScaleFactor;
+    SDL_ILBM_Format realFormat;
+    amiVideo_Bool unpacksBody;
+
+    if(image->bitMapHeader->compression != ILBM_CMP_BYTE_RUN)
+        return FALSE;
+
+    SDL_ILBM_initScreenFromImage(image, &screen);
+
+    realLowresPixelScaleFactor = selectLowresPixelScaleFactor(lowresPixelScaleFactor, screen.viewportMode);
+    realFormat = (SDL_ILBM_Format)selectColorFormat(format, image, &screen, realLowresPixelScaleFactor, SDL_ILBM_getIndexedResidency(), TRUE);
+    unpacksBody = !scanlinesCanBeRendered(image, &screen, realLowresPixelScaleFactor, realFormat);
+
+    amiVideo_cleanupScreen(&screen);
+
+    return unpacksBody;
+}
+
+static int pushChunkyPalette(SDL_ILBM_Image *image, const unsigned int first, const unsigned int count)
+{
+    amiVideo_Palette *palette = &image->screen.palette;
+
+    if(palette->chunkyFormat.numOfColors > palette->bitplaneFormat.numOfColors)
+        return SDL_ILBM_setSurfacePaletteFromScreenPalette(palette, image->surface); /* Derived colors, such as extra halfbrites, do not follow the span of the bitplane colors */
+    else
+        return SDL_ILBM_setSurfacePaletteRangeFromScreenPalette(palette, image->surface, first, count); /* Only push the colors that have changed */
+}
+
+static int updateChunkyPalette(SDL_ILBM_Image *image, const unsigned int first, const unsigned int count)
+{
+    amiVideo_convertBitplaneColorsToChunkyFormat(&image->screen.palette);
+    return pushChunkyPalette(image, first, count);
+}
+
+static int updateUncorrectedRGBSurface(SDL_ILBM_Image *image, const unsigned int first, const unsigned int count)
+{
+    return SDL_ILBM_renderUncorrectedRGBImage(image->image, &image->screen, image->surface);
+}
+
+static int updateCorrectedRGBSurface(SDL_ILBM_Image *image, const unsigned int first, const unsigned int count)
+{
+    return SDL_ILBM_renderCorrectedRGBImage(image->image, &image->screen, image->surface);
+}
+
+static void copyFrameToSurface(SDL_Surface *surface, const void *pixels, const size_t frameSize)
 {
+    if(SDL_MUSTLOCK(surface) && SDL_LockSurface(surface) != 0)
+        return;
+
+    memcpy(surface->pixels, pixels, frameSize);
+
+    if(SDL_MUSTLOCK(surface))
+        SDL_UnlockSurface(surface);
+}
+
+static amiVideo_Bool storeFrameFromSurface(SDL_ILBM_PaletteCache *paletteCache, SDL_ILBM_CachedPalette *cachedPalette, SDL_Surface *surface)
+{
+    amiVideo_Bool status;
+
+    if(SDL_MUSTLOCK(surface) && SDL_LockSurface(surface) != 0)
+        return FALSE;
+
+    status = SDL_ILBM_storePaletteCacheFrame(paletteCache, cachedPalette, surface->pixels);
+
+    if(SDL_MUSTLOCK(surface))
+        SDL_UnlockSurface(surface);
+
+    return status;
+}
+
+/* Stores the palette of the current range state, and the rendered frame if the budget permits it */
+
+static amiVideo_Bool cacheCurrentPalette(SDL_ILBM_Image *image)
+{
+    SDL_ILBM_PaletteCache *paletteCache = image->paletteCache;
+    amiVideo_Palette *palette = &image->screen.palette;
+    SDL_ILBM_CachedPalette *cachedPalette;
+
+    SDL_ILBM_getRangeOffsets(&image->rangeTimes, image->image, paletteCache->currentOffsets);
+    cachedPalette = SDL_ILBM_insertPaletteCache(paletteCache, paletteCache->currentOffsets, palette->bitplaneFormat.color, palette->chunkyFormat.color);
+
+    if(cachedPalette == NULL)
+        return FALSE;
+
+    if(image->format != SDL_ILBM_CHUNKY_FORMAT)
+        storeFrameFromSurface(paletteCache, cachedPalette, image->surface);
+
+    return TRUE;
+}
+
+static amiVideo_Bool updateColorsFromPaletteCache(SDL_ILBM_Image *image, amiVideo_Bool *changed, unsigned int *first, unsigned int *count)
+{
+    SDL_ILBM_PaletteCache *paletteCache = image->paletteCache;
+    SDL_ILBM_CachedPalette *cachedPalette;
+
+    SDL_ILBM_getRangeOffsets(&image->rangeTimes, image->image, paletteCache->currentOffsets);
+    cachedPalette = SDL_ILBM_lookupPaletteCache(paletteCache, paletteCache->currentOffsets);
+
+    if(cachedPalette == NULL)
+        return FALSE; /* Unknown state => the palette must be materialized */
+
+    /* The palette of this state is known, so there is no need to materialize or convert it */
+    *changed = SDL_ILBM_takeDirtySpan(&image->rangeTimes, first, count);
+
+    if(*changed)
+    {
+        amiVideo_Palette *palette = &image->screen.palette;
+
+        memcpy(palette->bitplaneFormat.color, cachedPalette->bitplaneColors, paletteCache->bitplaneColorsSize);
+
+        if(cachedPalette->chunkyColors != NULL)
+        {
+            memcpy(palette->chunkyFormat.color, cachedPalette->chunkyColors, paletteCache->chunkyColorsSize);
+            pushChunkyPalette(image, *first, *count);
+        }
+        else if(cachedPalette->pixels != NULL)
+            copyFrameToSurface(image->surface, cachedPalette->pixels, paletteCache->frameSize);
+        else
+            image->updatePaletteAndSurface(image, *first, *count);
+    }
+
+    return TRUE;
+}
+
+static amiVideo_Bool updateColors(SDL_ILBM_Image *image, unsigned int *first, unsigned int *count)
+{
+    amiVideo_Bool changed;
+
+    if(image->paletteCache != NULL && updateColorsFromPaletteCache(image, &changed, first, count))
+        return changed;
+
+    if(SDL_ILBM_materializeRanges(&image->rangeTimes, image->image, &image->screen.palette, first, count))
+    {
+        image->updatePaletteAndSurface(image, *first, *count);
+
+        /* Remember states that have been missed while precomputing, as long as there is room for them */
+        if(image->paletteCache != NULL)
+            cacheCurrentPalette(image);
+
+        return TRUE;
+    }
+    else
+        return FALSE;
+}
+
+static amiVideo_Bool initImage(SDL_ILBM_Image *image, ILBM_Image *ilbmImage, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format, SDL_ILBM_Arena *arena)
+{
+    amiVideo_Bool indexed, rangeTimesInitialized;
+
     /* Attach some properties to the facade */
     image->image = ilbmImage;
-
-    /* Initialise the range times */
-    SDL_ILBM_initRangeTimes(&image->rangeTimes, image->image);
+    image->paletteCache = NULL;
+    image->bufferPool = SDL_ILBM_getBufferPool();
+    image->arena = arena;
+    image->compacted = FALSE;
+    image->cycleGroup = NULL;
+    indexed = SDL_ILBM_getIndexedResidency();
 
     /* Create and initially render the surface */
-    image->surface = createSurfaceFromScreen(&image->screen, image->image, lowresPixelScaleFactor, format);
+    image->surface = createSurfaceFromScreen(&image->screen, image->image, lowresPixelScaleFactor, format, TRUE, image->bufferPool, indexed, TRUE);
+
+    /* Initialise the range times from the initial palette */
+    rangeTimesInitialized = SDL_ILBM_initRangeTimesInArena(&image->rangeTimes, image->image, &image->screen.palette, arena);
 
     /* Memorize real values. TODO: duplicate, maybe somewhere else? */
-    image->format = selectColorFormat(format, &image->screen);
     image->lowresPixelScaleFactor = selectLowresPixelScaleFactor(lowresPixelScaleFactor, image->screen.viewportMode);
+    image->format = selectColorFormat(format, image->image, &image->screen, image->lowresPixelScaleFactor, indexed, TRUE);
+    image->strategy = selectStrategy(image->image, image->format);
 
     /* Pick palette update function */
     if(image->format == SDL_ILBM_CHUNKY_FORMAT)
@@ -127,21 +434,51 @@ amiVideo_Bool SDL_ILBM_initImage(SDL_ILBM_Image *image, ILBM_Image *ilbmImage, c
     {
         /* In addition to palette changes, RGB surfaces needs to be redrawn entirely */
         if(image->lowresPixelScaleFactor > 1)
-            image->updatePaletteAndSurface = SDL_ILBM_renderCorrectedRGBImage;
+            image->updatePaletteAndSurface = updateCorrectedRGBSurface;
         else
-            image->updatePaletteAndSurface = SDL_ILBM_renderUncorrectedRGBImage;
+            image->updatePaletteAndSurface = updateUncorrectedRGBSurface;
     }
 
-    return (image->surface != NULL);
+    return (image->surface != NULL && rangeTimesInitialized);
+}
+
+amiVideo_Bool SDL_ILBM_initImage(SDL_ILBM_Image *image, ILBM_Image *ilbmImage, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format)
+{
+    return initImage(image, ilbmImage, lowresPixelScaleFactor, format, NULL);
+}
+
+/* Estimates the size of an arena that fits an image, its range times and a display */
+
+static size_t computeArenaSize(const ILBM_Image *ilbmImage)
+{
+    unsigned int numOfColors = 1 << (ilbmImage->bitMapHeader->nPlanes > 8 ? 8 : ilbmImage->bitMapHeader->nPlanes);
+
+    if(ilbmImage->colorMap != NULL && ilbmImage->colorMap->colorRegisterLength > numOfColors)
+        numOfColors = ilbmImage->colorMap->colorRegisterLength;
+
+    return SDL_ILBM_computeArenaObjectSize(sizeof(SDL_ILBM_Image))
+        + SDL_ILBM_computeArenaObjectSize(SDL_ILBM_computeRangeTimesSize(ilbmImage, numOfColors))
+        + SDL_ILBM_computeArenaObjectSize(sizeof(SDL_ILBM_Display));
 }
 
 SDL_ILBM_Image *SDL_ILBM_createImage(ILBM_Image *ilbmImage, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format)
 {
-    SDL_ILBM_Image *image = (SDL_ILBM_Image*)malloc(sizeof(SDL_ILBM_Image));
+    SDL_ILBM_Arena *arena = NULL;
+    SDL_ILBM_Image *image;
+
+    if(SDL_ILBM_getArenaMode())
+    {
+        if((arena = SDL_ILBM_createArena(computeArenaSize(ilbmImage))) == NULL)
+            return NULL;
+
+        image = (SDL_ILBM_Image*)SDL_ILBM_allocateFromArena(arena, sizeof(SDL_ILBM_Image));
+    }
+    else
+        image = (SDL_ILBM_Image*)SDL_ILBM_malloc(sizeof(SDL_ILBM_Image));
 
     if(image != NULL)
     {
-        if(!SDL_ILBM_initImage(image, ilbmImage, lowresPixelScaleFactor, format))
+        if(!initImage(image, ilbmImage, lowresPixelScaleFactor, format, arena))
         {
             SDL_ILBM_freeImage(image);
             return NULL;
@@ -156,9 +493,151 @@ int SDL_ILBM_blitImageToSurface(SDL_ILBM_Image *image, const SDL_Rect *srcrect,
     return SDL_BlitSurface(image->surface, srcrect, dst, dstrect);
 }
 
+static amiVideo_Bool rectIsInsideSurface(const SDL_Surface *surface, const SDL_Rect *rect)
+{
+    return (rect->x >= 0 && rect->y >= 0 && rect->w >= 0 && rect->h >= 0 && rect->x + rect->w <= surface->w && rect->y + rect->h <= surface->h);
+}
+
+static void copyRowsInto(const SDL_Surface *surface, const SDL_Rect *rect, amiVideo_UByte *pixels, const int pitch)
+{
+    unsigned int rowSize = rect->w * surface->format->BytesPerPixel;
+    const amiVideo_UByte *surfacePixels = (const amiVideo_UByte*)surface->pixels + rect->y * surface->pitch + rect->x * surface->format->BytesPerPixel;
+    int y;
+
+    for(y = 0; y < rect->h; y++)
+        memcpy(pixels + y * pitch, surfacePixels + y * surface->pitch, rowSize);
+}
+
+/* Converts chunky pixels to a 32-bit pixel format by mapping the colors of the surface's palette to that format in advance */
+
+static int renderChunkyRowsInto32BitPixels(const SDL_Surface *surface, const SDL_Rect *rect, const Uint32 pixelFormat, amiVideo_UByte *pixels, const int pitch)
+{
+    SDL_PixelFormat *format = SDL_AllocFormat(pixelFormat);
+
+    if(format == NULL)
+        return -1;
+    else
+    {
+        Uint32 colors[SDL_ILBM_MAX_NUM_OF_C2P_COLORS];
+        const SDL_Palette *palette = surface->format->palette;
+        const amiVideo_UByte *surfacePixels = (const amiVideo_UByte*)surface->pixels + rect->y * surface->pitch + rect->x;
+        int i, y;
+
+        memset(colors, '\0', sizeof(colors));
+
+        for(i = 0; i < palette->ncolors && i < SDL_ILBM_MAX_NUM_OF_C2P_COLORS; i++)
+            colors[i] = SDL_MapRGB(format, palette->colors[i].r, palette->colors[i].g, palette->colors[i].b);
+
+        for(y = 0; y < rect->h; y++)
+            SDL_ILBM_convertChunkyRowToRGB(surfacePixels + y * surface->pitch, colors, rect->w, (Uint32*)(pixels + y * pitch));
+
+        SDL_FreeFormat(format);
+        return 0;
+    }
+}
+
+/* Converts chunky pixels to a 32-bit format first and lets SDL convert them to formats, such as YUV formats, that cannot be blitted to */
+
+static int renderChunkyRowsIntoFourCCPixels(const SDL_Surface *surface, const SDL_Rect *rect, const Uint32 pixelFormat, void *pixels, const int pitch)
+{
+    int status, rgbPitch = rect->w * sizeof(Uint32);
+    amiVideo_UByte *rgbPixels = (amiVideo_UByte*)SDL_ILBM_malloc(rgbPitch * rect->h);
+
+    if(rgbPixels == NULL)
+        return SDL_OutOfMemory();
+
+    status = renderChunkyRowsInto32BitPixels(surface, rect, SDL_PIXELFORMAT_ARGB8888, rgbPixels, rgbPitch);
+
+    if(status == 0)
+        status = SDL_ConvertPixels(rect->w, rect->h, SDL_PIXELFORMAT_ARGB8888, rgbPixels, rgbPitch, pixelFormat, pixels, pitch);
+
+    SDL_ILBM_free(rgbPixels);
+    return status;
+}
+
+/* Blits chunky pixels to the caller's memory, which is wrapped by a surface that refers to it */
+
+static int blitChunkyRowsInto(SDL_Surface *surface, const SDL_Rect *rect, const Uint32 pixelFormat, void *pixels, const int pitch)
+{
+    int bpp, status;
+    Uint32 Rmask, Gmask, Bmask, Amask;
+    SDL_Surface *target;
+    SDL_Rect srcrect = *rect;
+
+    if(!SDL_PixelFormatEnumToMasks(pixelFormat, &bpp, &Rmask, &Gmask, &Bmask, &Amask))
+        return -1;
+
+    target = SDL_CreateRGBSurfaceFrom(pixels, rect->w, rect->h, bpp, pitch, Rmask, Gmask, Bmask, Amask);
+
+    if(target == NULL)
+        return -1;
+
+    status = SDL_BlitSurface(surface, &srcrect, target, NULL);
+    SDL_FreeSurface(target);
+    return status;
+}
+
+static int renderSurfaceInto(SDL_Surface *surface, const SDL_Rect *rect, void *pixels, const int pitch, const Uint32 pixelFormat)
+{
+    if(surface->format->format == pixelFormat)
+    {
+        copyRowsInto(surface, rect, (amiVideo_UByte*)pixels, pitch); /* Identical formats => copy the rows */
+        return 0;
+    }
+    else if(surface->format->palette != NULL)
+    {
+        if(SDL_ISPIXELFORMAT_FOURCC(pixelFormat))
+            return renderChunkyRowsIntoFourCCPixels(surface, rect, pixelFormat, pixels, pitch);
+        else if(SDL_BYTESPERPIXEL(pixelFormat) == 4 && !SDL_ISPIXELFORMAT_INDEXED(pixelFormat))
+            return renderChunkyRowsInto32BitPixels(surface, rect, pixelFormat, (amiVideo_UByte*)pixels, pitch); /* Common 32-bit layouts => look up each pixel's color */
+        else
+            return blitChunkyRowsInto(surface, rect, pixelFormat, pixels, pitch);
+    }
+    else
+    {
+        /* Let SDL swizzle the channels of the RGB pixels */
+        const amiVideo_UByte *surfacePixels = (const amiVideo_UByte*)surface->pixels + rect->y * surface->pitch + rect->x * surface->format->BytesPerPixel;
+        return SDL_ConvertPixels(rect->w, rect->h, surface->format->format, surfacePixels, surface->pitch, pixelFormat, pixels, pitch);
+    }
+}
+
+int SDL_ILBM_renderInto(const SDL_ILBM_Image *image, void *pixels, int pitch, Uint32 pixelFormat, const SDL_Rect *rect)
+{
+    SDL_Surface *surface = image->surface;
+    SDL_Rect area;
+    int status;
+
+    if(rect == NULL)
+    {
+        area.x = 0;
+        area.y = 0;
+        area.w = surface->w;
+        area.h = surface->h;
+    }
+    else if(rectIsInsideSurface(surface, rect))
+        area = *rect;
+    else
+        return SDL_SetError("The rectangle exceeds the dimensions of the image");
+
+    if(SDL_MUSTLOCK(surface) && SDL_LockSurface(surface) != 0)
+        return -1;
+
+    status = renderSurfaceInto(surface, &area, pixels, pitch, pixelFormat);
+
+    if(SDL_MUSTLOCK(surface))
+        SDL_UnlockSurface(surface);
+
+    return status;
+}
+
 void SDL_ILBM_destroyImage(SDL_ILBM_Image *image)
 {
-    SDL_FreeSurface(image->surface);
+    if(image->cycleGroup != NULL)
+        SDL_ILBM_removeImageFromCycleGroup(image->cycleGroup, image); /* Do not leave a dangling reference behind in the group */
+
+    SDL_ILBM_freePaletteCache(image->paletteCache);
+    SDL_ILBM_returnSurface(image->bufferPool, image->surface);
+    SDL_ILBM_returnUncorrectedMemoryToPool(&image->screen, image->bufferPool);
     amiVideo_cleanupScreen(&image->screen);
     SDL_ILBM_cleanupRangeTimes(&image->rangeTimes);
 }
@@ -167,19 +646,229 @@ void SDL_ILBM_freeImage(SDL_ILBM_Image *image)
 {
     if(image != NULL)
     {
+        SDL_ILBM_Arena *arena = image->arena;
+
         SDL_ILBM_destroyImage(image);
-        free(image);
+
+        if(arena == NULL)
+            SDL_ILBM_free(image);
+        else
+            SDL_ILBM_freeArena(arena); /* The image resides in its arena */
     }
 }
 
+void SDL_ILBM_redirectImage(SDL_ILBM_Image *image, SDL_Surface *surface)
+{
+    /* The conversion screen writes the RGB pixels straight into the surface */
+    if(image->lowresPixelScaleFactor > 1)
+    {
+        image->screen.correctedFormat.pixels = (amiVideo_UByte*)surface->pixels;
+        image->screen.correctedFormat.pitch = surface->pitch;
+    }
+    else
+    {
+        image->screen.uncorrectedRGBFormat.pixels = (amiVideo_ULong*)surface->pixels;
+        image->screen.uncorrectedRGBFormat.pitch = surface->pitch;
+    }
+
+    image->surface = surface;
+}
+
 void SDL_ILBM_cycleColors(SDL_ILBM_Image *image)
 {
-    SDL_ILBM_shiftActiveRanges(&image->rangeTimes, image->image, &image->screen.palette);
-    image->updatePaletteAndSurface(image->image, &image->screen, image->surface);
+    unsigned int first, count;
+    SDL_ILBM_cycleColorsAt(image, SDL_GetTicks(), &first, &count);
+}
+
+amiVideo_Bool SDL_ILBM_cycleColorsAt(SDL_ILBM_Image *image, const Uint32 ticks, unsigned int *first, unsigned int *count)
+{
+    if(image->compacted)
+        return FALSE; /* A compacted image has no ranges to advance */
+
+    /* Advancing the ranges only updates their offsets. The palette and surface are only updated if something has changed */
+    if(SDL_ILBM_shiftActiveRangesAt(&image->rangeTimes, image->image, ticks))
+        return updateColors(image, first, count);
+    else
+        return FALSE;
+}
+
+void SDL_ILBM_copyColors(SDL_ILBM_Image *image, const SDL_ILBM_Image *sourceImage, const unsigned int first, const unsigned int count)
+{
+    memcpy(image->screen.palette.bitplaneFormat.color, sourceImage->screen.palette.bitplaneFormat.color, image->rangeTimes.baseColorsLength * sizeof(amiVideo_Color));
+    image->updatePaletteAndSurface(image, first, count);
+}
+
+void SDL_ILBM_seekColors(SDL_ILBM_Image *image, const Uint32 time)
+{
+    unsigned int first, count;
+
+    if(image->compacted)
+        return;
+
+    SDL_ILBM_seekRanges(&image->rangeTimes, image->image, time);
+    updateColors(image, &first, &count);
 }
 
 void SDL_ILBM_resetColors(SDL_ILBM_Image *image)
 {
-    SDL_ILBM_initPaletteFromImage(image->image, &image->screen.palette);
-    image->updatePaletteAndSurface(image->image, &image->screen, image->surface);
+    unsigned int first, count;
+
+    if(image->compacted)
+    {
+        /* The colors of a static image never shift, so pushing the palette again suffices */
+        image->updatePaletteAndSurface(image, 0, image->screen.palette.bitplaneFormat.numOfColors);
+        return;
+    }
+
+    SDL_ILBM_resetRangeOffsets(&image->rangeTimes, image->image);
+    updateColors(image, &first, &count);
+}
+
+/* Amount of times a period may revisit each state that can be stored, before precomputing it is considered to take too long */
+#define MAX_EVENTS_PER_STATE 16
+
+static size_t computeFrameSize(const SDL_Surface *surface)
+{
+    return (size_t)surface->pitch * surface->h;
+}
+
+amiVideo_Bool SDL_ILBM_precomputePalettes(SDL_ILBM_Image *image, const unsigned int maxStates, const size_t maxFramesSize)
+{
+    amiVideo_Palette *palette = &image->screen.palette;
+    amiVideo_Bool status = TRUE;
+    size_t chunkyColorsSize;
+    unsigned int first, count, numOfEvents = 0;
+    Uint32 period, nextTime, time = 0;
+
+    if(image->compacted)
+        return FALSE; /* There are no range states to precompute */
+
+    if(image->rangeTimes.overlapping)
+        return FALSE; /* Colors shared by several ranges do not only depend on the range states, but also on how these have been reached */
+
+    /* Visit every moment within the period at which a range advances */
+    period = SDL_ILBM_computeCyclePeriod(&image->rangeTimes, image->image);
+
+    if(period == (Uint32)-1)
+        return FALSE; /* The period is too long to visit => keep cycling live */
+
+    SDL_ILBM_discardPalettes(image);
+
+    /* Chunky images only need their palettes, RGB images can benefit from rendered frames as well */
+    if(image->format == SDL_ILBM_CHUNKY_FORMAT)
+        chunkyColorsSize = palette->chunkyFormat.numOfColors * sizeof(amiVideo_OutputColor);
+    else
+        chunkyColorsSize = 0;
+
+    image->paletteCache = SDL_ILBM_createPaletteCache(SDL_ILBM_countRanges(image->image), maxStates, palette->bitplaneFormat.numOfColors * sizeof(amiVideo_Color), chunkyColorsSize, computeFrameSize(image->surface), image->format == SDL_ILBM_CHUNKY_FORMAT ? 0 : maxFramesSize);
+
+    if(image->paletteCache == NULL)
+        return FALSE;
+
+    do
+    {
+        SDL_ILBM_seekRanges(&image->rangeTimes, image->image, time);
+        SDL_ILBM_materializeRanges(&image->rangeTimes, image->image, palette, &first, &count);
+
+        if(image->format == SDL_ILBM_CHUNKY_FORMAT)
+            amiVideo_convertBitplaneColorsToChunkyFormat(palette);
+        else if(image->paletteCache->framesSize + image->paletteCache->frameSize <= image->paletteCache->maxFramesSize)
+            image->updatePaletteAndSurface(image, first, count); /* Render the frame so that it can be cached */
+
+        if(!cacheCurrentPalette(image))
+        {
+            status = FALSE; /* The period has more states than the cache permits */
+            break;
+        }
+
+        if(++numOfEvents > MAX_EVENTS_PER_STATE * maxStates)
+        {
+            status = FALSE; /* The period mostly revisits known states, so that visiting all of it takes too long */
+            break;
+        }
+
+        nextTime = SDL_ILBM_computeNextRangeTime(&image->rangeTimes, image->image);
+
+        if(nextTime > time)
+            time = nextTime;
+        else
+            time++; /* Make sure we always make progress */
+    }
+    while(time < period && !SDL_ILBM_rangesHaveWrapped(&image->rangeTimes, image->image, time));
+
+    if(!status)
+        SDL_ILBM_discardPalettes(image);
+
+    /* Restart cycling and bring the palette and surface back in sync */
+    SDL_ILBM_resetRangeOffsets(&image->rangeTimes, image->image);
+    updateColors(image, &first, &count);
+
+    return status;
+}
+
+void SDL_ILBM_discardPalettes(SDL_ILBM_Image *image)
+{
+    SDL_ILBM_freePaletteCache(image->paletteCache);
+    image->paletteCache = NULL;
+}
+
+static int keepRGBSurface(SDL_ILBM_Image *image, const unsigned int first, const unsigned int count)
+{
+    return 0; /* The pixels to re-render the surface from have been released */
+}
+
+/* Frees the data of a raw chunk, while keeping the chunk itself in the IFF structure */
+
+static void releaseRawChunkData(IFF_RawChunk *rawChunk)
+{
+    if(rawChunk != NULL && rawChunk->chunkData != NULL)
+    {
+        free(rawChunk->chunkData);
+        IFF_setRawChunkData(rawChunk, NULL, 0);
+    }
+}
+
+/* Clears the pointers of the conversion screen that refer to released chunk data, keeping the ones that refer to the surface */
+
+static void detachReleasedPixelsFromScreen(amiVideo_Screen *screen, const SDL_Surface *surface)
+{
+    if(!screen->bitplaneFormat.memoryAllocated)
+        memset(screen->bitplaneFormat.bitplanes, '\0', sizeof(screen->bitplaneFormat.bitplanes));
+
+    if(screen->uncorrectedChunkyFormat.pixels != surface->pixels)
+        screen->uncorrectedChunkyFormat.pixels = NULL;
+
+    if((void*)screen->uncorrectedRGBFormat.pixels != surface->pixels)
+        screen->uncorrectedRGBFormat.pixels = NULL;
+}
+
+amiVideo_Bool SDL_ILBM_compactImage(SDL_ILBM_Image *image)
+{
+    if(image->strategy != SDL_ILBM_STATIC_STRATEGY)
+        return FALSE;
+    else if(image->compacted)
+        return TRUE;
+
+    SDL_ILBM_discardPalettes(image);
+
+    /* Release the range times. In an arena they are freed along with the image */
+    SDL_ILBM_cleanupRangeTimes(&image->rangeTimes);
+    image->rangeTimes.memory = NULL;
+
+    /* Release the intermediate buffers of the conversion screen */
+    SDL_ILBM_returnUncorrectedMemoryToPool(&image->screen, image->bufferPool);
+
+    /* Release the source pixels, unless the surface refers to them */
+    if(!(image->surface->flags & SDL_PREALLOC))
+        releaseRawChunkData(image->image->body);
+
+    releaseRawChunkData(image->image->bitplanes);
+    detachReleasedPixelsFromScreen(&image->screen, image->surface);
+
+    /* Chunky surfaces can still take palette updates, but RGB surfaces can no longer be rendered */
+    if(image->format != SDL_ILBM_CHUNKY_FORMAT)
+        image->updatePaletteAndSurface = keepRGBSurface;
+
+    image->compacted = TRUE;
+    return TRUE;
 }
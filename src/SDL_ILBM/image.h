@@ -35,6 +35,9 @@ typedef struct SDL_ILBM_Image SDL_ILBM_Image;
 #include <libilbm/ilbmimage.h>
 #include <libamivideo/screen.h>
 #include "cycle.h"
+#include "palettecache.h"
+#include "bufferpool.h"
+#include "allocator.h"
 
 /**
  * @brief Enumerates all possible output formats this API supports.
@@ -43,10 +46,25 @@ typedef enum
 {
     SDL_ILBM_AUTO_FORMAT = 0,
     SDL_ILBM_CHUNKY_FORMAT = 1,
+    SDL_ILBM_CHEAPEST_FORMAT = 2,
     SDL_ILBM_RGB_FORMAT = 4
 }
 SDL_ILBM_Format;
 
+/**
+ * @brief Enumerates the strategies to update an image each time a color cycles.
+ */
+typedef enum
+{
+    /** The image has no active color ranges, so it is rendered only once */
+    SDL_ILBM_STATIC_STRATEGY = 0,
+    /** Only the palette of the chunky surface is updated */
+    SDL_ILBM_PALETTE_STRATEGY = 1,
+    /** The RGB surface is re-rendered entirely */
+    SDL_ILBM_RERENDER_STRATEGY = 2
+}
+SDL_ILBM_Strategy;
+
 /**
  * @brief Encapsulates the properties of a cyclable image
  */
@@ -70,8 +88,26 @@ struct SDL_ILBM_Image
     /** Defines to which format the output must be converted */
     SDL_ILBM_Format format;
 
-    /** Function that must be executed to update the palette and surface each time a color cycles. This function is for internal use only. */
-    int (*updatePaletteAndSurface) (const ILBM_Image *image, amiVideo_Screen *screen, SDL_Surface *surface);
+    /** Specifies how the image is updated each time a color cycles. For SDL_ILBM_CHEAPEST_FORMAT, the format is picked so that this has the cheapest cost per frame */
+    SDL_ILBM_Strategy strategy;
+
+    /** Indicates whether everything except the surface and palette has been released by SDL_ILBM_compactImage() */
+    amiVideo_Bool compacted;
+
+    /** Cache of precomputed palettes for each state of the color ranges or NULL if palettes are not precomputed */
+    SDL_ILBM_PaletteCache *paletteCache;
+
+    /** Pool from which the surface and pixel buffers have been taken and to which they are returned when the image is destroyed, or NULL if they are not pooled */
+    SDL_ILBM_BufferPool *bufferPool;
+
+    /** Arena containing the image, its range times and the displays created for it, or NULL if the image has not been composed in arena mode */
+    SDL_ILBM_Arena *arena;
+
+    /** Cycle group the image belongs to or NULL if it does not belong to any. The image is removed from it when it is destroyed */
+    struct SDL_ILBM_CycleGroup *cycleGroup;
+
+    /** Function that must be executed to update the palette and surface each time a color cycles. It receives the span of palette indexes that have changed. This function is for internal use only. */
+    int (*updatePaletteAndSurface) (SDL_ILBM_Image *image, const unsigned int first, const unsigned int count);
 };
 
 /**
@@ -84,20 +120,48 @@ struct SDL_ILBM_Image
  */
 SDL_Surface *SDL_ILBM_createSurface(ILBM_Image *image, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format);
 
+/**
+ * Computes the dimensions and the format of the surface that composing an
+ * image would produce, without decoding its body. The choices are the same as
+ * those of SDL_ILBM_createImage(), including indexed residency.
+ *
+ * @param image ILBM image of which at least the bitmap header must be present. The body is not used
+ * @param lowresPixelScaleFactor Specifies the width of a lowres pixel or 0 to pick it automatically
+ * @param format Defines to which format the output would be converted
+ * @param width Variable receiving the width of the surface in pixels
+ * @param height Variable receiving the height of the surface in pixels
+ * @return The format of the surface, which is either SDL_ILBM_CHUNKY_FORMAT or SDL_ILBM_RGB_FORMAT
+ */
+SDL_ILBM_Format SDL_ILBM_computeSurfaceDimensions(const ILBM_Image *image, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format, int *width, int *height);
+
+/**
+ * Checks whether composing an image with SDL_ILBM_createImage() unpacks its
+ * body, or renders the surface from the compressed body directly.
+ *
+ * @param image ILBM image of which at least the bitmap header must be present
+ * @param lowresPixelScaleFactor Specifies the width of a lowres pixel or 0 to pick it automatically
+ * @param format Defines to which format the output would be converted
+ * @return TRUE if the body would be unpacked, else FALSE
+ */
+amiVideo_Bool SDL_ILBM_composingUnpacksBody(const ILBM_Image *image, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format);
+
 /**
  * Initializes a preallocated SDL_ILBM_Image from a given ILBM image in a specified
- * output format.
+ * output format. The chunky surface of a PBM image may directly refer to the
+ * decoded body of the ILBM image, which must therefore outlive the image.
  *
  * @param image Preallocated SDL_ILBM_Image instance
  * @param ilbmImage ILBM image to generate the output from
  * @param lowresPixelScaleFactor Specifies the width of a lowres pixel
- * @param format Defines to which format the output must be converted
+ * @param format Defines to which format the output must be converted. SDL_ILBM_CHEAPEST_FORMAT takes the color ranges of the image into account
  * @return TRUE if the initalisation succeeded, otherwise FALSE
  */
 amiVideo_Bool SDL_ILBM_initImage(SDL_ILBM_Image *image, ILBM_Image *ilbmImage, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format);
 
 /**
  * Composes an SDL_ILBM_Image from a given ILBM image in a specified output format.
+ * The chunky surface of a PBM image may directly refer to the decoded body of
+ * the ILBM image, which must therefore outlive the image.
  *
  * @param ilbmImage ILBM image to generate the output from
  * @param lowresPixelScaleFactor Specifies the width of a lowres pixel
@@ -106,6 +170,26 @@ amiVideo_Bool SDL_ILBM_initImage(SDL_ILBM_Image *image, ILBM_Image *ilbmImage, c
  */
 SDL_ILBM_Image *SDL_ILBM_createImage(ILBM_Image *ilbmImage, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format);
 
+/**
+ * Enables or disables indexed residency. While it is enabled, images that can
+ * be represented as chunky pixels (up to 8 bitplanes and no HAM mode) are
+ * composed as 8-bit surfaces with a palette, regardless of the requested
+ * format. Their pixels are only expanded to true color while they are blitted
+ * or rendered into a texture, so that resident images take a quarter of the
+ * memory of RGB surfaces. Cycling images are then updated by changing their
+ * palette. Images that have already been composed are not affected.
+ *
+ * @param enabled TRUE to enable indexed residency, FALSE to disable it
+ */
+void SDL_ILBM_setIndexedResidency(const amiVideo_Bool enabled);
+
+/**
+ * Checks whether indexed residency is enabled.
+ *
+ * @return TRUE if indexed residency is enabled, else FALSE
+ */
+amiVideo_Bool SDL_ILBM_getIndexedResidency(void);
+
 /**
  * Blits an SDL_ILBM_Image to a provided SDL Surface, optionally restricting the
  * source and destination areas to a specific subsets. This function is
@@ -119,6 +203,22 @@ SDL_ILBM_Image *SDL_ILBM_createImage(ILBM_Image *ilbmImage, const unsigned int l
  */
 int SDL_ILBM_blitImageToSurface(SDL_ILBM_Image *image, const SDL_Rect *srcrect, SDL_Surface *dst, SDL_Rect *dstrect);
 
+/**
+ * Renders the pixels of an SDL_ILBM_Image directly into memory owned by the
+ * caller, such as the pixels of a locked streaming texture, in any SDL pixel
+ * format. Chunky images are converted to 32-bit pixel formats by looking up
+ * their colors directly, and images already having the requested format are
+ * copied row by row.
+ *
+ * @param image An SDL_ILBM_Image instance
+ * @param pixels Memory receiving the pixels of the rectangle, which must be large enough to store pitch * height bytes
+ * @param pitch Length of a row in pixels in bytes
+ * @param pixelFormat An SDL_PixelFormatEnum value specifying the format of the pixels
+ * @param rect Rectangle restricting the area of the image or NULL to pick the entire area. It must fit in the image
+ * @return 0 in case of a success or a value below zero in case of a failure. SDL_GetError() provides the reason of the failure
+ */
+int SDL_ILBM_renderInto(const SDL_ILBM_Image *image, void *pixels, int pitch, Uint32 pixelFormat, const SDL_Rect *rect);
+
 /**
  * Clears the properties of the provided image from memory.
  * 
@@ -127,20 +227,67 @@ int SDL_ILBM_blitImageToSurface(SDL_ILBM_Image *image, const SDL_Rect *srcrect,
 void SDL_ILBM_destroyImage(SDL_ILBM_Image *image);
 
 /**
- * Frees the provided image from memory.
+ * Frees the provided image from memory. In arena mode, the displays created
+ * for the image are freed along with it, so these must be freed first.
  * 
  * @param image An SDL_ILBM_Image instance
  */
 void SDL_ILBM_freeImage(SDL_ILBM_Image *image);
 
+/**
+ * Lets the image render its frames into another surface, having the same
+ * dimensions and format as the surface the image was composed with. This only
+ * applies to images having the RGB format, as chunky images only update their
+ * palettes. The provided surface is only rendered the next time the colors of
+ * the image change.
+ *
+ * @param image An SDL_ILBM_Image instance having the RGB format
+ * @param surface Surface to which the image renders from now on
+ */
+void SDL_ILBM_redirectImage(SDL_ILBM_Image *image, SDL_Surface *surface);
+
 /**
  * Checks whether the range times have ellapsed and cycles the
- * corresponding colors in the palette accordingly.
+ * corresponding colors in the palette accordingly. Ranges that have missed
+ * several steps, e.g. after a stall, are advanced by all of them at once.
  *
  * @param image An SDL_ILBM_Image instance
  */
 void SDL_ILBM_cycleColors(SDL_ILBM_Image *image);
 
+/**
+ * Checks whether the range times have ellapsed at a given moment in time and
+ * cycles the corresponding colors in the palette accordingly.
+ *
+ * @param image An SDL_ILBM_Image instance
+ * @param ticks Moment in time in SDL ticks
+ * @param first Is set to the first palette index that has changed
+ * @param count Is set to the amount of palette indexes that have changed
+ * @return TRUE if the palette has changed, else FALSE
+ */
+amiVideo_Bool SDL_ILBM_cycleColorsAt(SDL_ILBM_Image *image, const Uint32 ticks, unsigned int *first, unsigned int *count);
+
+/**
+ * Copies the current palette of another image with identical colors and color
+ * ranges, and updates the surface accordingly.
+ *
+ * @param image An SDL_ILBM_Image instance
+ * @param sourceImage An SDL_ILBM_Image instance with identical colors and color ranges
+ * @param first First palette index that has changed
+ * @param count Amount of palette indexes that have changed
+ */
+void SDL_ILBM_copyColors(SDL_ILBM_Image *image, const SDL_ILBM_Image *sourceImage, const unsigned int first, const unsigned int count);
+
+/**
+ * Computes the state of the palette at a given amount of time after cycling has
+ * started and updates the surface accordingly. Subsequent invocations of
+ * SDL_ILBM_cycleColors() continue cycling from that point in time.
+ *
+ * @param image An SDL_ILBM_Image instance
+ * @param time Time in milliseconds since the start of cycling
+ */
+void SDL_ILBM_seekColors(SDL_ILBM_Image *image, const Uint32 time);
+
 /**
  * Resets the colors in the palette back to normal.
  *
@@ -148,6 +295,44 @@ void SDL_ILBM_cycleColors(SDL_ILBM_Image *image);
  */
 void SDL_ILBM_resetColors(SDL_ILBM_Image *image);
 
+/**
+ * Precomputes every distinct palette that the image attains during a full
+ * period of its color ranges, so that cycling only has to look them up. For
+ * RGB images, fully rendered frames are cached as well, as long as they fit
+ * within the provided budget, so that cycling becomes a memory copy.
+ *
+ * Precomputing restarts cycling from the beginning. Images of which the
+ * active ranges share colors cannot be precomputed, since their palettes also
+ * depend on the order in which the ranges have advanced.
+ *
+ * @param image An SDL_ILBM_Image instance
+ * @param maxStates Maximum amount of range states that may be stored
+ * @param maxFramesSize Maximum amount of bytes that rendered frames may occupy or 0 to not cache frames
+ * @return TRUE if all palettes of the period could be precomputed, else FALSE. In the latter case, palettes are not cached and the image keeps cycling live. This is also the case if the image has no ranges, or if its period is too long to visit
+ */
+amiVideo_Bool SDL_ILBM_precomputePalettes(SDL_ILBM_Image *image, const unsigned int maxStates, const size_t maxFramesSize);
+
+/**
+ * Discards the precomputed palettes of an image.
+ *
+ * @param image An SDL_ILBM_Image instance
+ */
+void SDL_ILBM_discardPalettes(SDL_ILBM_Image *image);
+
+/**
+ * Releases everything of a static image, that has no active color ranges,
+ * except its surface and palette: the range times, the buffers of the
+ * conversion screen, and the body and deinterleaved bitplanes of the ILBM
+ * image. Afterwards, the image can still be blitted and its colors can be
+ * reset, but the ILBM image can no longer be used to compose other images.
+ * The body of a PBM image is kept if the surface refers to it. Images owned
+ * by an image cache must be compacted with SDL_ILBM_compactCachedImage().
+ *
+ * @param image An SDL_ILBM_Image instance
+ * @return TRUE if the image has been compacted, FALSE if it has active color ranges
+ */
+amiVideo_Bool SDL_ILBM_compactImage(SDL_ILBM_Image *image);
+
 #ifdef __cplusplus
 }
 #endif
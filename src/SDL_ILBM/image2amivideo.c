@@ -33,7 +33,7 @@ amiVideo_ULong SDL_ILBM_extractViewportModeFromImage(const ILBM_Image *image)
     return paletteFlags | resolutionFlags;
 }
 
-void SDL_ILBM_attachImageToScreen(ILBM_Image *image, amiVideo_Screen *screen)
+void SDL_ILBM_initScreenFromImage(const ILBM_Image *image, amiVideo_Screen *screen)
 {
     /* Determine which viewport mode is best for displaying the image */
     IFF_Long viewportMode = SDL_ILBM_extractViewportModeFromImage(image);
@@ -43,7 +43,27 @@ void SDL_ILBM_attachImageToScreen(ILBM_Image *image, amiVideo_Screen *screen)
 
     /* Sets the colors of the palette */
     SDL_ILBM_initPaletteFromImage(image, &screen->palette);
+}
+
+void SDL_ILBM_attachImageToScreen(ILBM_Image *image, amiVideo_Screen *screen)
+{
+    SDL_ILBM_initScreenFromImage(image, screen);
+    SDL_ILBM_attachPixelsToScreen(image, screen);
+}
+
+static unsigned int countInterleavedPlanes(const ILBM_Image *image)
+{
+    return image->bitMapHeader->nPlanes + (image->bitMapHeader->masking == ILBM_MSK_HAS_MASK ? 1 : 0); /* The mask plane is interleaved as well */
+}
+
+static amiVideo_Bool bodyCanBeReadInPlace(const ILBM_Image *image)
+{
+    return (image->body != NULL && image->bitMapHeader->compression == ILBM_CMP_NONE
+        && (IFF_Long)(ILBM_calculateRowSize(image) * countInterleavedPlanes(image) * image->bitMapHeader->h) <= image->body->chunkSize);
+}
 
+void SDL_ILBM_attachPixelsToScreen(ILBM_Image *image, amiVideo_Screen *screen)
+{
     /* Decompress the image body */
     ILBM_unpackByteRun(image);
 
@@ -54,7 +74,31 @@ void SDL_ILBM_attachImageToScreen(ILBM_Image *image, amiVideo_Screen *screen)
         amiVideo_setScreenBitplanes(screen, (amiVideo_UByte*)image->bitplanes->chunkData); /* Set bitplane pointers of the conversion screen */
     else if(ILBM_imageIsILBM(image))
     {
-        if(ILBM_convertILBMToACBM(image)) /* Amiga ILBM image has interleaved scanlines per bitplane. We have to deinterleave it in order to be able to convert it */
+        if(bodyCanBeReadInPlace(image))
+        {
+            unsigned int rowSize = ILBM_calculateRowSize(image);
+            SDL_ILBM_setScreenInterleavedBitplanes(screen, (amiVideo_UByte*)image->body->chunkData, rowSize, rowSize * countInterleavedPlanes(image)); /* Amiga ILBM image has interleaved scanlines per bitplane. Read them in place by skipping over the rows of the other bitplanes */
+        }
+        else if(ILBM_convertILBMToACBM(image)) /* The body is incomplete => let the deinterleaving step take care of it */
             amiVideo_setScreenBitplanes(screen, (amiVideo_UByte*)image->bitplanes->chunkData); /* Set bitplane pointers of the conversion screen */
     }
 }
+
+amiVideo_Bool SDL_ILBM_bitplanesAreAttached(const ILBM_Image *image)
+{
+    if(image->bitplanes != NULL)
+        return TRUE;
+    else
+        return (ILBM_imageIsILBM(image) && bodyCanBeReadInPlace(image));
+}
+
+void SDL_ILBM_setScreenInterleavedBitplanes(amiVideo_Screen *screen, amiVideo_UByte *bitplanes, const unsigned int rowSize, const unsigned int stride)
+{
+    int i;
+
+    /* Each bitplane starts at the next row of the first scanline, and consecutive rows of the same bitplane are a stride apart */
+    for(i = 0; i < screen->bitplaneDepth && i < AMIVIDEO_MAX_NUM_OF_BITPLANES; i++)
+        screen->bitplaneFormat.bitplanes[i] = bitplanes + i * rowSize;
+
+    screen->bitplaneFormat.pitch = stride;
+}
@@ -36,8 +36,16 @@ void SDL_ILBM_initPaletteFromImage(const ILBM_Image *image, amiVideo_Palette *pa
 
 amiVideo_ULong SDL_ILBM_extractViewportModeFromImage(const ILBM_Image *image);
 
+void SDL_ILBM_initScreenFromImage(const ILBM_Image *image, amiVideo_Screen *screen);
+
 void SDL_ILBM_attachImageToScreen(ILBM_Image *image, amiVideo_Screen *screen);
 
+void SDL_ILBM_attachPixelsToScreen(ILBM_Image *image, amiVideo_Screen *screen);
+
+amiVideo_Bool SDL_ILBM_bitplanesAreAttached(const ILBM_Image *image);
+
+void SDL_ILBM_setScreenInterleavedBitplanes(amiVideo_Screen *screen, amiVideo_UByte *bitplanes, const unsigned int rowSize, const unsigned int stride);
+
 #ifdef __cplusplus
 }
 #endif
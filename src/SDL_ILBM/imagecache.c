@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#include "imagecache.h"
+#include <stdlib.h>
+#include <string.h>
+#include "memoryusage.h"
+
+SDL_ILBM_ImageCache *SDL_ILBM_createImageCache(SDL_ILBM_Set *set, size_t maxSize)
+{
+    SDL_ILBM_ImageCache *imageCache = (SDL_ILBM_ImageCache*)SDL_ILBM_malloc(sizeof(SDL_ILBM_ImageCache));
+
+    if(imageCache != NULL)
+    {
+        imageCache->set = set;
+        imageCache->head = NULL;
+        imageCache->tail = NULL;
+        imageCache->size = 0;
+        imageCache->maxSize = maxSize;
+        SDL_ILBM_resetImageCacheStatistics(imageCache);
+
+        imageCache->packedBodies = (SDL_ILBM_PackedBody*)SDL_ILBM_calloc(set->imagesLength + 1, sizeof(SDL_ILBM_PackedBody));
+
+        if(imageCache->packedBodies == NULL)
+        {
+            SDL_ILBM_free(imageCache);
+            return NULL;
+        }
+    }
+
+    return imageCache;
+}
+
+static amiVideo_Bool indexIsCached(const SDL_ILBM_ImageCache *imageCache, const unsigned int index)
+{
+    const SDL_ILBM_ImageCacheEntry *entry;
+
+    for(entry = imageCache->head; entry != NULL; entry = entry->next)
+    {
+        if(entry->index == index)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/* Brings the body of an ILBM image back to its compressed form, once no cached image is composed from it anymore */
+
+static void restorePackedBody(SDL_ILBM_ImageCache *imageCache, const unsigned int index)
+{
+    SDL_ILBM_PackedBody *packedBody = &imageCache->packedBodies[index];
+    ILBM_Image *ilbmImage = imageCache->set->ilbmImages[index];
+
+    if(packedBody->chunkData == NULL || indexIsCached(imageCache, index))
+        return;
+
+    imageCache->size -= packedBody->chunkSize + packedBody->unpackedChunkSize;
+
+    if(ilbmImage->body == NULL)
+        free(packedBody->chunkData); /* The body has been converted into something else, so it cannot be replaced */
+    else
+    {
+        free(ilbmImage->body->chunkData);
+        IFF_setRawChunkData(ilbmImage->body, packedBody->chunkData, packedBody->chunkSize);
+        ilbmImage->bitMapHeader->compression = ILBM_CMP_BYTE_RUN;
+    }
+
+    packedBody->chunkData = NULL;
+}
+
+static void unlinkEntry(SDL_ILBM_ImageCache *imageCache, SDL_ILBM_ImageCacheEntry *entry)
+{
+    if(entry->previous == NULL)
+        imageCache->head = entry->next;
+    else
+        entry->previous->next = entry->next;
+
+    if(entry->next == NULL)
+        imageCache->tail = entry->previous;
+    else
+        entry->next->previous = entry->previous;
+}
+
+static void prependEntry(SDL_ILBM_ImageCache *imageCache, SDL_ILBM_ImageCacheEntry *entry)
+{
+    entry->previous = NULL;
+    entry->next = imageCache->head;
+
+    if(imageCache->head == NULL)
+        imageCache->tail = entry;
+    else
+        imageCache->head->previous = entry;
+
+    imageCache->head = entry;
+}
+
+static void removeEntry(SDL_ILBM_ImageCache *imageCache, SDL_ILBM_ImageCacheEntry *entry)
+{
+    unlinkEntry(imageCache, entry);
+
+    SDL_ILBM_freeImage(entry->image);
+    imageCache->size -= entry->size;
+    restorePackedBody(imageCache, entry->index);
+
+    SDL_ILBM_free(entry);
+}
+
+/* Evicts the least recently used entries until the cache fits in its budget, but never the given entry */
+
+static void evictEntries(SDL_ILBM_ImageCache *imageCache, const SDL_ILBM_ImageCacheEntry *keep)
+{
+    while(imageCache->size > imageCache->maxSize && imageCache->tail != NULL && imageCache->tail != keep)
+    {
+        removeEntry(imageCache, imageCache->tail);
+        imageCache->numOfEvictions++;
+    }
+}
+
+void SDL_ILBM_freeImageCache(SDL_ILBM_ImageCache *imageCache)
+{
+    if(imageCache != NULL)
+    {
+        while(imageCache->head != NULL)
+            removeEntry(imageCache, imageCache->head);
+
+        SDL_ILBM_free(imageCache->packedBodies);
+        SDL_ILBM_free(imageCache);
+    }
+}
+
+static SDL_ILBM_ImageCacheEntry *lookupEntry(const SDL_ILBM_ImageCache *imageCache, const unsigned int index, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format)
+{
+    SDL_ILBM_ImageCacheEntry *entry;
+
+    for(entry = imageCache->head; entry != NULL; entry = entry->next)
+    {
+        if(entry->index == index && entry->lowresPixelScaleFactor == lowresPixelScaleFactor && entry->format == format)
+            return entry;
+    }
+
+    return NULL;
+}
+
+/* Composes an image, while keeping a copy of its body if composing it unpacks the body */
+
+static SDL_ILBM_Image *composeImage(SDL_ILBM_ImageCache *imageCache, const unsigned int index, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format)
+{
+    ILBM_Image *ilbmImage = imageCache->set->ilbmImages[index];
+    SDL_ILBM_PackedBody *packedBody = &imageCache->packedBodies[index];
+    IFF_UByte *chunkData = NULL;
+    IFF_Long chunkSize = 0;
+    SDL_ILBM_Image *image;
+
+    /* Only keep a copy of the compressed body if composing the image unpacks it. Rendering scanlines leaves it compressed */
+    if(packedBody->chunkData == NULL && ilbmImage->body != NULL && ilbmImage->body->chunkData != NULL && SDL_ILBM_composingUnpacksBody(ilbmImage, lowresPixelScaleFactor, format))
+    {
+        /* The body is handed back to libiff, which frees it with free() */
+        chunkSize = ilbmImage->body->chunkSize;
+        chunkData = (IFF_UByte*)malloc(chunkSize);
+
+        if(chunkData == NULL)
+            return NULL;
+
+        memcpy(chunkData, ilbmImage->body->chunkData, chunkSize);
+    }
+
+    image = SDL_ILBM_createImage(ilbmImage, lowresPixelScaleFactor, format);
+
+    if(chunkData != NULL)
+    {
+        if(ilbmImage->bitMapHeader->compression == ILBM_CMP_BYTE_RUN)
+            free(chunkData); /* The image has been rendered from the compressed body directly */
+        else
+        {
+            packedBody->chunkData = chunkData;
+            packedBody->chunkSize = chunkSize;
+            packedBody->unpackedChunkSize = ilbmImage->body == NULL ? 0 : ilbmImage->body->chunkSize;
+            imageCache->size += packedBody->chunkSize + packedBody->unpackedChunkSize; /* The cache holds both forms of the body */
+        }
+    }
+
+    return image;
+}
+
+SDL_ILBM_Image *SDL_ILBM_getCachedImage(SDL_ILBM_ImageCache *imageCache, const unsigned int index, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format)
+{
+    SDL_ILBM_ImageCacheEntry *entry;
+    SDL_ILBM_MemoryUsage usage;
+
+    if(index >= imageCache->set->imagesLength)
+        return NULL;
+
+    if((entry = lookupEntry(imageCache, index, lowresPixelScaleFactor, format)) != NULL)
+    {
+        /* Make the entry the most recently used one */
+        unlinkEntry(imageCache, entry);
+        prependEntry(imageCache, entry);
+        imageCache->numOfHits++;
+        return entry->image;
+    }
+
+    imageCache->numOfMisses++;
+
+    if((entry = (SDL_ILBM_ImageCacheEntry*)SDL_ILBM_malloc(sizeof(SDL_ILBM_ImageCacheEntry))) == NULL)
+        return NULL;
+
+    if((entry->image = composeImage(imageCache, index, lowresPixelScaleFactor, format)) == NULL)
+    {
+        SDL_ILBM_free(entry);
+        restorePackedBody(imageCache, index);
+        return NULL;
+    }
+
+    entry->index = index;
+    entry->lowresPixelScaleFactor = lowresPixelScaleFactor;
+    entry->format = format;
+
+    SDL_ILBM_getImageMemoryUsage(entry->image, &usage);
+    entry->size = SDL_ILBM_computeTotalMemoryUsage(&usage);
+    imageCache->size += entry->size;
+
+    prependEntry(imageCache, entry);
+    evictEntries(imageCache, entry);
+
+    return entry->image;
+}
+
+amiVideo_Bool SDL_ILBM_compactCachedImage(SDL_ILBM_ImageCache *imageCache, SDL_ILBM_Image *image)
+{
+    SDL_ILBM_ImageCacheEntry *entry, *owner = NULL;
+    SDL_ILBM_PackedBody *packedBody;
+    SDL_ILBM_MemoryUsage usage;
+    ILBM_Image *ilbmImage;
+
+    for(entry = imageCache->head; entry != NULL; entry = entry->next)
+    {
+        if(entry->image == image)
+            owner = entry;
+    }
+
+    if(owner == NULL)
+        return FALSE; /* The image is not owned by this cache */
+
+    /* Compacting releases the body and bitplanes of the ILBM image, which other cached images composed from it may still use */
+    for(entry = imageCache->head; entry != NULL; entry = entry->next)
+    {
+        if(entry != owner && entry->index == owner->index)
+            return FALSE;
+    }
+
+    if(!SDL_ILBM_compactImage(image))
+        return FALSE;
+
+    /* The unpacked body may have been released => only its compressed copy remains accounted for */
+    packedBody = &imageCache->packedBodies[owner->index];
+    ilbmImage = imageCache->set->ilbmImages[owner->index];
+
+    if(packedBody->chunkData != NULL && (ilbmImage->body == NULL || ilbmImage->body->chunkData == NULL))
+    {
+        imageCache->size -= packedBody->unpackedChunkSize;
+        packedBody->unpackedChunkSize = 0;
+    }
+
+    /* Account for the buffers the image has released */
+    imageCache->size -= owner->size;
+    SDL_ILBM_getImageMemoryUsage(image, &usage);
+    owner->size = SDL_ILBM_computeTotalMemoryUsage(&usage);
+    imageCache->size += owner->size;
+
+    return TRUE;
+}
+
+void SDL_ILBM_setImageCacheMaxSize(SDL_ILBM_ImageCache *imageCache, size_t maxSize)
+{
+    imageCache->maxSize = maxSize;
+    evictEntries(imageCache, imageCache->head);
+}
+
+void SDL_ILBM_resetImageCacheStatistics(SDL_ILBM_ImageCache *imageCache)
+{
+    imageCache->numOfHits = 0;
+    imageCache->numOfMisses = 0;
+    imageCache->numOfEvictions = 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#ifndef __SDL_ILBM_IMAGECACHE_H
+#define __SDL_ILBM_IMAGECACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SDL_ILBM_ImageCacheEntry SDL_ILBM_ImageCacheEntry;
+typedef struct SDL_ILBM_ImageCache SDL_ILBM_ImageCache;
+
+#include <stddef.h>
+#include "set.h"
+#include "image.h"
+
+/**
+ * @brief The compressed form of a body that has been unpacked while composing
+ * an image
+ */
+typedef struct
+{
+    /** Copy of the compressed body or NULL if the body has not been unpacked by the cache */
+    IFF_UByte *chunkData;
+
+    /** Size of the compressed body, which is accounted for by the cache */
+    IFF_Long chunkSize;
+
+    /** Size of the unpacked body that is accounted for by the cache */
+    IFF_Long unpackedChunkSize;
+}
+SDL_ILBM_PackedBody;
+
+/**
+ * @brief An image composed from a set that is kept in a cache
+ */
+struct SDL_ILBM_ImageCacheEntry
+{
+    /** Index of the image in the set */
+    unsigned int index;
+
+    /** Specifies the width of a lowres pixel, as requested */
+    unsigned int lowresPixelScaleFactor;
+
+    /** Defines to which format the output has been converted, as requested */
+    SDL_ILBM_Format format;
+
+    /** The composed image */
+    SDL_ILBM_Image *image;
+
+    /** Amount of bytes the image holds */
+    size_t size;
+
+    /** Entry that has been used more recently or NULL if this is the most recently used entry */
+    SDL_ILBM_ImageCacheEntry *previous;
+
+    /** Entry that has been used less recently or NULL if this is the least recently used entry */
+    SDL_ILBM_ImageCacheEntry *next;
+};
+
+/**
+ * @brief Keeps recently used images of a set composed within a memory budget.
+ * When the budget is exceeded, the least recently used images are freed and the
+ * bodies of their ILBM images fall back to their compressed form, so that they
+ * are decoded again when they are needed.
+ */
+struct SDL_ILBM_ImageCache
+{
+    /** Set from which the images are composed */
+    SDL_ILBM_Set *set;
+
+    /** Most recently used entry or NULL if the cache is empty */
+    SDL_ILBM_ImageCacheEntry *head;
+
+    /** Least recently used entry or NULL if the cache is empty */
+    SDL_ILBM_ImageCacheEntry *tail;
+
+    /** Compressed forms of the bodies of the images in the set, indexed by image */
+    SDL_ILBM_PackedBody *packedBodies;
+
+    /** Amount of bytes held by the cached images and the unpacked bodies */
+    size_t size;
+
+    /** Maximum amount of bytes that the cached images and unpacked bodies may hold */
+    size_t maxSize;
+
+    /** Amount of requests for which a cached image could be returned */
+    unsigned int numOfHits;
+
+    /** Amount of requests for which an image had to be composed */
+    unsigned int numOfMisses;
+
+    /** Amount of images that have been freed to stay within the budget */
+    unsigned int numOfEvictions;
+};
+
+/**
+ * Creates an image cache for a set. The cache must be the only user of the
+ * ILBM images in the set, because it replaces their unpacked bodies by their
+ * compressed form when their images are evicted.
+ *
+ * @param set An SDL_ILBM_Set instance that must outlive the cache
+ * @param maxSize Maximum amount of bytes that the cached images and unpacked bodies may hold
+ * @return An SDL_ILBM_ImageCache instance or NULL in case of an error. The result must be freed with SDL_ILBM_freeImageCache()
+ */
+SDL_ILBM_ImageCache *SDL_ILBM_createImageCache(SDL_ILBM_Set *set, size_t maxSize);
+
+/**
+ * Frees an image cache and all its images, and brings the bodies of the ILBM
+ * images back to their compressed form.
+ *
+ * @param imageCache An SDL_ILBM_ImageCache instance
+ */
+void SDL_ILBM_freeImageCache(SDL_ILBM_ImageCache *imageCache);
+
+/**
+ * Retrieves an image of the set in the given output format from the cache or
+ * composes it if it is not cached. Afterwards, the least recently used images
+ * are evicted until the cache fits in its budget. The returned image is never
+ * evicted by the same call, but an image returned by an earlier call may be.
+ *
+ * @param imageCache An SDL_ILBM_ImageCache instance
+ * @param index Index of the image in the set
+ * @param lowresPixelScaleFactor Specifies the width of a lowres pixel
+ * @param format Defines to which format the output must be converted
+ * @return An SDL_ILBM_Image owned by the cache or NULL in case of an error
+ */
+SDL_ILBM_Image *SDL_ILBM_getCachedImage(SDL_ILBM_ImageCache *imageCache, const unsigned int index, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format);
+
+/**
+ * Compacts an image owned by the cache with SDL_ILBM_compactImage() and
+ * accounts for the memory it has released. Images from a cache must be
+ * compacted with this function, so that the cache's size stays accurate.
+ *
+ * @param imageCache An SDL_ILBM_ImageCache instance
+ * @param image An SDL_ILBM_Image returned by SDL_ILBM_getCachedImage()
+ * @return TRUE if the image has been compacted, FALSE if it has active color ranges, is not owned by the cache or another cached image is composed from the same ILBM image
+ */
+amiVideo_Bool SDL_ILBM_compactCachedImage(SDL_ILBM_ImageCache *imageCache, SDL_ILBM_Image *image);
+
+/**
+ * Changes the budget of an image cache, evicting the least recently used images
+ * until the cache fits. The most recently used image is never evicted.
+ *
+ * @param imageCache An SDL_ILBM_ImageCache instance
+ * @param maxSize Maximum amount of bytes that the cached images and unpacked bodies may hold
+ */
+void SDL_ILBM_setImageCacheMaxSize(SDL_ILBM_ImageCache *imageCache, size_t maxSize);
+
+/**
+ * Resets the hit, miss and eviction counters of an image cache.
+ *
+ * @param imageCache An SDL_ILBM_ImageCache instance
+ */
+void SDL_ILBM_resetImageCacheStatistics(SDL_ILBM_ImageCache *imageCache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
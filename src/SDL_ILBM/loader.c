@@ -0,0 +1,411 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#include "loader.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int processRequests(void *data);
+
+SDL_ILBM_Loader *SDL_ILBM_createLoader(unsigned int numOfThreads, const amiVideo_Bool pushEvents)
+{
+    SDL_ILBM_Loader *loader = (SDL_ILBM_Loader*)SDL_ILBM_malloc(sizeof(SDL_ILBM_Loader));
+    unsigned int i;
+
+    if(loader == NULL)
+        return NULL;
+
+    if(numOfThreads == 0)
+        numOfThreads = SDL_GetCPUCount();
+
+    loader->threadsLength = 0;
+    loader->queue = NULL;
+    loader->running = NULL;
+    loader->quit = FALSE;
+    loader->mutex = SDL_CreateMutex();
+    loader->cond = SDL_CreateCond();
+    loader->threads = (SDL_Thread**)SDL_ILBM_malloc(numOfThreads * sizeof(SDL_Thread*));
+
+    if(pushEvents)
+        loader->eventType = SDL_RegisterEvents(1);
+    else
+        loader->eventType = 0;
+
+    if(loader->mutex == NULL || loader->cond == NULL || loader->threads == NULL || loader->eventType == (Uint32)-1)
+    {
+        SDL_ILBM_freeLoader(loader);
+        return NULL;
+    }
+
+    for(i = 0; i < numOfThreads; i++)
+    {
+        SDL_Thread *thread = SDL_CreateThread(processRequests, "SDL_ILBM loader", loader);
+
+        if(thread == NULL)
+        {
+            SDL_ILBM_freeLoader(loader);
+            return NULL;
+        }
+
+        loader->threads[loader->threadsLength] = thread;
+        loader->threadsLength++;
+    }
+
+    return loader;
+}
+
+/* Notifies the caller that a request has finished. The caller may free the request as soon as its status has been set */
+
+static void finishRequest(SDL_ILBM_Loader *loader, SDL_ILBM_Request *request, const SDL_ILBM_RequestStatus status)
+{
+    SDL_ILBM_RequestCallback callback = request->callback;
+    SDL_Event event;
+
+    SDL_zero(event);
+    event.type = loader->eventType;
+    event.user.code = status;
+    event.user.data1 = request;
+    event.user.data2 = request->userData;
+
+    if(callback != NULL)
+        callback(request, event.user.data2);
+
+    /* A caller polling the status may free the request as soon as it has finished => it must not be touched afterwards */
+    SDL_AtomicSet(&request->status, status);
+
+    if(loader->eventType != 0)
+        SDL_PushEvent(&event);
+}
+
+void SDL_ILBM_freeLoader(SDL_ILBM_Loader *loader)
+{
+    if(loader != NULL)
+    {
+        SDL_ILBM_Request *request;
+        unsigned int i;
+
+        /* Take all pending requests and tell the worker threads to stop */
+        if(loader->mutex != NULL)
+            SDL_LockMutex(loader->mutex);
+
+        request = loader->queue;
+        loader->queue = NULL;
+        loader->quit = TRUE;
+
+        if(loader->cond != NULL)
+            SDL_CondBroadcast(loader->cond);
+
+        if(loader->mutex != NULL)
+            SDL_UnlockMutex(loader->mutex);
+
+        while(request != NULL)
+        {
+            SDL_ILBM_Request *next = request->next;
+            finishRequest(loader, request, SDL_ILBM_REQUEST_CANCELLED);
+            request = next;
+        }
+
+        /* Wait for the running requests to finish */
+        for(i = 0; i < loader->threadsLength; i++)
+            SDL_WaitThread(loader->threads[i], NULL);
+
+        SDL_ILBM_free(loader->threads);
+
+        if(loader->cond != NULL)
+            SDL_DestroyCond(loader->cond);
+
+        if(loader->mutex != NULL)
+            SDL_DestroyMutex(loader->mutex);
+
+        SDL_ILBM_free(loader);
+    }
+}
+
+static amiVideo_Bool requestsConflict(const SDL_ILBM_Request *request1, const SDL_ILBM_Request *request2)
+{
+    /* Composing an image may modify the ILBM image in the set, so it must not be used by two threads at the same time */
+    return (request1->type != SDL_ILBM_SET_REQUEST && request2->type != SDL_ILBM_SET_REQUEST && request1->set == request2->set && request1->index == request2->index);
+}
+
+static amiVideo_Bool conflictsWithRunningRequest(const SDL_ILBM_Loader *loader, const SDL_ILBM_Request *request)
+{
+    const SDL_ILBM_Request *runningRequest;
+
+    for(runningRequest = loader->running; runningRequest != NULL; runningRequest = runningRequest->next)
+    {
+        if(requestsConflict(runningRequest, request))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/* Moves the first pending request that can be processed right away to the running requests. The mutex must be held */
+
+static SDL_ILBM_Request *takeRequest(SDL_ILBM_Loader *loader)
+{
+    SDL_ILBM_Request **link;
+
+    for(link = &loader->queue; *link != NULL; link = &(*link)->next)
+    {
+        SDL_ILBM_Request *request = *link;
+
+        if(!conflictsWithRunningRequest(loader, request))
+        {
+            *link = request->next;
+            request->next = loader->running;
+            loader->running = request;
+            return request;
+        }
+    }
+
+    return NULL;
+}
+
+static void removeRunningRequest(SDL_ILBM_Loader *loader, const SDL_ILBM_Request *request)
+{
+    SDL_ILBM_Request **link;
+
+    for(link = &loader->running; *link != NULL; link = &(*link)->next)
+    {
+        if(*link == request)
+        {
+            *link = request->next;
+            break;
+        }
+    }
+}
+
+static void discardResult(SDL_ILBM_Request *request)
+{
+    SDL_ILBM_freeSet(request->resultSet);
+    SDL_ILBM_freeImage(request->resultImage);
+    SDL_FreeSurface(request->resultSurface);
+
+    request->resultSet = NULL;
+    request->resultImage = NULL;
+    request->resultSurface = NULL;
+}
+
+static SDL_ILBM_RequestStatus processRequest(SDL_ILBM_Request *request)
+{
+    amiVideo_Bool composed;
+
+    switch(request->type)
+    {
+        case SDL_ILBM_SET_REQUEST:
+            request->resultSet = SDL_ILBM_createSet(request->filename);
+            composed = (request->resultSet != NULL);
+            break;
+        case SDL_ILBM_IMAGE_REQUEST:
+            request->resultImage = SDL_ILBM_createImageFromSet(request->set, request->index, request->lowresPixelScaleFactor, request->format);
+            composed = (request->resultImage != NULL);
+            break;
+        case SDL_ILBM_SURFACE_REQUEST:
+            request->resultSurface = SDL_ILBM_createSurfaceFromSet(request->set, request->index, request->lowresPixelScaleFactor, request->format);
+            composed = (request->resultSurface != NULL);
+            break;
+        default:
+            composed = FALSE;
+    }
+
+    if(SDL_AtomicGet(&request->cancelled))
+    {
+        discardResult(request); /* The caller is no longer interested in the result */
+        return SDL_ILBM_REQUEST_CANCELLED;
+    }
+    else if(composed)
+        return SDL_ILBM_REQUEST_COMPLETED;
+    else
+        return SDL_ILBM_REQUEST_FAILED;
+}
+
+static int processRequests(void *data)
+{
+    SDL_ILBM_Loader *loader = (SDL_ILBM_Loader*)data;
+
+    SDL_LockMutex(loader->mutex);
+
+    while(!loader->quit)
+    {
+        SDL_ILBM_Request *request = takeRequest(loader);
+
+        if(request == NULL)
+            SDL_CondWait(loader->cond, loader->mutex); /* Wait for new requests or for conflicting requests to finish */
+        else
+        {
+            SDL_ILBM_RequestStatus status;
+
+            SDL_AtomicSet(&request->status, SDL_ILBM_REQUEST_RUNNING);
+            SDL_UnlockMutex(loader->mutex);
+
+            status = processRequest(request);
+
+            SDL_LockMutex(loader->mutex);
+            removeRunningRequest(loader, request);
+            SDL_CondBroadcast(loader->cond); /* Requests for the same image may be processed now */
+            SDL_UnlockMutex(loader->mutex);
+
+            finishRequest(loader, request, status);
+
+            SDL_LockMutex(loader->mutex);
+        }
+    }
+
+    SDL_UnlockMutex(loader->mutex);
+    return 0;
+}
+
+static SDL_ILBM_Request *createRequest(const SDL_ILBM_RequestType type, const int priority, SDL_ILBM_RequestCallback callback, void *userData)
+{
+    SDL_ILBM_Request *request = (SDL_ILBM_Request*)SDL_ILBM_malloc(sizeof(SDL_ILBM_Request));
+
+    if(request != NULL)
+    {
+        request->type = type;
+        request->filename = NULL;
+        request->set = NULL;
+        request->index = 0;
+        request->lowresPixelScaleFactor = 0;
+        request->format = SDL_ILBM_AUTO_FORMAT;
+        request->priority = priority;
+        request->callback = callback;
+        request->userData = userData;
+        SDL_AtomicSet(&request->status, SDL_ILBM_REQUEST_PENDING);
+        SDL_AtomicSet(&request->cancelled, FALSE);
+        request->resultSet = NULL;
+        request->resultImage = NULL;
+        request->resultSurface = NULL;
+        request->next = NULL;
+    }
+
+    return request;
+}
+
+/* Inserts a request after all pending requests with the same or a higher priority */
+
+static SDL_ILBM_Request *queueRequest(SDL_ILBM_Loader *loader, SDL_ILBM_Request *request)
+{
+    SDL_ILBM_Request **link;
+
+    SDL_LockMutex(loader->mutex);
+
+    for(link = &loader->queue; *link != NULL && (*link)->priority >= request->priority; link = &(*link)->next);
+
+    request->next = *link;
+    *link = request;
+
+    SDL_CondSignal(loader->cond);
+    SDL_UnlockMutex(loader->mutex);
+
+    return request;
+}
+
+SDL_ILBM_Request *SDL_ILBM_loadSetAsync(SDL_ILBM_Loader *loader, const char *filename, const int priority, SDL_ILBM_RequestCallback callback, void *userData)
+{
+    SDL_ILBM_Request *request = createRequest(SDL_ILBM_SET_REQUEST, priority, callback, userData);
+
+    if(request == NULL)
+        return NULL;
+
+    if(filename != NULL)
+    {
+        request->filename = (char*)SDL_ILBM_malloc(strlen(filename) + 1);
+
+        if(request->filename == NULL)
+        {
+            SDL_ILBM_freeRequest(request);
+            return NULL;
+        }
+
+        strcpy(request->filename, filename);
+    }
+
+    return queueRequest(loader, request);
+}
+
+static SDL_ILBM_Request *loadFromSetAsync(SDL_ILBM_Loader *loader, const SDL_ILBM_RequestType type, const SDL_ILBM_Set *set, const unsigned int index, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format, const int priority, SDL_ILBM_RequestCallback callback, void *userData)
+{
+    SDL_ILBM_Request *request = createRequest(type, priority, callback, userData);
+
+    if(request == NULL)
+        return NULL;
+
+    request->set = set;
+    request->index = index;
+    request->lowresPixelScaleFactor = lowresPixelScaleFactor;
+    request->format = format;
+
+    return queueRequest(loader, request);
+}
+
+SDL_ILBM_Request *SDL_ILBM_loadImageFromSetAsync(SDL_ILBM_Loader *loader, const SDL_ILBM_Set *set, const unsigned int index, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format, const int priority, SDL_ILBM_RequestCallback callback, void *userData)
+{
+    return loadFromSetAsync(loader, SDL_ILBM_IMAGE_REQUEST, set, index, lowresPixelScaleFactor, format, priority, callback, userData);
+}
+
+SDL_ILBM_Request *SDL_ILBM_loadSurfaceFromSetAsync(SDL_ILBM_Loader *loader, const SDL_ILBM_Set *set, const unsigned int index, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format, const int priority, SDL_ILBM_RequestCallback callback, void *userData)
+{
+    return loadFromSetAsync(loader, SDL_ILBM_SURFACE_REQUEST, set, index, lowresPixelScaleFactor, format, priority, callback, userData);
+}
+
+amiVideo_Bool SDL_ILBM_cancelRequest(SDL_ILBM_Loader *loader, SDL_ILBM_Request *request)
+{
+    SDL_ILBM_Request **link;
+
+    SDL_LockMutex(loader->mutex);
+
+    for(link = &loader->queue; *link != NULL; link = &(*link)->next)
+    {
+        if(*link == request)
+        {
+            /* The request is still pending => remove it from the queue and finish it right away */
+            *link = request->next;
+            SDL_UnlockMutex(loader->mutex);
+
+            finishRequest(loader, request, SDL_ILBM_REQUEST_CANCELLED);
+            return TRUE;
+        }
+    }
+
+    /* The request is running or has finished => its result is discarded once it is composed */
+    SDL_AtomicSet(&request->cancelled, TRUE);
+    SDL_UnlockMutex(loader->mutex);
+
+    return FALSE;
+}
+
+SDL_ILBM_RequestStatus SDL_ILBM_getRequestStatus(SDL_ILBM_Request *request)
+{
+    return (SDL_ILBM_RequestStatus)SDL_AtomicGet(&request->status);
+}
+
+void SDL_ILBM_freeRequest(SDL_ILBM_Request *request)
+{
+    if(request != NULL)
+    {
+        SDL_ILBM_free(request->filename);
+        SDL_ILBM_free(request);
+    }
+}
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#ifndef __SDL_ILBM_LOADER_H
+#define __SDL_ILBM_LOADER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SDL_ILBM_Loader SDL_ILBM_Loader;
+typedef struct SDL_ILBM_Request SDL_ILBM_Request;
+
+#include <SDL.h>
+#include "set.h"
+#include "image.h"
+
+/**
+ * @brief Enumerates the kinds of objects a loader can compose.
+ */
+typedef enum
+{
+    /** Opens and parses an IFF file to compose an SDL_ILBM_Set */
+    SDL_ILBM_SET_REQUEST = 0,
+    /** Composes a cyclable SDL_ILBM_Image from an image in a set */
+    SDL_ILBM_IMAGE_REQUEST = 1,
+    /** Composes an SDL_Surface from an image in a set */
+    SDL_ILBM_SURFACE_REQUEST = 2
+}
+SDL_ILBM_RequestType;
+
+/**
+ * @brief Enumerates the states of a request.
+ */
+typedef enum
+{
+    /** The request waits in the queue */
+    SDL_ILBM_REQUEST_PENDING = 0,
+    /** The request is processed by a worker thread */
+    SDL_ILBM_REQUEST_RUNNING = 1,
+    /** The request has completed and its result is available */
+    SDL_ILBM_REQUEST_COMPLETED = 2,
+    /** The request has completed, but its result could not be composed */
+    SDL_ILBM_REQUEST_FAILED = 3,
+    /** The request has been cancelled and has no result */
+    SDL_ILBM_REQUEST_CANCELLED = 4
+}
+SDL_ILBM_RequestStatus;
+
+/**
+ * Function that is invoked when a request has completed, failed or has been
+ * cancelled. It is invoked by the thread finishing the request, which is
+ * usually a worker thread of the loader. The status of the request is
+ * published after the callback has returned, so the callback must not free
+ * the request, and SDL_ILBM_getRequestStatus() does not report it as
+ * finished yet.
+ *
+ * @param request The finished request
+ * @param userData Pointer provided by the caller of the request
+ */
+typedef void (*SDL_ILBM_RequestCallback) (SDL_ILBM_Request *request, void *userData);
+
+/**
+ * @brief A request to compose a set, image or surface on a worker thread of a loader
+ */
+struct SDL_ILBM_Request
+{
+    /** Specifies what the request composes */
+    SDL_ILBM_RequestType type;
+
+    /** Path to the IFF file of a set request or NULL to read from the standard input */
+    char *filename;
+
+    /** Set containing the image of an image or surface request */
+    const SDL_ILBM_Set *set;
+
+    /** Index of the image in the set */
+    unsigned int index;
+
+    /** Specifies the width of a lowres pixel */
+    unsigned int lowresPixelScaleFactor;
+
+    /** Defines to which format the output must be converted */
+    SDL_ILBM_Format format;
+
+    /** Requests having a higher priority are processed first. Requests having the same priority are processed in order */
+    int priority;
+
+    /** Function invoked when the request has finished or NULL */
+    SDL_ILBM_RequestCallback callback;
+
+    /** Pointer passed to the callback and completion event */
+    void *userData;
+
+    /** One of the SDL_ILBM_RequestStatus values */
+    SDL_atomic_t status;
+
+    /** Indicates whether the caller has cancelled the request */
+    SDL_atomic_t cancelled;
+
+    /** Resulting set of a completed set request. It is owned by the caller */
+    SDL_ILBM_Set *resultSet;
+
+    /** Resulting image of a completed image request. It is owned by the caller */
+    SDL_ILBM_Image *resultImage;
+
+    /** Resulting surface of a completed surface request. It is owned by the caller */
+    SDL_Surface *resultSurface;
+
+    /** Next request in the queue or in the list of running requests. This field is for internal use only */
+    SDL_ILBM_Request *next;
+};
+
+/**
+ * @brief A pool of worker threads that composes sets, images and surfaces in
+ * the background
+ */
+struct SDL_ILBM_Loader
+{
+    /** Worker threads processing the requests */
+    SDL_Thread **threads;
+
+    /** Specifies the length of the threads array */
+    unsigned int threadsLength;
+
+    /** Requests that are processed by the worker threads */
+    SDL_ILBM_Request *running;
+
+    /** Queue of pending requests ordered by their priorities */
+    SDL_ILBM_Request *queue;
+
+    /** Protects the queue and the running requests */
+    SDL_mutex *mutex;
+
+    /** Signals worker threads that a request has been queued or that they must stop */
+    SDL_cond *cond;
+
+    /** Indicates whether the worker threads must stop */
+    amiVideo_Bool quit;
+
+    /** Type of the SDL_USEREVENT that is pushed when a request has finished or 0 if no events are pushed */
+    Uint32 eventType;
+};
+
+/**
+ * Creates a loader with a pool of worker threads.
+ *
+ * @param numOfThreads Amount of worker threads or 0 to use one thread per CPU
+ * @param pushEvents TRUE to push an SDL event of type eventType when a request has finished. The code of its user event is the request's status, data1 refers to the request and data2 is the request's user data
+ * @return An SDL_ILBM_Loader instance or NULL in case of an error. The result must be freed with SDL_ILBM_freeLoader()
+ */
+SDL_ILBM_Loader *SDL_ILBM_createLoader(unsigned int numOfThreads, const amiVideo_Bool pushEvents);
+
+/**
+ * Cancels all pending requests, waits for the worker threads to finish their
+ * current requests and frees the loader from memory. The requests themselves
+ * are not freed.
+ *
+ * @param loader An SDL_ILBM_Loader instance
+ */
+void SDL_ILBM_freeLoader(SDL_ILBM_Loader *loader);
+
+/**
+ * Requests a set to be composed by opening a file with a specified filename.
+ *
+ * @param loader An SDL_ILBM_Loader instance
+ * @param filename Path to an IFF file to open or NULL to read from the standard input
+ * @param priority Priority of the request
+ * @param callback Function invoked when the request has finished or NULL
+ * @param userData Pointer passed to the callback and completion event
+ * @return An SDL_ILBM_Request instance or NULL in case of an error. It must be freed with SDL_ILBM_freeRequest() after it has finished
+ */
+SDL_ILBM_Request *SDL_ILBM_loadSetAsync(SDL_ILBM_Loader *loader, const char *filename, const int priority, SDL_ILBM_RequestCallback callback, void *userData);
+
+/**
+ * Requests a cyclable SDL_ILBM_Image to be composed from an image in the set.
+ * Requests referring to the same image of a set are never processed at the
+ * same time. The set must not be freed before the request has finished.
+ *
+ * @param loader An SDL_ILBM_Loader instance
+ * @param set An SDL_ILBM_Set containing images
+ * @param index Index of the image in the set
+ * @param lowresPixelScaleFactor Specifies the width of a lowres pixel
+ * @param format Defines to which format the output must be converted
+ * @param priority Priority of the request
+ * @param callback Function invoked when the request has finished or NULL
+ * @param userData Pointer passed to the callback and completion event
+ * @return An SDL_ILBM_Request instance or NULL in case of an error. It must be freed with SDL_ILBM_freeRequest() after it has finished
+ */
+SDL_ILBM_Request *SDL_ILBM_loadImageFromSetAsync(SDL_ILBM_Loader *loader, const SDL_ILBM_Set *set, const unsigned int index, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format, const int priority, SDL_ILBM_RequestCallback callback, void *userData);
+
+/**
+ * Requests an SDL_Surface to be composed from an image in the set. The
+ * resulting surface is ready to be uploaded to a texture. Requests referring
+ * to the same image of a set are never processed at the same time. The set
+ * must not be freed before the request has finished.
+ *
+ * @param loader An SDL_ILBM_Loader instance
+ * @param set An SDL_ILBM_Set containing images
+ * @param index Index of the image in the set
+ * @param lowresPixelScaleFactor Specifies the width of a lowres pixel
+ * @param format Defines to which format the output must be converted
+ * @param priority Priority of the request
+ * @param callback Function invoked when the request has finished or NULL
+ * @param userData Pointer passed to the callback and completion event
+ * @return An SDL_ILBM_Request instance or NULL in case of an error. It must be freed with SDL_ILBM_freeRequest() after it has finished
+ */
+SDL_ILBM_Request *SDL_ILBM_loadSurfaceFromSetAsync(SDL_ILBM_Loader *loader, const SDL_ILBM_Set *set, const unsigned int index, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format, const int priority, SDL_ILBM_RequestCallback callback, void *userData);
+
+/**
+ * Cancels a request. A pending request is removed from the queue and finishes
+ * immediately. The result of a running request is discarded once it has been
+ * composed. A cancelled request still finishes with a callback or event.
+ *
+ * @param loader An SDL_ILBM_Loader instance
+ * @param request A request of the loader
+ * @return TRUE if the request was still pending, else FALSE
+ */
+amiVideo_Bool SDL_ILBM_cancelRequest(SDL_ILBM_Loader *loader, SDL_ILBM_Request *request);
+
+/**
+ * Returns the status of a request. Once it reports the request as finished,
+ * the loader no longer uses the request. A request must be freed either by a
+ * caller polling its status, or by the handler of its completion event, but
+ * not by both.
+ *
+ * @param request An SDL_ILBM_Request instance
+ * @return One of the SDL_ILBM_RequestStatus values
+ */
+SDL_ILBM_RequestStatus SDL_ILBM_getRequestStatus(SDL_ILBM_Request *request);
+
+/**
+ * Frees a finished request from memory. Its result, if any, is owned by the
+ * caller and is not freed.
+ *
+ * @param request An SDL_ILBM_Request instance
+ */
+void SDL_ILBM_freeRequest(SDL_ILBM_Request *request);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
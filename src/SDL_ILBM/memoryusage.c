@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#include "memoryusage.h"
+#include <string.h>
+
+#define NUM_OF_PROPERTY_CHUNKS 8
+
+static size_t computeChunkSize(const void *chunk)
+{
+    if(chunk == NULL)
+        return 0;
+    else
+        return ((const IFF_Chunk*)chunk)->chunkSize;
+}
+
+/* Collects the chunks that may be inherited from a PROP chunk, so that these can be shared among images */
+
+static void collectPropertyChunks(const ILBM_Image *image, const void **chunks)
+{
+    chunks[0] = image->bitMapHeader;
+    chunks[1] = image->colorMap;
+    chunks[2] = image->cmykMap;
+    chunks[3] = image->colorNames;
+    chunks[4] = image->viewport;
+    chunks[5] = image->destMerge;
+    chunks[6] = image->sprite;
+    chunks[7] = image->grab;
+}
+
+static amiVideo_Bool chunkIsSharedWithPreviousImage(const SDL_ILBM_Set *set, const unsigned int index, const void *chunk)
+{
+    unsigned int i;
+
+    for(i = 0; i < index; i++)
+    {
+        const void *chunks[NUM_OF_PROPERTY_CHUNKS];
+        unsigned int j;
+
+        collectPropertyChunks(set->ilbmImages[i], chunks);
+
+        for(j = 0; j < NUM_OF_PROPERTY_CHUNKS; j++)
+        {
+            if(chunks[j] == chunk)
+                return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+static void addILBMImageMemoryUsage(const SDL_ILBM_Set *set, const unsigned int index, SDL_ILBM_MemoryUsage *usage)
+{
+    const ILBM_Image *image = set->ilbmImages[index];
+    const void *chunks[NUM_OF_PROPERTY_CHUNKS];
+    unsigned int i;
+
+    collectPropertyChunks(image, chunks);
+
+    for(i = 0; i < NUM_OF_PROPERTY_CHUNKS; i++)
+    {
+        if(!chunkIsSharedWithPreviousImage(set, index, chunks[i]))
+            usage->chunks += computeChunkSize(chunks[i]);
+    }
+
+    for(i = 0; i < image->colorRangeLength; i++)
+        usage->chunks += computeChunkSize(image->colorRange[i]);
+
+    for(i = 0; i < image->drangeLength; i++)
+        usage->chunks += computeChunkSize(image->drange[i]);
+
+    for(i = 0; i < image->cycleInfoLength; i++)
+        usage->chunks += computeChunkSize(image->cycleInfo[i]);
+
+    usage->bodies += computeChunkSize(image->body);
+    usage->bitplanes += computeChunkSize(image->bitplanes);
+    usage->bookkeeping += sizeof(ILBM_Image*) + sizeof(ILBM_Image);
+}
+
+void SDL_ILBM_getSetMemoryUsage(const SDL_ILBM_Set *set, SDL_ILBM_MemoryUsage *usage)
+{
+    unsigned int i;
+
+    memset(usage, '\0', sizeof(SDL_ILBM_MemoryUsage));
+
+    usage->bookkeeping = sizeof(SDL_ILBM_Set);
+
+    for(i = 0; i < set->imagesLength; i++)
+        addILBMImageMemoryUsage(set, i, usage);
+}
+
+static size_t computeSurfaceSize(const SDL_Surface *surface)
+{
+    if(surface == NULL || (surface->flags & SDL_PREALLOC))
+        return 0; /* The pixels are owned by someone else */
+    else
+        return (size_t)surface->h * surface->pitch;
+}
+
+static size_t computeScreenBuffersSize(const amiVideo_Screen *screen)
+{
+    size_t size = screen->palette.bitplaneFormat.numOfColors * sizeof(amiVideo_Color) + screen->palette.chunkyFormat.numOfColors * sizeof(amiVideo_OutputColor);
+
+    if(screen->bitplaneFormat.memoryAllocated)
+        size += (size_t)screen->bitplaneFormat.pitch * screen->height * screen->bitplaneDepth;
+
+    if(screen->uncorrectedChunkyFormat.memoryAllocated)
+        size += (size_t)screen->uncorrectedChunkyFormat.pitch * screen->height;
+
+    if(screen->uncorrectedRGBFormat.memoryAllocated)
+        size += (size_t)screen->uncorrectedRGBFormat.pitch * screen->height;
+
+    return size;
+}
+
+void SDL_ILBM_getImageMemoryUsage(const SDL_ILBM_Image *image, SDL_ILBM_MemoryUsage *usage)
+{
+    memset(usage, '\0', sizeof(SDL_ILBM_MemoryUsage));
+
+    usage->screenBuffers = computeScreenBuffersSize(&image->screen);
+    usage->surface = computeSurfaceSize(image->surface);
+    usage->paletteCache = SDL_ILBM_computePaletteCacheSize(image->paletteCache);
+
+    /* An arena contains the image, its range times and its displays */
+    if(image->arena == NULL)
+        usage->bookkeeping = sizeof(SDL_ILBM_Image);
+    else
+        usage->bookkeeping = SDL_ILBM_computeArenaObjectSize(sizeof(SDL_ILBM_Arena)) + image->arena->size;
+
+    if(image->rangeTimes.memory != NULL)
+        usage->bookkeeping += SDL_ILBM_computeRangeTimesSize(image->image, image->rangeTimes.baseColorsLength);
+}
+
+void SDL_ILBM_getDisplayMemoryUsage(const SDL_ILBM_Display *display, SDL_ILBM_MemoryUsage *usage)
+{
+    memset(usage, '\0', sizeof(SDL_ILBM_MemoryUsage));
+
+    if(display->mustFreeBlitSurface)
+        usage->blitSurface = computeSurfaceSize(display->blitSurface);
+
+    if(display->arena == NULL)
+        usage->bookkeeping = sizeof(SDL_ILBM_Display); /* Displays in an arena are accounted for by their image */
+}
+
+void SDL_ILBM_addMemoryUsage(SDL_ILBM_MemoryUsage *total, const SDL_ILBM_MemoryUsage *usage)
+{
+    total->chunks += usage->chunks;
+    total->bodies += usage->bodies;
+    total->bitplanes += usage->bitplanes;
+    total->screenBuffers += usage->screenBuffers;
+    total->surface += usage->surface;
+    total->blitSurface += usage->blitSurface;
+    total->paletteCache += usage->paletteCache;
+    total->bookkeeping += usage->bookkeeping;
+}
+
+size_t SDL_ILBM_computeTotalMemoryUsage(const SDL_ILBM_MemoryUsage *usage)
+{
+    return usage->chunks + usage->bodies + usage->bitplanes + usage->screenBuffers + usage->surface + usage->blitSurface + usage->paletteCache + usage->bookkeeping;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#ifndef __SDL_ILBM_MEMORYUSAGE_H
+#define __SDL_ILBM_MEMORYUSAGE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "set.h"
+#include "image.h"
+#include "display.h"
+
+/**
+ * @brief Breaks down the amount of memory that an object holds by category.
+ * All sizes are in bytes.
+ */
+typedef struct
+{
+    /** Parsed IFF chunks other than bodies, such as bitmap headers, color maps and color ranges */
+    size_t chunks;
+
+    /** Bodies of the images. A body is unpacked once an image has been composed from it */
+    size_t bodies;
+
+    /** Deinterleaved copies of ILBM bodies */
+    size_t bitplanes;
+
+    /** Uncorrected pixel buffers, bitplanes and palettes allocated by libamivideo */
+    size_t screenBuffers;
+
+    /** Pixels of the output surface. A chunky surface referring to the body of a PBM image is accounted for by its set */
+    size_t surface;
+
+    /** Pixels of a conversion surface that is blitted to textures */
+    size_t blitSurface;
+
+    /** Precomputed palettes and frames of a cyclable image */
+    size_t paletteCache;
+
+    /** Structs and range times of this library */
+    size_t bookkeeping;
+}
+SDL_ILBM_MemoryUsage;
+
+/**
+ * Determines how much memory a set holds, including the images it contains.
+ *
+ * @param set An SDL_ILBM_Set instance
+ * @param usage Memory usage that is set to the amounts the set holds
+ */
+void SDL_ILBM_getSetMemoryUsage(const SDL_ILBM_Set *set, SDL_ILBM_MemoryUsage *usage);
+
+/**
+ * Determines how much memory an image holds. The chunks and bodies of the ILBM
+ * image it has been composed from belong to its set.
+ *
+ * @param image An SDL_ILBM_Image instance
+ * @param usage Memory usage that is set to the amounts the image holds
+ */
+void SDL_ILBM_getImageMemoryUsage(const SDL_ILBM_Image *image, SDL_ILBM_MemoryUsage *usage);
+
+/**
+ * Determines how much memory a display holds. Textures are owned by the
+ * renderer and are not accounted for.
+ *
+ * @param display An SDL_ILBM_Display instance
+ * @param usage Memory usage that is set to the amounts the display holds
+ */
+void SDL_ILBM_getDisplayMemoryUsage(const SDL_ILBM_Display *display, SDL_ILBM_MemoryUsage *usage);
+
+/**
+ * Adds the amounts of a memory usage to another, so that the usage of multiple
+ * objects can be combined.
+ *
+ * @param total Memory usage to which the amounts are added
+ * @param usage Memory usage to add
+ */
+void SDL_ILBM_addMemoryUsage(SDL_ILBM_MemoryUsage *total, const SDL_ILBM_MemoryUsage *usage);
+
+/**
+ * Computes the sum of all categories of a memory usage.
+ *
+ * @param usage A memory usage
+ * @return The total amount of bytes
+ */
+size_t SDL_ILBM_computeTotalMemoryUsage(const SDL_ILBM_MemoryUsage *usage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#include "palettecache.h"
+#include "allocator.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Upper bound on the amount of states, so that the hash table size and the state indexes cannot overflow */
+#define MAX_STATES 0x1000000
+
+#define FNV_OFFSET_BASIS 2166136261U
+#define FNV_PRIME 16777619U
+
+static Uint32 computeHash(const void *data, const size_t size)
+{
+    size_t i;
+    const Uint8 *bytes = (const Uint8*)data;
+    Uint32 hash = FNV_OFFSET_BASIS;
+
+    for(i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+SDL_ILBM_PaletteCache *SDL_ILBM_createPaletteCache(const unsigned int offsetsLength, const unsigned int maxStates, const size_t bitplaneColorsSize, const size_t chunkyColorsSize, const size_t frameSize, const size_t maxFramesSize)
+{
+    SDL_ILBM_PaletteCache *paletteCache;
+
+    if(offsetsLength == 0 || maxStates == 0 || maxStates > MAX_STATES || offsetsLength > (size_t)-1 / sizeof(unsigned int) / maxStates)
+        return NULL; /* Without ranges there are no states to distinguish */
+
+    paletteCache = (SDL_ILBM_PaletteCache*)SDL_ILBM_malloc(sizeof(SDL_ILBM_PaletteCache));
+
+    if(paletteCache != NULL)
+    {
+        unsigned int i;
+
+        paletteCache->offsetsLength = offsetsLength;
+        paletteCache->maxStates = maxStates;
+        paletteCache->statesLength = 0;
+        paletteCache->palettesLength = 0;
+        paletteCache->bitplaneColorsSize = bitplaneColorsSize;
+        paletteCache->chunkyColorsSize = chunkyColorsSize;
+        paletteCache->frameSize = frameSize;
+        paletteCache->maxFramesSize = maxFramesSize;
+        paletteCache->framesSize = 0;
+
+        /* Keep the load factor of the hash table at or below one half */
+        paletteCache->slotsLength = 1;
+
+        while(paletteCache->slotsLength < 2 * maxStates)
+            paletteCache->slotsLength <<= 1;
+
+        paletteCache->stateOffsets = (unsigned int*)SDL_ILBM_malloc((size_t)maxStates * offsetsLength * sizeof(unsigned int));
+        paletteCache->statePalettes = (unsigned int*)SDL_ILBM_malloc(maxStates * sizeof(unsigned int));
+        paletteCache->palettes = (SDL_ILBM_CachedPalette*)SDL_ILBM_malloc(maxStates * sizeof(SDL_ILBM_CachedPalette));
+        paletteCache->slots = (int*)SDL_ILBM_malloc(paletteCache->slotsLength * sizeof(int));
+        paletteCache->currentOffsets = (unsigned int*)SDL_ILBM_malloc(offsetsLength * sizeof(unsigned int));
+
+        if(paletteCache->stateOffsets == NULL || paletteCache->statePalettes == NULL || paletteCache->palettes == NULL || paletteCache->slots == NULL || paletteCache->currentOffsets == NULL)
+        {
+            SDL_ILBM_freePaletteCache(paletteCache);
+            return NULL;
+        }
+
+        for(i = 0; i < paletteCache->slotsLength; i++)
+            paletteCache->slots[i] = -1;
+    }
+
+    return paletteCache;
+}
+
+void SDL_ILBM_freePaletteCache(SDL_ILBM_PaletteCache *paletteCache)
+{
+    if(paletteCache != NULL)
+    {
+        if(paletteCache->palettes != NULL)
+        {
+            unsigned int i;
+
+            for(i = 0; i < paletteCache->palettesLength; i++)
+            {
+                SDL_ILBM_CachedPalette *palette = &paletteCache->palettes[i];
+
+                SDL_ILBM_free(palette->bitplaneColors);
+                SDL_ILBM_free(palette->chunkyColors);
+                SDL_ILBM_free(palette->pixels);
+            }
+        }
+
+        SDL_ILBM_free(paletteCache->stateOffsets);
+        SDL_ILBM_free(paletteCache->statePalettes);
+        SDL_ILBM_free(paletteCache->palettes);
+        SDL_ILBM_free(paletteCache->slots);
+        SDL_ILBM_free(paletteCache->currentOffsets);
+        SDL_ILBM_free(paletteCache);
+    }
+}
+
+/* Searches the slot of a state. Returns the slot containing the state or the empty slot where it should be inserted */
+
+static unsigned int searchSlot(const SDL_ILBM_PaletteCache *paletteCache, const unsigned int *offsets)
+{
+    size_t offsetsSize = paletteCache->offsetsLength * sizeof(unsigned int);
+    unsigned int mask = paletteCache->slotsLength - 1;
+    unsigned int slot = computeHash(offsets, offsetsSize) & mask;
+
+    while(paletteCache->slots[slot] != -1 && memcmp(&paletteCache->stateOffsets[paletteCache->slots[slot] * paletteCache->offsetsLength], offsets, offsetsSize) != 0)
+        slot = (slot + 1) & mask;
+
+    return slot;
+}
+
+SDL_ILBM_CachedPalette *SDL_ILBM_lookupPaletteCache(const SDL_ILBM_PaletteCache *paletteCache, const unsigned int *offsets)
+{
+    int state = paletteCache->slots[searchSlot(paletteCache, offsets)];
+
+    if(state == -1)
+        return NULL;
+    else
+        return &paletteCache->palettes[paletteCache->statePalettes[state]];
+}
+
+static SDL_ILBM_CachedPalette *searchPalette(SDL_ILBM_PaletteCache *paletteCache, const Uint32 hash, const void *bitplaneColors)
+{
+    unsigned int i;
+
+    for(i = 0; i < paletteCache->palettesLength; i++)
+    {
+        SDL_ILBM_CachedPalette *palette = &paletteCache->palettes[i];
+
+        if(palette->hash == hash && memcmp(palette->bitplaneColors, bitplaneColors, paletteCache->bitplaneColorsSize) == 0)
+            return palette;
+    }
+
+    return NULL;
+}
+
+static SDL_ILBM_CachedPalette *addPalette(SDL_ILBM_PaletteCache *paletteCache, const Uint32 hash, const void *bitplaneColors, const void *chunkyColors)
+{
+    SDL_ILBM_CachedPalette *palette = &paletteCache->palettes[paletteCache->palettesLength];
+
+    palette->hash = hash;
+    palette->bitplaneColors = SDL_ILBM_malloc(paletteCache->bitplaneColorsSize);
+    palette->pixels = NULL;
+
+    if(paletteCache->chunkyColorsSize > 0)
+        palette->chunkyColors = SDL_ILBM_malloc(paletteCache->chunkyColorsSize);
+    else
+        palette->chunkyColors = NULL;
+
+    /* Count the palette, so that it gets freed, even if not all of its properties could be allocated */
+    paletteCache->palettesLength++;
+
+    if(palette->bitplaneColors == NULL || (paletteCache->chunkyColorsSize > 0 && palette->chunkyColors == NULL))
+        return NULL;
+
+    memcpy(palette->bitplaneColors, bitplaneColors, paletteCache->bitplaneColorsSize);
+
+    if(palette->chunkyColors != NULL)
+        memcpy(palette->chunkyColors, chunkyColors, paletteCache->chunkyColorsSize);
+
+    return palette;
+}
+
+SDL_ILBM_CachedPalette *SDL_ILBM_insertPaletteCache(SDL_ILBM_PaletteCache *paletteCache, const unsigned int *offsets, const void *bitplaneColors, const void *chunkyColors)
+{
+    unsigned int slot = searchSlot(paletteCache, offsets);
+
+    if(paletteCache->slots[slot] != -1)
+        return &paletteCache->palettes[paletteCache->statePalettes[paletteCache->slots[slot]]]; /* The state is already known */
+    else if(paletteCache->statesLength >= paletteCache->maxStates)
+        return NULL; /* The cache is full */
+    else
+    {
+        Uint32 hash = computeHash(bitplaneColors, paletteCache->bitplaneColorsSize);
+        SDL_ILBM_CachedPalette *palette = searchPalette(paletteCache, hash, bitplaneColors);
+
+        if(palette == NULL)
+        {
+            /* This palette has not been seen before => add it */
+            palette = addPalette(paletteCache, hash, bitplaneColors, chunkyColors);
+
+            if(palette == NULL)
+                return NULL;
+        }
+
+        /* Add the state and let it refer to the palette */
+        memcpy(&paletteCache->stateOffsets[paletteCache->statesLength * paletteCache->offsetsLength], offsets, paletteCache->offsetsLength * sizeof(unsigned int));
+        paletteCache->statePalettes[paletteCache->statesLength] = palette - paletteCache->palettes;
+        paletteCache->slots[slot] = paletteCache->statesLength;
+        paletteCache->statesLength++;
+
+        return palette;
+    }
+}
+
+amiVideo_Bool SDL_ILBM_storePaletteCacheFrame(SDL_ILBM_PaletteCache *paletteCache, SDL_ILBM_CachedPalette *palette, const void *pixels)
+{
+    if(palette->pixels != NULL)
+        return TRUE; /* The frame was already stored */
+    else if(paletteCache->framesSize + paletteCache->frameSize > paletteCache->maxFramesSize)
+        return FALSE; /* The frame budget does not allow it */
+    else
+    {
+        palette->pixels = SDL_ILBM_malloc(paletteCache->frameSize);
+
+        if(palette->pixels == NULL)
+            return FALSE;
+
+        memcpy(palette->pixels, pixels, paletteCache->frameSize);
+        paletteCache->framesSize += paletteCache->frameSize;
+
+        return TRUE;
+    }
+}
+
+size_t SDL_ILBM_computePaletteCacheSize(const SDL_ILBM_PaletteCache *paletteCache)
+{
+    size_t size;
+
+    if(paletteCache == NULL)
+        return 0;
+
+    size = sizeof(SDL_ILBM_PaletteCache)
+        + paletteCache->maxStates * (paletteCache->offsetsLength * sizeof(unsigned int) + sizeof(unsigned int) + sizeof(SDL_ILBM_CachedPalette))
+        + paletteCache->slotsLength * sizeof(int)
+        + paletteCache->offsetsLength * sizeof(unsigned int);
+
+    /* Every palette has its own copy of the colors, whereas the frames are accounted for separately */
+    size += paletteCache->palettesLength * (paletteCache->bitplaneColorsSize + paletteCache->chunkyColorsSize);
+    size += paletteCache->framesSize;
+
+    return size;
+}
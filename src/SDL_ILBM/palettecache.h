@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#ifndef __SDL_ILBM_PALETTECACHE_H
+#define __SDL_ILBM_PALETTECACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SDL_ILBM_PaletteCache SDL_ILBM_PaletteCache;
+
+#include <stddef.h>
+#include <SDL.h>
+#include <libamivideo/amivideotypes.h>
+
+/**
+ * @brief A distinct palette that a cyclable image can attain
+ */
+typedef struct
+{
+    /** Hash of the bitplane colors, used to deduplicate palettes */
+    Uint32 hash;
+
+    /** Bitplane colors of the palette */
+    void *bitplaneColors;
+
+    /** Colors of the palette in the chunky output format or NULL if the image does not use a chunky format */
+    void *chunkyColors;
+
+    /** A fully rendered frame using this palette or NULL if it has not been cached */
+    void *pixels;
+}
+SDL_ILBM_CachedPalette;
+
+/**
+ * @brief Maps the states of the color ranges of an image to precomputed palettes
+ */
+struct SDL_ILBM_PaletteCache
+{
+    /** Amount of range offsets that make up a state */
+    unsigned int offsetsLength;
+
+    /** Maximum amount of states that can be stored */
+    unsigned int maxStates;
+
+    /** Amount of states that have been stored */
+    unsigned int statesLength;
+
+    /** Range offsets of each state, offsetsLength elements per state */
+    unsigned int *stateOffsets;
+
+    /** Index of the palette that belongs to each state */
+    unsigned int *statePalettes;
+
+    /** Open addressing hash table referring to states or -1 for empty slots */
+    int *slots;
+
+    /** Amount of slots in the hash table (a power of two) */
+    unsigned int slotsLength;
+
+    /** Array of distinct palettes */
+    SDL_ILBM_CachedPalette *palettes;
+
+    /** Amount of distinct palettes */
+    unsigned int palettesLength;
+
+    /** Size of the bitplane colors of a palette in bytes */
+    size_t bitplaneColorsSize;
+
+    /** Size of the chunky colors of a palette in bytes or 0 if they are not stored */
+    size_t chunkyColorsSize;
+
+    /** Size of a rendered frame in bytes */
+    size_t frameSize;
+
+    /** Maximum amount of bytes that the rendered frames may occupy */
+    size_t maxFramesSize;
+
+    /** Amount of bytes occupied by rendered frames */
+    size_t framesSize;
+
+    /** Scratch buffer to store the range offsets of the current state */
+    unsigned int *currentOffsets;
+};
+
+/**
+ * Creates an empty palette cache.
+ *
+ * @param offsetsLength Amount of range offsets that make up a state
+ * @param maxStates Maximum amount of states that can be stored
+ * @param bitplaneColorsSize Size of the bitplane colors of a palette in bytes
+ * @param chunkyColorsSize Size of the chunky colors of a palette in bytes or 0 to not store them
+ * @param frameSize Size of a rendered frame in bytes
+ * @param maxFramesSize Maximum amount of bytes that rendered frames may occupy or 0 to not cache frames
+ * @return A palette cache or NULL in case of an error, or if offsetsLength or maxStates is 0 or too large. The result must be freed with SDL_ILBM_freePaletteCache()
+ */
+SDL_ILBM_PaletteCache *SDL_ILBM_createPaletteCache(const unsigned int offsetsLength, const unsigned int maxStates, const size_t bitplaneColorsSize, const size_t chunkyColorsSize, const size_t frameSize, const size_t maxFramesSize);
+
+/**
+ * Frees a palette cache and all its palettes from memory.
+ *
+ * @param paletteCache A palette cache
+ */
+void SDL_ILBM_freePaletteCache(SDL_ILBM_PaletteCache *paletteCache);
+
+/**
+ * Looks up the palette that belongs to a state of the color ranges.
+ *
+ * @param paletteCache A palette cache
+ * @param offsets Array of range offsets representing the state
+ * @return The cached palette or NULL if the state is unknown
+ */
+SDL_ILBM_CachedPalette *SDL_ILBM_lookupPaletteCache(const SDL_ILBM_PaletteCache *paletteCache, const unsigned int *offsets);
+
+/**
+ * Stores the palette that belongs to a state of the color ranges. If an
+ * identical palette has been stored before, it is shared.
+ *
+ * @param paletteCache A palette cache
+ * @param offsets Array of range offsets representing the state
+ * @param bitplaneColors Bitplane colors of the palette
+ * @param chunkyColors Chunky colors of the palette or NULL if they are not stored
+ * @return The cached palette or NULL if the cache is full
+ */
+SDL_ILBM_CachedPalette *SDL_ILBM_insertPaletteCache(SDL_ILBM_PaletteCache *paletteCache, const unsigned int *offsets, const void *bitplaneColors, const void *chunkyColors);
+
+/**
+ * Stores a rendered frame for a cached palette, if the frame budget permits it.
+ *
+ * @param paletteCache A palette cache
+ * @param palette A cached palette
+ * @param pixels Pixels of the rendered frame
+ * @return TRUE if the frame has been stored, else FALSE
+ */
+amiVideo_Bool SDL_ILBM_storePaletteCacheFrame(SDL_ILBM_PaletteCache *paletteCache, SDL_ILBM_CachedPalette *palette, const void *pixels);
+
+/**
+ * Computes the amount of bytes a palette cache occupies, including its
+ * palettes and rendered frames.
+ *
+ * @param paletteCache A palette cache or NULL
+ * @return The size of the palette cache in bytes
+ */
+size_t SDL_ILBM_computePaletteCacheSize(const SDL_ILBM_PaletteCache *paletteCache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,716 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#include "probe.h"
+#include <stdlib.h>
+#include <string.h>
+#include <libilbm/ilbmimage.h>
+#include "image2amivideo.h"
+#include "cycle.h"
+
+#define CHUNK_HEADER_SIZE 8
+#define SKIP_BUFFER_SIZE 4096
+
+#define MAX_FILE_SIZE 0x7fffffff /* Largest size an IFF chunk can declare */
+#define MAX_PROPERTY_SIZE 65536 /* Property chunks are small, larger ones are considered corrupt rather than read into memory */
+#define MAX_GROUP_DEPTH 16 /* Groups nested deeper than this are considered corrupt, so that the stack stays bounded */
+
+#define BITMAPHEADER_SIZE 20
+#define COLORRANGE_SIZE 8
+#define DRANGE_HEADER_SIZE 8
+#define CYCLEINFO_SIZE 14
+
+#define NUM_OF_IMAGE_FORM_TYPES 3
+
+static const char *imageFormTypes[] = { "ILBM", "PBM ", "ACBM" };
+
+typedef struct
+{
+    FILE *file;
+    long position;
+    unsigned int lowresPixelScaleFactor;
+    SDL_ILBM_Format format;
+    SDL_ILBM_Probe *probe;
+    unsigned int depth;
+}
+Prober;
+
+/* Reading and skipping raw data, while keeping track of the offset in the file */
+
+static amiVideo_Bool readBytes(Prober *prober, void *data, const size_t size)
+{
+    if(fread(data, 1, size, prober->file) < size)
+        return FALSE;
+
+    prober->position += size;
+    return TRUE;
+}
+
+static amiVideo_Bool skipBytes(Prober *prober, IFF_Long size)
+{
+    if(size <= 0)
+        return TRUE;
+
+    if(fseek(prober->file, size, SEEK_CUR) == 0)
+        prober->position += size;
+    else
+    {
+        /* The stream cannot seek, such as a pipe, so the data must be read and discarded */
+        IFF_UByte buffer[SKIP_BUFFER_SIZE];
+
+        while(size > 0)
+        {
+            size_t chunkSize = size > SKIP_BUFFER_SIZE ? SKIP_BUFFER_SIZE : size;
+
+            if(!readBytes(prober, buffer, chunkSize))
+                return FALSE;
+
+            size -= chunkSize;
+        }
+    }
+
+    return TRUE;
+}
+
+static IFF_UWord getUWord(const IFF_UByte *data)
+{
+    return (IFF_UWord)((data[0] << 8) | data[1]);
+}
+
+static IFF_Long getLong(const IFF_UByte *data)
+{
+    return (IFF_Long)(((IFF_ULong)data[0] << 24) | ((IFF_ULong)data[1] << 16) | ((IFF_ULong)data[2] << 8) | data[3]);
+}
+
+static amiVideo_Bool readChunkHeader(Prober *prober, IFF_UByte *chunkId, IFF_Long *chunkSize)
+{
+    IFF_UByte header[CHUNK_HEADER_SIZE];
+
+    if(!readBytes(prober, header, CHUNK_HEADER_SIZE))
+        return FALSE;
+
+    memcpy(chunkId, header, 4);
+    *chunkSize = getLong(header + 4);
+
+    return (*chunkSize >= 0);
+}
+
+/* Reads the header of a chunk and accounts for its padded size in the remaining size of the enclosing group, which it may not exceed */
+
+static amiVideo_Bool readEnclosedChunkHeader(Prober *prober, IFF_UByte *chunkId, IFF_Long *chunkSize, IFF_Long *remaining)
+{
+    if(!readChunkHeader(prober, chunkId, chunkSize))
+        return FALSE;
+
+    *remaining -= CHUNK_HEADER_SIZE;
+
+    if(*chunkSize > *remaining || (*chunkSize & 1) > *remaining - *chunkSize)
+        return FALSE;
+
+    *remaining -= *chunkSize + (*chunkSize & 1);
+    return TRUE;
+}
+
+static amiVideo_Bool idEquals(const IFF_UByte *id, const char *name)
+{
+    return (memcmp(id, name, 4) == 0);
+}
+
+/* Returns the index of a form type of which the properties are tracked, or -1 if it is not an image form type */
+
+static int lookupImageFormType(const IFF_UByte *formType)
+{
+    int i;
+
+    for(i = 0; i < NUM_OF_IMAGE_FORM_TYPES; i++)
+    {
+        if(idEquals(formType, imageFormTypes[i]))
+            return i;
+    }
+
+    return -1;
+}
+
+static amiVideo_Bool isGroup(const IFF_UByte *chunkId)
+{
+    return (idEquals(chunkId, "FORM") || idEquals(chunkId, "LIST") || idEquals(chunkId, "CAT "));
+}
+
+/* Properties of the images are kept in ILBM_Image structs, which own deep copies of their chunks */
+
+static void freeRanges(void **ranges, const unsigned int rangesLength)
+{
+    unsigned int i;
+
+    for(i = 0; i < rangesLength; i++)
+        SDL_ILBM_free(ranges[i]);
+
+    SDL_ILBM_free(ranges);
+}
+
+static void freeProperties(ILBM_Image *image)
+{
+    SDL_ILBM_free(image->bitMapHeader);
+
+    if(image->colorMap != NULL)
+        SDL_ILBM_free(image->colorMap->colorRegister);
+
+    SDL_ILBM_free(image->colorMap);
+    SDL_ILBM_free(image->viewport);
+    freeRanges((void**)image->colorRange, image->colorRangeLength);
+    freeRanges((void**)image->drange, image->drangeLength);
+    freeRanges((void**)image->cycleInfo, image->cycleInfoLength);
+
+    memset(image, '\0', sizeof(ILBM_Image));
+}
+
+static void *copyObject(const void *object, const size_t size)
+{
+    void *copy;
+
+    if(object == NULL)
+        return NULL;
+
+    if((copy = SDL_ILBM_malloc(size)) != NULL)
+        memcpy(copy, object, size);
+
+    return copy;
+}
+
+static amiVideo_Bool addRange(void ***ranges, unsigned int *rangesLength, void *range)
+{
+    void **result;
+
+    if(range == NULL)
+        return FALSE;
+
+    if((result = (void**)SDL_ILBM_realloc(*ranges, (*rangesLength + 1) * sizeof(void*))) == NULL)
+    {
+        SDL_ILBM_free(range);
+        return FALSE;
+    }
+
+    result[*rangesLength] = range;
+    *ranges = result;
+    (*rangesLength)++;
+
+    return TRUE;
+}
+
+static amiVideo_Bool copyRanges(void ***ranges, unsigned int *rangesLength, void * const *sourceRanges, const unsigned int sourceRangesLength, const size_t size)
+{
+    unsigned int i;
+
+    for(i = 0; i < sourceRangesLength; i++)
+    {
+        if(!addRange(ranges, rangesLength, copyObject(sourceRanges[i], size)))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+static amiVideo_Bool copyProperties(ILBM_Image *image, const ILBM_Image *source)
+{
+    memset(image, '\0', sizeof(ILBM_Image));
+
+    if(source->bitMapHeader != NULL && (image->bitMapHeader = (ILBM_BitMapHeader*)copyObject(source->bitMapHeader, sizeof(ILBM_BitMapHeader))) == NULL)
+        return FALSE;
+
+    if(source->colorMap != NULL)
+    {
+        if((image->colorMap = (ILBM_ColorMap*)copyObject(source->colorMap, sizeof(ILBM_ColorMap))) == NULL)
+            return FALSE;
+
+        if((image->colorMap->colorRegister = (ILBM_ColorRegister*)copyObject(source->colorMap->colorRegister, source->colorMap->colorRegisterLength * sizeof(ILBM_ColorRegister) + 1)) == NULL)
+            return FALSE;
+    }
+
+    if(source->viewport != NULL && (image->viewport = (ILBM_Viewport*)copyObject(source->viewport, sizeof(ILBM_Viewport))) == NULL)
+        return FALSE;
+
+    return copyRanges((void***)&image->colorRange, &image->colorRangeLength, (void * const *)source->colorRange, source->colorRangeLength, sizeof(ILBM_ColorRange))
+        && copyRanges((void***)&image->drange, &image->drangeLength, (void * const *)source->drange, source->drangeLength, sizeof(ILBM_DRange))
+        && copyRanges((void***)&image->cycleInfo, &image->cycleInfoLength, (void * const *)source->cycleInfo, source->cycleInfoLength, sizeof(ILBM_CycleInfo));
+}
+
+/* A PROP only applies to the forms of its own type, so the properties are kept for each image form type */
+
+static void freePropertySets(ILBM_Image *properties)
+{
+    int i;
+
+    for(i = 0; i < NUM_OF_IMAGE_FORM_TYPES; i++)
+        freeProperties(&properties[i]);
+}
+
+static amiVideo_Bool copyPropertySets(ILBM_Image *properties, const ILBM_Image *sourceProperties)
+{
+    int i;
+    amiVideo_Bool status = TRUE;
+
+    memset(properties, '\0', NUM_OF_IMAGE_FORM_TYPES * sizeof(ILBM_Image));
+
+    for(i = 0; i < NUM_OF_IMAGE_FORM_TYPES && status; i++)
+        status = copyProperties(&properties[i], &sourceProperties[i]);
+
+    return status;
+}
+
+/* Decoding the property chunks */
+
+static amiVideo_Bool parseBitMapHeader(ILBM_Image *image, const IFF_UByte *data, const IFF_Long chunkSize)
+{
+    ILBM_BitMapHeader *bitMapHeader;
+
+    if(chunkSize < BITMAPHEADER_SIZE)
+        return FALSE;
+
+    if(image->bitMapHeader == NULL && (image->bitMapHeader = (ILBM_BitMapHeader*)SDL_ILBM_calloc(1, sizeof(ILBM_BitMapHeader))) == NULL)
+        return FALSE;
+
+    bitMapHeader = image->bitMapHeader;
+    bitMapHeader->w = getUWord(data);
+    bitMapHeader->h = getUWord(data + 2);
+    bitMapHeader->x = (IFF_Word)getUWord(data + 4);
+    bitMapHeader->y = (IFF_Word)getUWord(data + 6);
+    bitMapHeader->nPlanes = data[8];
+    bitMapHeader->masking = data[9];
+    bitMapHeader->compression = data[10];
+    bitMapHeader->pad1 = data[11];
+    bitMapHeader->transparentColor = getUWord(data + 12);
+    bitMapHeader->xAspect = data[14];
+    bitMapHeader->yAspect = data[15];
+    bitMapHeader->pageWidth = (IFF_Word)getUWord(data + 16);
+    bitMapHeader->pageHeight = (IFF_Word)getUWord(data + 18);
+
+    return TRUE;
+}
+
+static amiVideo_Bool parseColorMap(ILBM_Image *image, const IFF_UByte *data, const IFF_Long chunkSize)
+{
+    ILBM_ColorRegister *colorRegister;
+    unsigned int i, colorRegisterLength = chunkSize / 3;
+
+    if((colorRegister = (ILBM_ColorRegister*)SDL_ILBM_malloc(colorRegisterLength * sizeof(ILBM_ColorRegister) + 1)) == NULL)
+        return FALSE;
+
+    for(i = 0; i < colorRegisterLength; i++)
+    {
+        colorRegister[i].red = data[i * 3];
+        colorRegister[i].green = data[i * 3 + 1];
+        colorRegister[i].blue = data[i * 3 + 2];
+    }
+
+    if(image->colorMap == NULL && (image->colorMap = (ILBM_ColorMap*)SDL_ILBM_calloc(1, sizeof(ILBM_ColorMap))) == NULL)
+    {
+        SDL_ILBM_free(colorRegister);
+        return FALSE;
+    }
+
+    SDL_ILBM_free(image->colorMap->colorRegister);
+    image->colorMap->colorRegister = colorRegister;
+    image->colorMap->colorRegisterLength = colorRegisterLength;
+
+    return TRUE;
+}
+
+static amiVideo_Bool parseViewport(ILBM_Image *image, const IFF_UByte *data, const IFF_Long chunkSize)
+{
+    if(chunkSize < 4)
+        return FALSE;
+
+    if(image->viewport == NULL && (image->viewport = (ILBM_Viewport*)SDL_ILBM_calloc(1, sizeof(ILBM_Viewport))) == NULL)
+        return FALSE;
+
+    image->viewport->viewportMode = getLong(data);
+
+    return TRUE;
+}
+
+static amiVideo_Bool parseColorRange(ILBM_Image *image, const IFF_UByte *data, const IFF_Long chunkSize)
+{
+    ILBM_ColorRange *colorRange;
+
+    if(chunkSize < COLORRANGE_SIZE)
+        return FALSE;
+
+    if((colorRange = (ILBM_ColorRange*)SDL_ILBM_calloc(1, sizeof(ILBM_ColorRange))) != NULL)
+    {
+        colorRange->pad1 = (IFF_Word)getUWord(data);
+        colorRange->rate = (IFF_Word)getUWord(data + 2);
+        colorRange->active = (IFF_Word)getUWord(data + 4);
+        colorRange->low = data[6];
+        colorRange->high = data[7];
+    }
+
+    return addRange((void***)&image->colorRange, &image->colorRangeLength, colorRange);
+}
+
+static amiVideo_Bool parseDRange(ILBM_Image *image, const IFF_UByte *data, const IFF_Long chunkSize)
+{
+    ILBM_DRange *drange;
+
+    if(chunkSize < DRANGE_HEADER_SIZE)
+        return FALSE;
+
+    /* Only the header is needed to know how the range cycles. The colors and indexes it consists of are left out */
+    if((drange = (ILBM_DRange*)SDL_ILBM_calloc(1, sizeof(ILBM_DRange))) != NULL)
+    {
+        drange->min = data[0];
+        drange->max = data[1];
+        drange->rate = (IFF_Word)getUWord(data + 2);
+        drange->flags = (IFF_Word)getUWord(data + 4);
+    }
+
+    return addRange((void***)&image->drange, &image->drangeLength, drange);
+}
+
+static amiVideo_Bool parseCycleInfo(ILBM_Image *image, const IFF_UByte *data, const IFF_Long chunkSize)
+{
+    ILBM_CycleInfo *cycleInfo;
+
+    if(chunkSize < CYCLEINFO_SIZE)
+        return FALSE;
+
+    if((cycleInfo = (ILBM_CycleInfo*)SDL_ILBM_calloc(1, sizeof(ILBM_CycleInfo))) != NULL)
+    {
+        cycleInfo->direction = (IFF_Word)getUWord(data);
+        cycleInfo->start = data[2];
+        cycleInfo->end = data[3];
+        cycleInfo->seconds = getLong(data + 4);
+        cycleInfo->microSeconds = getLong(data + 8);
+        cycleInfo->pad = (IFF_Word)getUWord(data + 12);
+    }
+
+    return addRange((void***)&image->cycleInfo, &image->cycleInfoLength, cycleInfo);
+}
+
+/* Reads a property chunk of an image, or skips it if it is not needed */
+
+static amiVideo_Bool probeProperty(Prober *prober, ILBM_Image *image, const IFF_UByte *chunkId, const IFF_Long chunkSize)
+{
+    amiVideo_Bool (*parseProperty) (ILBM_Image *image, const IFF_UByte *data, const IFF_Long chunkSize);
+    IFF_UByte *data;
+    amiVideo_Bool status;
+
+    if(idEquals(chunkId, "BMHD"))
+        parseProperty = parseBitMapHeader;
+    else if(idEquals(chunkId, "CMAP"))
+        parseProperty = parseColorMap;
+    else if(idEquals(chunkId, "CAMG"))
+        parseProperty = parseViewport;
+    else if(idEquals(chunkId, "CRNG"))
+        parseProperty = parseColorRange;
+    else if(idEquals(chunkId, "DRNG"))
+        parseProperty = parseDRange;
+    else if(idEquals(chunkId, "CCRT"))
+        parseProperty = parseCycleInfo;
+    else
+        return skipBytes(prober, chunkSize);
+
+    if(chunkSize > MAX_PROPERTY_SIZE)
+        return FALSE;
+
+    if((data = (IFF_UByte*)SDL_ILBM_malloc(chunkSize + 1)) == NULL)
+        return FALSE;
+
+    status = readBytes(prober, data, chunkSize) && parseProperty(image, data, chunkSize);
+
+    SDL_ILBM_free(data);
+    return status;
+}
+
+/* Derives the metadata of an image from its properties */
+
+static size_t computeUnpackedBodySize(const ILBM_Image *image)
+{
+    const ILBM_BitMapHeader *bitMapHeader = image->bitMapHeader;
+
+    if(ILBM_imageIsPBM(image))
+        return (size_t)(bitMapHeader->w + (bitMapHeader->w & 1)) * bitMapHeader->h; /* Rows of chunky pixels are padded to an even amount of bytes */
+    else
+    {
+        unsigned int nPlanes = bitMapHeader->nPlanes + (bitMapHeader->masking == ILBM_MSK_HAS_MASK ? 1 : 0);
+        return (size_t)ILBM_calculateRowSize(image) * nPlanes * bitMapHeader->h;
+    }
+}
+
+static size_t computeSurfaceSize(const int width, const int height, const SDL_ILBM_Format format)
+{
+    size_t bytesPerPixel = format == SDL_ILBM_CHUNKY_FORMAT ? 1 : 4;
+    size_t pitch = (width * bytesPerPixel + 3) & ~(size_t)3; /* SDL aligns the rows of surfaces to 4 bytes */
+
+    return pitch * height;
+}
+
+static amiVideo_Bool addImageInfo(Prober *prober, const ILBM_Image *image, const long formOffset, const IFF_Long formSize, const long bodyOffset, const IFF_Long bodySize, const amiVideo_Bool selfContained)
+{
+    SDL_ILBM_Probe *probe = prober->probe;
+    SDL_ILBM_ImageInfo *images, *info;
+
+    if(image->bitMapHeader == NULL)
+        return FALSE; /* An image cannot be composed without a bitmap header */
+
+    if((images = (SDL_ILBM_ImageInfo*)SDL_ILBM_realloc(probe->images, (probe->imagesLength + 1) * sizeof(SDL_ILBM_ImageInfo))) == NULL)
+        return FALSE;
+
+    probe->images = images;
+    info = &images[probe->imagesLength];
+    probe->imagesLength++;
+
+    memcpy(info->formType, image->formType, 4);
+    info->formOffset = formOffset;
+    info->formSize = formSize;
+    info->bodyOffset = bodyOffset;
+    info->bodySize = bodySize;
+    info->selfContained = selfContained;
+
+    info->width = image->bitMapHeader->w;
+    info->height = image->bitMapHeader->h;
+    info->nPlanes = image->bitMapHeader->nPlanes;
+    info->pageWidth = image->bitMapHeader->pageWidth;
+    info->pageHeight = image->bitMapHeader->pageHeight;
+    info->masking = image->bitMapHeader->masking;
+    info->compression = image->bitMapHeader->compression;
+    info->viewportMode = SDL_ILBM_extractViewportModeFromImage(image);
+    info->numOfColors = image->colorMap == NULL ? 0 : image->colorMap->colorRegisterLength;
+    info->numOfRanges = image->colorRangeLength + image->drangeLength + image->cycleInfoLength;
+    info->hasActiveRanges = (SDL_ILBM_computeRangeStepsPerSecond(image) > 0);
+
+    info->surfaceFormat = SDL_ILBM_computeSurfaceDimensions(image, prober->lowresPixelScaleFactor, prober->format, &info->surfaceWidth, &info->surfaceHeight);
+    info->surfaceSize = computeSurfaceSize(info->surfaceWidth, info->surfaceHeight, info->surfaceFormat);
+    info->unpackedBodySize = computeUnpackedBodySize(image);
+    info->decodedSize = info->unpackedBodySize + info->surfaceSize;
+
+    return TRUE;
+}
+
+static amiVideo_Bool propertiesAreEmpty(const ILBM_Image *properties)
+{
+    return (properties->bitMapHeader == NULL && properties->colorMap == NULL && properties->viewport == NULL
+        && properties->colorRangeLength == 0 && properties->drangeLength == 0 && properties->cycleInfoLength == 0);
+}
+
+/* Walking through the chunks of the file */
+
+static amiVideo_Bool probeChunk(Prober *prober, ILBM_Image *properties, IFF_Long *remaining);
+
+static amiVideo_Bool probeImage(Prober *prober, const ILBM_Image *properties, const IFF_UByte *formType, const long formOffset, const IFF_Long formSize, IFF_Long remaining)
+{
+    ILBM_Image image;
+    long bodyOffset = -1;
+    IFF_Long bodySize = 0;
+    amiVideo_Bool status = copyProperties(&image, properties);
+
+    memcpy(image.formType, formType, 4);
+
+    while(status && remaining >= CHUNK_HEADER_SIZE)
+    {
+        IFF_ID chunkId;
+        IFF_Long chunkSize;
+
+        if(!readEnclosedChunkHeader(prober, chunkId, &chunkSize, &remaining))
+        {
+            status = FALSE;
+            break;
+        }
+
+        if(idEquals(chunkId, "BODY") || idEquals(chunkId, "ABIT"))
+        {
+            /* Remember where the pixels are, without reading them */
+            bodyOffset = prober->position;
+            bodySize = chunkSize;
+            status = skipBytes(prober, chunkSize);
+        }
+        else
+            status = probeProperty(prober, &image, chunkId, chunkSize);
+
+        if(status && (chunkSize & 1))
+            status = skipBytes(prober, 1);
+    }
+
+    if(status)
+        status = skipBytes(prober, remaining) && addImageInfo(prober, &image, formOffset, formSize, bodyOffset, bodySize, propertiesAreEmpty(properties));
+
+    freeProperties(&image);
+    return status;
+}
+
+static amiVideo_Bool probeProp(Prober *prober, ILBM_Image *properties, IFF_Long remaining)
+{
+    IFF_ID propType;
+    int formTypeIndex;
+
+    if(!readBytes(prober, propType, 4))
+        return FALSE;
+
+    remaining -= 4;
+
+    if((formTypeIndex = lookupImageFormType(propType)) == -1)
+        return skipBytes(prober, remaining);
+
+    /* The properties are shared by all images in the enclosing list */
+    while(remaining >= CHUNK_HEADER_SIZE)
+    {
+        IFF_ID chunkId;
+        IFF_Long chunkSize;
+
+        if(!readEnclosedChunkHeader(prober, chunkId, &chunkSize, &remaining))
+            return FALSE;
+
+        if(!probeProperty(prober, &properties[formTypeIndex], chunkId, chunkSize))
+            return FALSE;
+
+        if((chunkSize & 1) && !skipBytes(prober, 1))
+            return FALSE;
+    }
+
+    return skipBytes(prober, remaining);
+}
+
+static amiVideo_Bool probeGroup(Prober *prober, const ILBM_Image *properties, const IFF_UByte *chunkId, const long offset, const IFF_Long chunkSize)
+{
+    IFF_ID groupType;
+    IFF_Long remaining = chunkSize - 4;
+    ILBM_Image groupProperties[NUM_OF_IMAGE_FORM_TYPES];
+    int formTypeIndex;
+    amiVideo_Bool status;
+
+    if(!readBytes(prober, groupType, 4))
+        return FALSE;
+
+    if(idEquals(chunkId, "FORM") && (formTypeIndex = lookupImageFormType(groupType)) != -1)
+        return probeImage(prober, &properties[formTypeIndex], groupType, offset, chunkSize, remaining);
+
+    if(prober->depth == MAX_GROUP_DEPTH)
+        return FALSE;
+
+    /* Properties defined by a PROP in this group only apply to the chunks in it */
+    status = copyPropertySets(groupProperties, properties);
+    prober->depth++;
+
+    while(status && remaining >= CHUNK_HEADER_SIZE)
+        status = probeChunk(prober, groupProperties, &remaining);
+
+    if(status)
+        status = skipBytes(prober, remaining);
+
+    prober->depth--;
+    freePropertySets(groupProperties);
+    return status;
+}
+
+static amiVideo_Bool probeChunk(Prober *prober, ILBM_Image *properties, IFF_Long *remaining)
+{
+    long offset = prober->position;
+    IFF_ID chunkId;
+    IFF_Long chunkSize;
+    amiVideo_Bool status;
+
+    if(!readEnclosedChunkHeader(prober, chunkId, &chunkSize, remaining))
+        return FALSE;
+
+    if(isGroup(chunkId) && chunkSize >= 4)
+        status = probeGroup(prober, properties, chunkId, offset, chunkSize);
+    else if(idEquals(chunkId, "PROP") && chunkSize >= 4)
+        status = probeProp(prober, properties, chunkSize);
+    else
+        status = skipBytes(prober, chunkSize);
+
+    if(status && (chunkSize & 1))
+        status = skipBytes(prober, 1);
+
+    return status;
+}
+
+SDL_ILBM_Probe *SDL_ILBM_probeFd(FILE *file, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format)
+{
+    SDL_ILBM_Probe *probe = (SDL_ILBM_Probe*)SDL_ILBM_malloc(sizeof(SDL_ILBM_Probe));
+
+    if(probe != NULL)
+    {
+        Prober prober;
+        ILBM_Image properties[NUM_OF_IMAGE_FORM_TYPES];
+        IFF_Long remaining = MAX_FILE_SIZE; /* The top-level chunk is not enclosed by a group */
+        amiVideo_Bool status;
+
+        probe->images = NULL;
+        probe->imagesLength = 0;
+
+        prober.file = file;
+        prober.position = ftell(file);
+        prober.lowresPixelScaleFactor = lowresPixelScaleFactor;
+        prober.format = format;
+        prober.probe = probe;
+        prober.depth = 0;
+
+        if(prober.position < 0)
+            prober.position = 0; /* Offsets in streams that cannot seek are relative to the start of the data */
+
+        /* An IFF file consists of a single chunk */
+        memset(properties, '\0', sizeof(properties));
+        status = probeChunk(&prober, properties, &remaining);
+        freePropertySets(properties);
+
+        if(!status)
+        {
+            SDL_ILBM_freeProbe(probe);
+            return NULL;
+        }
+    }
+
+    return probe;
+}
+
+SDL_ILBM_Probe *SDL_ILBM_probeFilename(const char *filename, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format)
+{
+    FILE *file = fopen(filename, "rb");
+
+    if(file == NULL)
+        return NULL;
+    else
+    {
+        SDL_ILBM_Probe *probe = SDL_ILBM_probeFd(file, lowresPixelScaleFactor, format);
+        fclose(file);
+        return probe;
+    }
+}
+
+SDL_ILBM_Probe *SDL_ILBM_probe(const char *filename, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format)
+{
+    if(filename == NULL)
+        return SDL_ILBM_probeFd(stdin, lowresPixelScaleFactor, format);
+    else
+        return SDL_ILBM_probeFilename(filename, lowresPixelScaleFactor, format);
+}
+
+void SDL_ILBM_freeProbe(SDL_ILBM_Probe *probe)
+{
+    if(probe != NULL)
+    {
+        SDL_ILBM_free(probe->images);
+        SDL_ILBM_free(probe);
+    }
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#ifndef __SDL_ILBM_PROBE_H
+#define __SDL_ILBM_PROBE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stddef.h>
+#include <libiff/ifftypes.h>
+#include "image.h"
+
+/**
+ * @brief Metadata of an image in an IFF file that has been obtained without
+ * reading its body
+ */
+typedef struct
+{
+    /** Form type of the image, which is either ILBM, PBM or ACBM */
+    IFF_ID formType;
+
+    /** Offset of the FORM chunk of the image in the file */
+    long formOffset;
+
+    /** Size of the FORM chunk of the image, excluding its chunk header */
+    IFF_Long formSize;
+
+    /** Offset of the data of the body in the file or -1 if the image has no body */
+    long bodyOffset;
+
+    /** Size of the body as it is stored in the file */
+    IFF_Long bodySize;
+
+    /** Indicates whether the form contains all properties of the image, so that it can be read without the PROP chunks of its enclosing list */
+    amiVideo_Bool selfContained;
+
+    /** Width of the image in pixels */
+    unsigned int width;
+
+    /** Height of the image in pixels */
+    unsigned int height;
+
+    /** Amount of bitplanes of the image */
+    unsigned int nPlanes;
+
+    /** Width of the page in pixels */
+    int pageWidth;
+
+    /** Height of the page in pixels */
+    int pageHeight;
+
+    /** Masking technique used by the body */
+    IFF_UByte masking;
+
+    /** Compression technique used by the body */
+    IFF_UByte compression;
+
+    /** Viewport mode that is used to display the image */
+    amiVideo_ULong viewportMode;
+
+    /** Amount of colors in the color map or 0 if the image has no color map */
+    unsigned int numOfColors;
+
+    /** Amount of CRNG, DRNG and CCRT ranges of the image */
+    unsigned int numOfRanges;
+
+    /** Indicates whether at least one of the ranges cycles its colors */
+    amiVideo_Bool hasActiveRanges;
+
+    /** Width of the surface that composing the image produces */
+    int surfaceWidth;
+
+    /** Height of the surface that composing the image produces */
+    int surfaceHeight;
+
+    /** Format of the surface that composing the image produces */
+    SDL_ILBM_Format surfaceFormat;
+
+    /** Size of the pixels of the surface in bytes */
+    size_t surfaceSize;
+
+    /** Size of the unpacked body in bytes */
+    size_t unpackedBodySize;
+
+    /** Total amount of bytes that composing the image takes, consisting of the unpacked body and the surface */
+    size_t decodedSize;
+}
+SDL_ILBM_ImageInfo;
+
+/**
+ * @brief Metadata of all images in an IFF file
+ */
+typedef struct
+{
+    /** An array of metadata of the images in the file */
+    SDL_ILBM_ImageInfo *images;
+
+    /** Specifies the length of the images array */
+    unsigned int imagesLength;
+}
+SDL_ILBM_Probe;
+
+/**
+ * Probes the images in a file with a specific file descriptor. Only the
+ * properties of the images are parsed, whereas their bodies are skipped by
+ * seeking past them. Streams that cannot seek are read past the bodies
+ * instead. The surface properties correspond to those of an image created by
+ * SDL_ILBM_createImageFromSet() with the same parameters.
+ *
+ * @param file File descriptor
+ * @param lowresPixelScaleFactor Specifies the width of a lowres pixel or 0 to pick it automatically
+ * @param format Defines to which format the images would be converted
+ * @return An SDL_ILBM_Probe instance or NULL in case of an error. The result must be freed with SDL_ILBM_freeProbe()
+ */
+SDL_ILBM_Probe *SDL_ILBM_probeFd(FILE *file, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format);
+
+/**
+ * Probes the images in a file with a specified filename.
+ *
+ * @param filename Path to an IFF file to open
+ * @param lowresPixelScaleFactor Specifies the width of a lowres pixel or 0 to pick it automatically
+ * @param format Defines to which format the images would be converted
+ * @return An SDL_ILBM_Probe instance or NULL in case of an error. The result must be freed with SDL_ILBM_freeProbe()
+ */
+SDL_ILBM_Probe *SDL_ILBM_probeFilename(const char *filename, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format);
+
+/**
+ * Probes the images in a file with a specified filename or read from the
+ * standard input if no filename was provided.
+ *
+ * @param filename Path to an IFF file to open or NULL to read from the standard input
+ * @param lowresPixelScaleFactor Specifies the width of a lowres pixel or 0 to pick it automatically
+ * @param format Defines to which format the images would be converted
+ * @return An SDL_ILBM_Probe instance or NULL in case of an error. The result must be freed with SDL_ILBM_freeProbe()
+ */
+SDL_ILBM_Probe *SDL_ILBM_probe(const char *filename, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format);
+
+/**
+ * Frees the metadata of probed images from memory.
+ *
+ * @param probe An SDL_ILBM_Probe instance
+ */
+void SDL_ILBM_freeProbe(SDL_ILBM_Probe *probe);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
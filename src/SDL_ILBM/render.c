@@ -23,7 +23,190 @@
  */
 
 #include "render.h"
+#include "allocator.h"
+#include <stdlib.h>
 #include <string.h>
+#include <libamivideo/viewportmode.h>
+#include "c2p.h"
+#include "scale.h"
+#include "image2amivideo.h"
+
+/* Checks whether the bitplanes of the screen can be converted by the c2p kernels of this library */
+
+static amiVideo_Bool bitplanesCanBeConverted(const ILBM_Image *image, const amiVideo_Screen *screen)
+{
+    return (screen->bitplaneDepth > 0 && screen->bitplaneDepth <= SDL_ILBM_MAX_NUM_OF_C2P_BITPLANES && SDL_ILBM_bitplanesAreAttached(image));
+}
+
+static void selectBitplaneRows(const amiVideo_Screen *screen, const unsigned int y, const amiVideo_UByte **rows)
+{
+    int i;
+
+    for(i = 0; i < screen->bitplaneDepth; i++)
+        rows[i] = screen->bitplaneFormat.bitplanes[i] + y * screen->bitplaneFormat.pitch;
+}
+
+static void convertBitplanesToChunkyPixels(const amiVideo_Screen *screen, amiVideo_UByte *pixels, const unsigned int pitch)
+{
+    const amiVideo_UByte *rows[SDL_ILBM_MAX_NUM_OF_C2P_BITPLANES];
+    int y;
+
+    for(y = 0; y < screen->height; y++)
+    {
+        selectBitplaneRows(screen, y, rows);
+        SDL_ILBM_convertPlanarRowToChunky(rows, screen->bitplaneDepth, screen->width, pixels + y * pitch);
+    }
+}
+
+static amiVideo_Bool convertBitplanesToRGBPixels(amiVideo_Screen *screen, SDL_Surface *surface)
+{
+    const amiVideo_UByte *rows[SDL_ILBM_MAX_NUM_OF_C2P_BITPLANES];
+    Uint32 colors[SDL_ILBM_MAX_NUM_OF_C2P_COLORS];
+    amiVideo_UByte *chunkyRow = (amiVideo_UByte*)SDL_ILBM_malloc(screen->width);
+    int y;
+
+    if(chunkyRow == NULL)
+        return FALSE;
+
+    /* Map the chunky palette, which includes derived colors such as extra halfbrites, to the pixel format of the surface */
+    amiVideo_convertBitplaneColorsToChunkyFormat(&screen->palette);
+    SDL_ILBM_mapChunkyPalette(&screen->palette, surface->format, colors);
+
+    for(y = 0; y < screen->height; y++)
+    {
+        selectBitplaneRows(screen, y, rows);
+        SDL_ILBM_convertPlanarRowToChunky(rows, screen->bitplaneDepth, screen->width, chunkyRow);
+        SDL_ILBM_convertChunkyRowToRGB(chunkyRow, colors, screen->width, (Uint32*)((amiVideo_UByte*)surface->pixels + y * surface->pitch));
+    }
+
+    SDL_ILBM_free(chunkyRow);
+    return TRUE;
+}
+
+/* True color images are converted in a single pass that writes the channels directly in the order of the destination surface */
+
+#define BITS_PER_CHANNEL 8
+
+static amiVideo_Bool isDeepScreen(const amiVideo_Screen *screen)
+{
+    return (screen->bitplaneDepth == 24 || screen->bitplaneDepth == 32);
+}
+
+static unsigned int computeDeepBodyRowSize(const ILBM_Image *image, const amiVideo_Screen *screen)
+{
+    return (image->bitMapHeader->w * (screen->bitplaneDepth / BITS_PER_CHANNEL) + 1) & ~1U; /* The rows of a PBM body are padded to an even amount of bytes */
+}
+
+static amiVideo_Bool deepBodyIsComplete(const ILBM_Image *image, const amiVideo_Screen *screen)
+{
+    return (image->body->chunkData != NULL && (IFF_Long)(computeDeepBodyRowSize(image, screen) * image->bitMapHeader->h) <= image->body->chunkSize);
+}
+
+static unsigned int computeByteShift(const unsigned int index)
+{
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+    return (sizeof(Uint32) - 1 - index) * BITS_PER_CHANNEL;
+#else
+    return index * BITS_PER_CHANNEL;
+#endif
+}
+
+static amiVideo_Bool channelsAreInByteOrder(const SDL_PixelFormat *format)
+{
+    return (format->Rshift == computeByteShift(0) && format->Gshift == computeByteShift(1) && format->Bshift == computeByteShift(2));
+}
+
+static void convertDeepChunkyPixels(const ILBM_Image *image, const amiVideo_Screen *screen, const SDL_PixelFormat *format, amiVideo_UByte *pixels, const unsigned int pitch)
+{
+    unsigned int bytesPerPixel = screen->bitplaneDepth / BITS_PER_CHANNEL;
+    unsigned int rowSize = computeDeepBodyRowSize(image, screen);
+    amiVideo_Bool copyRows = (bytesPerPixel == sizeof(Uint32) && channelsAreInByteOrder(format));
+    int y;
+
+    for(y = 0; y < screen->height; y++)
+    {
+        const amiVideo_UByte *source = image->body->chunkData + y * rowSize;
+        Uint32 *row = (Uint32*)(pixels + y * pitch);
+
+        if(copyRows)
+            memcpy(row, source, screen->width * sizeof(Uint32)); /* The surface already has the channel order of the body */
+        else
+        {
+            int x;
+
+            for(x = 0; x < screen->width; x++)
+            {
+                row[x] = ((Uint32)source[0] << format->Rshift) | ((Uint32)source[1] << format->Gshift) | ((Uint32)source[2] << format->Bshift);
+                source += bytesPerPixel;
+            }
+        }
+    }
+}
+
+static amiVideo_Bool convertDeepBitplanes(const amiVideo_Screen *screen, const SDL_PixelFormat *format, amiVideo_UByte *pixels, const unsigned int pitch)
+{
+    const amiVideo_UByte *rows[SDL_ILBM_MAX_NUM_OF_C2P_BITPLANES];
+    amiVideo_UByte *channelRows = (amiVideo_UByte*)SDL_ILBM_malloc(3 * screen->width);
+    int y;
+
+    if(channelRows == NULL)
+        return FALSE;
+
+    for(y = 0; y < screen->height; y++)
+    {
+        Uint32 *row = (Uint32*)(pixels + y * pitch);
+        unsigned int i;
+        int x;
+
+        /* Every group of 8 bitplanes holds the intensities of a channel: red, green and blue. A fourth group, if any, is not displayed */
+        for(i = 0; i < 3; i++)
+        {
+            unsigned int j;
+
+            for(j = 0; j < SDL_ILBM_MAX_NUM_OF_C2P_BITPLANES; j++)
+                rows[j] = screen->bitplaneFormat.bitplanes[i * SDL_ILBM_MAX_NUM_OF_C2P_BITPLANES + j] + y * screen->bitplaneFormat.pitch;
+
+            SDL_ILBM_convertPlanarRowToChunky(rows, SDL_ILBM_MAX_NUM_OF_C2P_BITPLANES, screen->width, channelRows + i * screen->width);
+        }
+
+        for(x = 0; x < screen->width; x++)
+            row[x] = ((Uint32)channelRows[x] << format->Rshift) | ((Uint32)channelRows[screen->width + x] << format->Gshift) | ((Uint32)channelRows[2 * screen->width + x] << format->Bshift);
+    }
+
+    SDL_ILBM_free(channelRows);
+    return TRUE;
+}
+
+/* Corrects the uncorrected pixels by replicating them, if the corrected surface is a whole multiple of the screen, or lets libamivideo correct them otherwise */
+
+static void correctScreenPixels(amiVideo_Screen *screen)
+{
+    unsigned int width = screen->width, height = screen->height;
+    const amiVideo_UByte *pixels;
+    unsigned int pitch;
+
+    if(screen->correctedFormat.bytesPerPixel == 1)
+    {
+        pixels = screen->uncorrectedChunkyFormat.pixels;
+        pitch = screen->uncorrectedChunkyFormat.pitch;
+    }
+    else
+    {
+        pixels = (const amiVideo_UByte*)screen->uncorrectedRGBFormat.pixels;
+        pitch = screen->uncorrectedRGBFormat.pitch;
+    }
+
+    if(pixels != NULL && screen->correctedFormat.pixels != NULL && width > 0 && height > 0
+        && screen->correctedFormat.width % width == 0 && screen->correctedFormat.height % height == 0
+        && screen->correctedFormat.width >= width && screen->correctedFormat.height >= height)
+    {
+        SDL_ILBM_replicatePixels(pixels, pitch, width, height, screen->correctedFormat.bytesPerPixel,
+            screen->correctedFormat.width / width, screen->correctedFormat.height / height,
+            screen->correctedFormat.pixels, screen->correctedFormat.pitch);
+    }
+    else
+        amiVideo_correctScreenPixels(screen);
+}
 
 amiVideo_Bool SDL_ILBM_renderUncorrectedChunkyImage(const ILBM_Image *image, amiVideo_Screen *screen, SDL_Surface *surface)
 {
@@ -40,7 +223,9 @@ amiVideo_Bool SDL_ILBM_renderUncorrectedChunkyImage(const ILBM_Image *image, ami
     }
     else
     {
-        if(image->bitplanes != NULL)
+        if(bitplanesCanBeConverted(image, screen))
+            convertBitplanesToChunkyPixels(screen, screen->uncorrectedChunkyFormat.pixels, screen->uncorrectedChunkyFormat.pitch); /* Convert the bitplanes to chunky pixels */
+        else if(SDL_ILBM_bitplanesAreAttached(image))
             amiVideo_convertScreenBitplanesToChunkyPixels(screen); /* Convert the bitplanes to chunky pixels */
     }
 
@@ -62,7 +247,9 @@ amiVideo_Bool SDL_ILBM_renderUncorrectedRGBImage(const ILBM_Image *image, amiVid
     {
         if(image->body != NULL)
         {
-            if(screen->bitplaneDepth == 24 || screen->bitplaneDepth == 32)
+            if(isDeepScreen(screen) && deepBodyIsComplete(image, screen))
+                convertDeepChunkyPixels(image, screen, surface->format, surface->pixels, surface->pitch); /* For true color images => put the channels of each pixel in the order of the surface */
+            else if(isDeepScreen(screen))
             {
                 /* For images with a higher than 8 bitplane depth (true color images) => copy chunky data to the RGB section and reorder the pixels */
                 memcpy(screen->uncorrectedRGBFormat.pixels, image->body->chunkData, image->body->chunkSize);
@@ -74,8 +261,14 @@ amiVideo_Bool SDL_ILBM_renderUncorrectedRGBImage(const ILBM_Image *image, amiVid
     }
     else
     {
-        if(image->bitplanes != NULL)
-            amiVideo_convertScreenBitplanesToRGBPixels(screen); /* Convert the bitplanes to RGB pixels */
+        if(bitplanesCanBeConverted(image, screen) && !(screen->viewportMode & AMIVIDEO_VIDEOPORTMODE_HAM)) /* HAM pixels depend on their predecessors, which libamivideo takes care of */
+            convertBitplanesToRGBPixels(screen, surface); /* Convert the bitplanes to chunky pixels and look up their RGB values */
+        else if(SDL_ILBM_bitplanesAreAttached(image))
+        {
+            /* For true color images => convert the bitplanes of each channel and combine them in the order of the surface */
+            if(!isDeepScreen(screen) || !convertDeepBitplanes(screen, surface->format, surface->pixels, surface->pitch))
+                amiVideo_convertScreenBitplanesToRGBPixels(screen); /* Convert the bitplanes to RGB pixels */
+        }
     }
 
     if(SDL_MUSTLOCK(surface))
@@ -95,11 +288,16 @@ amiVideo_Bool SDL_ILBM_renderCorrectedChunkyImage(const ILBM_Image *image, amiVi
     if(ILBM_imageIsPBM(image))
     {
         if(image->body != NULL)
-            amiVideo_correctScreenPixels(screen); /* Correct the pixels */
+            correctScreenPixels(screen); /* Correct the pixels */
     }
     else
     {
-        if(image->bitplanes != NULL)
+        if(bitplanesCanBeConverted(image, screen) && screen->uncorrectedChunkyFormat.pixels != NULL)
+        {
+            convertBitplanesToChunkyPixels(screen, screen->uncorrectedChunkyFormat.pixels, screen->uncorrectedChunkyFormat.pitch); /* Convert the bitplanes to uncorrected chunky pixels */
+            correctScreenPixels(screen); /* Correct the pixels */
+        }
+        else if(SDL_ILBM_bitplanesAreAttached(image))
             amiVideo_convertScreenBitplanesToCorrectedChunkyPixels(screen); /* Convert the bitplanes to corrected chunky pixels */
     }
 
@@ -121,12 +319,18 @@ amiVideo_Bool SDL_ILBM_renderCorrectedRGBImage(const ILBM_Image *image, amiVideo
     {
         if(image->body != NULL)
         {
-            if(screen->bitplaneDepth == 24 || screen->bitplaneDepth == 32)
+            if(isDeepScreen(screen) && deepBodyIsComplete(image, screen) && screen->uncorrectedRGBFormat.pixels != NULL)
+            {
+                /* For true color images => put the channels of each pixel in the order of the surface while copying them to the RGB section, and correct the image */
+                convertDeepChunkyPixels(image, screen, surface->format, (amiVideo_UByte*)screen->uncorrectedRGBFormat.pixels, screen->uncorrectedRGBFormat.pitch);
+                correctScreenPixels(screen);
+            }
+            else if(isDeepScreen(screen))
             {
                 /* For images with a higher than 8 bitplane depth => copy chunky data to the RGB section, reorder the pixels, and correct the image */
                 memcpy(screen->uncorrectedRGBFormat.pixels, image->body->chunkData, image->body->chunkSize);
                 amiVideo_reorderRGBPixels(screen);
-                amiVideo_correctScreenPixels(screen);
+                correctScreenPixels(screen);
             }
             else
                 amiVideo_convertScreenChunkyPixelsToCorrectedRGBPixels(screen); /* Convert bitplanes to RGB pixels and correct the image */
@@ -134,7 +338,10 @@ amiVideo_Bool SDL_ILBM_renderCorrectedRGBImage(const ILBM_Image *image, amiVideo
     }
     else
     {
-        if(image->bitplanes != NULL)
+        if(isDeepScreen(screen) && SDL_ILBM_bitplanesAreAttached(image) && screen->uncorrectedRGBFormat.pixels != NULL
+            && convertDeepBitplanes(screen, surface->format, (amiVideo_UByte*)screen->uncorrectedRGBFormat.pixels, screen->uncorrectedRGBFormat.pitch))
+            correctScreenPixels(screen); /* For true color images => combine the channels in the order of the surface, and correct the image */
+        else if(SDL_ILBM_bitplanesAreAttached(image))
             amiVideo_convertScreenBitplanesToCorrectedRGBPixels(screen); /* Convert the bitplanes to corrected RGB pixels */
     }
 
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#include "scale.h"
+#include <string.h>
+
+/*
+ * Replicates pixels to correct the aspect ratio of a surface. Each pixel is
+ * repeated horizontally by unpacking or shuffling vector registers, if the
+ * CPU supports it, and each scaled row is repeated vertically by copying it.
+ */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SCALE_SSE2
+#include <emmintrin.h>
+#endif
+
+static void replicateChunkyScalar(const amiVideo_UByte *pixels, const unsigned int first, const unsigned int width, const unsigned int factor, amiVideo_UByte *scaledPixels)
+{
+    unsigned int x;
+
+    for(x = first; x < width; x++)
+        memset(scaledPixels + x * factor, pixels[x], factor);
+}
+
+static void replicateRGBScalar(const Uint32 *pixels, const unsigned int first, const unsigned int width, const unsigned int factor, Uint32 *scaledPixels)
+{
+    unsigned int x;
+
+    for(x = first; x < width; x++)
+    {
+        unsigned int i;
+        Uint32 *scaledPixel = scaledPixels + x * factor;
+
+        for(i = 0; i < factor; i++)
+            scaledPixel[i] = pixels[x];
+    }
+}
+
+#ifdef SCALE_SSE2
+#define SSE2_BYTES 16
+#define SSE2_RGB_PIXELS 4
+
+/* Determined once, by the first of possibly several loader threads that needs it */
+
+static amiVideo_Bool useSSE2 = FALSE;
+static SDL_atomic_t useSSE2Determined;
+static SDL_SpinLock useSSE2Lock = 0;
+
+static amiVideo_Bool sse2IsAvailable(void)
+{
+    if(!SDL_AtomicGet(&useSSE2Determined))
+    {
+        SDL_AtomicLock(&useSSE2Lock);
+
+        if(!SDL_AtomicGet(&useSSE2Determined))
+        {
+            useSSE2 = SDL_HasSSE2();
+            SDL_AtomicSet(&useSSE2Determined, TRUE);
+        }
+
+        SDL_AtomicUnlock(&useSSE2Lock);
+    }
+
+    return useSSE2;
+}
+
+static unsigned int replicateChunkySSE2(const amiVideo_UByte *pixels, const unsigned int width, const unsigned int factor, amiVideo_UByte *scaledPixels)
+{
+    unsigned int x;
+
+    for(x = 0; x + SSE2_BYTES <= width; x += SSE2_BYTES)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(pixels + x));
+        __m128i low = _mm_unpacklo_epi8(v, v);
+        __m128i high = _mm_unpackhi_epi8(v, v);
+        amiVideo_UByte *scaledPixel = scaledPixels + x * factor;
+
+        if(factor == 2)
+        {
+            _mm_storeu_si128((__m128i*)scaledPixel, low);
+            _mm_storeu_si128((__m128i*)(scaledPixel + SSE2_BYTES), high);
+        }
+        else
+        {
+            /* Unpacking every pair of bytes with itself once more repeats each pixel four times */
+            _mm_storeu_si128((__m128i*)scaledPixel, _mm_unpacklo_epi16(low, low));
+            _mm_storeu_si128((__m128i*)(scaledPixel + SSE2_BYTES), _mm_unpackhi_epi16(low, low));
+            _mm_storeu_si128((__m128i*)(scaledPixel + 2 * SSE2_BYTES), _mm_unpacklo_epi16(high, high));
+            _mm_storeu_si128((__m128i*)(scaledPixel + 3 * SSE2_BYTES), _mm_unpackhi_epi16(high, high));
+        }
+    }
+
+    return x;
+}
+
+static unsigned int replicateRGBSSE2(const Uint32 *pixels, const unsigned int width, const unsigned int factor, Uint32 *scaledPixels)
+{
+    unsigned int x;
+
+    for(x = 0; x + SSE2_RGB_PIXELS <= width; x += SSE2_RGB_PIXELS)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(pixels + x));
+        Uint32 *scaledPixel = scaledPixels + x * factor;
+
+        if(factor == 2)
+        {
+            _mm_storeu_si128((__m128i*)scaledPixel, _mm_unpacklo_epi32(v, v));
+            _mm_storeu_si128((__m128i*)(scaledPixel + SSE2_RGB_PIXELS), _mm_unpackhi_epi32(v, v));
+        }
+        else
+        {
+            /* Broadcast each pixel to a register of its own */
+            _mm_storeu_si128((__m128i*)scaledPixel, _mm_shuffle_epi32(v, 0x00));
+            _mm_storeu_si128((__m128i*)(scaledPixel + SSE2_RGB_PIXELS), _mm_shuffle_epi32(v, 0x55));
+            _mm_storeu_si128((__m128i*)(scaledPixel + 2 * SSE2_RGB_PIXELS), _mm_shuffle_epi32(v, 0xaa));
+            _mm_storeu_si128((__m128i*)(scaledPixel + 3 * SSE2_RGB_PIXELS), _mm_shuffle_epi32(v, 0xff));
+        }
+    }
+
+    return x;
+}
+#endif
+
+void SDL_ILBM_replicateChunkyRow(const amiVideo_UByte *pixels, const unsigned int width, const unsigned int factor, amiVideo_UByte *scaledPixels)
+{
+    unsigned int first = 0;
+
+    if(factor == 1)
+    {
+        memcpy(scaledPixels, pixels, width);
+        return;
+    }
+
+#ifdef SCALE_SSE2
+    if((factor == 2 || factor == 4) && sse2IsAvailable())
+        first = replicateChunkySSE2(pixels, width, factor, scaledPixels);
+#endif
+
+    replicateChunkyScalar(pixels, first, width, factor, scaledPixels); /* Replicate the remaining pixels */
+}
+
+void SDL_ILBM_replicateRGBRow(const Uint32 *pixels, const unsigned int width, const unsigned int factor, Uint32 *scaledPixels)
+{
+    unsigned int first = 0;
+
+    if(factor == 1)
+    {
+        memcpy(scaledPixels, pixels, width * sizeof(Uint32));
+        return;
+    }
+
+#ifdef SCALE_SSE2
+    if((factor == 2 || factor == 4) && sse2IsAvailable())
+        first = replicateRGBSSE2(pixels, width, factor, scaledPixels);
+#endif
+
+    replicateRGBScalar(pixels, first, width, factor, scaledPixels); /* Replicate the remaining pixels */
+}
+
+void SDL_ILBM_replicatePixels(const amiVideo_UByte *pixels, const unsigned int pitch, const unsigned int width, const unsigned int height, const unsigned int bytesPerPixel, const unsigned int scaleX, const unsigned int scaleY, amiVideo_UByte *scaledPixels, const unsigned int scaledPitch)
+{
+    unsigned int y, scaledRowSize = width * scaleX * bytesPerPixel;
+
+    for(y = 0; y < height; y++)
+    {
+        const amiVideo_UByte *row = pixels + y * pitch;
+        amiVideo_UByte *scaledRow = scaledPixels + y * scaleY * scaledPitch;
+        unsigned int i;
+
+        if(bytesPerPixel == 1)
+            SDL_ILBM_replicateChunkyRow(row, width, scaleX, scaledRow);
+        else
+            SDL_ILBM_replicateRGBRow((const Uint32*)row, width, scaleX, (Uint32*)scaledRow);
+
+        /* The remaining scanlines of the pixel are identical to the first one */
+        for(i = 1; i < scaleY; i++)
+            memcpy(scaledRow + i * scaledPitch, scaledRow, scaledRowSize);
+    }
+}
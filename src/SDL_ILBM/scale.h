@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#ifndef __SDL_ILBM_SCALE_H
+#define __SDL_ILBM_SCALE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <SDL.h>
+#include <libamivideo/amivideotypes.h>
+
+void SDL_ILBM_replicateChunkyRow(const amiVideo_UByte *pixels, const unsigned int width, const unsigned int factor, amiVideo_UByte *scaledPixels);
+
+void SDL_ILBM_replicateRGBRow(const Uint32 *pixels, const unsigned int width, const unsigned int factor, Uint32 *scaledPixels);
+
+void SDL_ILBM_replicatePixels(const amiVideo_UByte *pixels, const unsigned int pitch, const unsigned int width, const unsigned int height, const unsigned int bytesPerPixel, const unsigned int scaleX, const unsigned int scaleY, amiVideo_UByte *scaledPixels, const unsigned int scaledPitch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
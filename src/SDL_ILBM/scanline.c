@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#include "scanline.h"
+#include "allocator.h"
+#include "c2p.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <libamivideo/viewportmode.h>
+
+/*
+ * Renders an interleaved ILBM body one scanline at a time: each row of all
+ * bitplanes is decompressed into a small buffer, converted and written
+ * straight into the destination surface. This avoids unpacking and
+ * deinterleaving the entire body into separate full-size buffers first.
+ */
+
+/* Decodes a ByteRun compressed stream incrementally. Runs may cross row boundaries, so the state of the current run is kept */
+
+typedef struct
+{
+    const IFF_UByte *data;
+    IFF_Long dataLength;
+    IFF_Long position;
+
+    /* Amount of bytes remaining in the current run */
+    unsigned int runLength;
+
+    /* Indicates whether the current run copies bytes from the stream or repeats a value */
+    amiVideo_Bool literal;
+
+    IFF_UByte value;
+}
+ByteRunDecoder;
+
+static void initByteRunDecoder(ByteRunDecoder *decoder, const IFF_RawChunk *body)
+{
+    decoder->data = body->chunkData;
+    decoder->dataLength = body->chunkSize;
+    decoder->position = 0;
+    decoder->runLength = 0;
+    decoder->literal = FALSE;
+    decoder->value = 0;
+}
+
+static amiVideo_Bool readByteRunControl(ByteRunDecoder *decoder)
+{
+    IFF_Byte control;
+
+    if(decoder->position >= decoder->dataLength)
+        return FALSE;
+
+    control = (IFF_Byte)decoder->data[decoder->position++];
+
+    if(control >= 0)
+    {
+        decoder->literal = TRUE;
+        decoder->runLength = control + 1;
+    }
+    else if(control != -128) /* -128 is a no-op */
+    {
+        if(decoder->position >= decoder->dataLength)
+            return FALSE;
+
+        decoder->literal = FALSE;
+        decoder->runLength = -control + 1;
+        decoder->value = decoder->data[decoder->position++];
+    }
+
+    return TRUE;
+}
+
+static void decodeByteRunRow(ByteRunDecoder *decoder, IFF_UByte *row, const unsigned int rowLength)
+{
+    unsigned int count = 0;
+
+    while(count < rowLength)
+    {
+        if(decoder->runLength == 0)
+        {
+            if(!readByteRunControl(decoder))
+            {
+                memset(row + count, '\0', rowLength - count); /* The body is truncated => pad the remainder of the row */
+                return;
+            }
+        }
+        else
+        {
+            unsigned int length = rowLength - count;
+
+            if(length > decoder->runLength)
+                length = decoder->runLength;
+
+            if(decoder->literal)
+            {
+                if(length > (unsigned int)(decoder->dataLength - decoder->position))
+                {
+                    length = decoder->dataLength - decoder->position;
+                    decoder->runLength = length; /* Truncated literal => stop at the end of the stream */
+                }
+
+                memcpy(row + count, decoder->data + decoder->position, length);
+                decoder->position += length;
+            }
+            else
+                memset(row + count, decoder->value, length);
+
+            count += length;
+            decoder->runLength -= length;
+        }
+    }
+}
+
+amiVideo_Bool SDL_ILBM_scanlinesCanBeRendered(const ILBM_Image *image, const amiVideo_Screen *screen, const amiVideo_ColorFormat format)
+{
+    const ILBM_BitMapHeader *bitMapHeader = image->bitMapHeader;
+
+    if(!ILBM_imageIsILBM(image) || image->body == NULL || image->body->chunkData == NULL)
+        return FALSE;
+    else if(bitMapHeader->nPlanes == 0 || bitMapHeader->nPlanes > SDL_ILBM_MAX_NUM_OF_C2P_BITPLANES)
+        return FALSE; /* True color images have no palette to look up */
+    else if(format == AMIVIDEO_RGB_FORMAT && (screen->viewportMode & AMIVIDEO_VIDEOPORTMODE_HAM))
+        return FALSE; /* HAM pixels depend on their predecessors, which the generic conversion takes care of */
+    else if(bitMapHeader->compression == ILBM_CMP_BYTE_RUN)
+        return TRUE;
+    else if(bitMapHeader->compression == ILBM_CMP_NONE)
+    {
+        unsigned int numOfPlanes = bitMapHeader->nPlanes + (bitMapHeader->masking == ILBM_MSK_HAS_MASK ? 1 : 0);
+        return ((IFF_Long)(ILBM_calculateRowSize(image) * numOfPlanes * bitMapHeader->h) <= image->body->chunkSize); /* Uncompressed rows are read in place, so they must all be there */
+    }
+    else
+        return FALSE;
+}
+
+static amiVideo_Bool renderScanlines(const ILBM_Image *image, SDL_Surface *surface, const Uint32 *colors)
+{
+    const ILBM_BitMapHeader *bitMapHeader = image->bitMapHeader;
+    unsigned int rowSize = ILBM_calculateRowSize(image);
+    unsigned int numOfPlanes = bitMapHeader->nPlanes + (bitMapHeader->masking == ILBM_MSK_HAS_MASK ? 1 : 0); /* The mask plane is interleaved as well, but not displayed */
+    unsigned int rowLength = rowSize * numOfPlanes;
+    IFF_UByte *row = NULL;
+    amiVideo_UByte *chunkyRow = NULL;
+    const amiVideo_UByte *rows[SDL_ILBM_MAX_NUM_OF_C2P_BITPLANES];
+    ByteRunDecoder decoder;
+    unsigned int i, y;
+
+    /* Allocate buffers of a single row, which stay in the cache while they are being converted */
+
+    if(bitMapHeader->compression == ILBM_CMP_BYTE_RUN)
+    {
+        row = (IFF_UByte*)SDL_ILBM_malloc(rowLength);
+
+        if(row == NULL)
+            return FALSE;
+
+        initByteRunDecoder(&decoder, image->body);
+    }
+
+    if(colors != NULL)
+    {
+        chunkyRow = (amiVideo_UByte*)SDL_ILBM_malloc(bitMapHeader->w);
+
+        if(chunkyRow == NULL)
+        {
+            SDL_ILBM_free(row);
+            return FALSE;
+        }
+    }
+
+    if(SDL_MUSTLOCK(surface) && SDL_LockSurface(surface) != 0)
+    {
+        fprintf(stderr, "Cannot lock the surface!\n");
+        SDL_ILBM_free(row);
+        SDL_ILBM_free(chunkyRow);
+        return FALSE;
+    }
+
+    for(y = 0; y < bitMapHeader->h; y++)
+    {
+        amiVideo_UByte *pixels = (amiVideo_UByte*)surface->pixels + y * surface->pitch;
+        const IFF_UByte *source;
+
+        if(row == NULL)
+            source = image->body->chunkData + y * rowLength; /* Uncompressed rows can be converted in place */
+        else
+        {
+            decodeByteRunRow(&decoder, row, rowLength);
+            source = row;
+        }
+
+        for(i = 0; i < bitMapHeader->nPlanes; i++)
+            rows[i] = source + i * rowSize;
+
+        if(colors == NULL)
+            SDL_ILBM_convertPlanarRowToChunky(rows, bitMapHeader->nPlanes, bitMapHeader->w, pixels);
+        else
+        {
+            SDL_ILBM_convertPlanarRowToChunky(rows, bitMapHeader->nPlanes, bitMapHeader->w, chunkyRow);
+            SDL_ILBM_convertChunkyRowToRGB(chunkyRow, colors, bitMapHeader->w, (Uint32*)pixels);
+        }
+    }
+
+    if(SDL_MUSTLOCK(surface))
+        SDL_UnlockSurface(surface);
+
+    SDL_ILBM_free(row);
+    SDL_ILBM_free(chunkyRow);
+
+    return TRUE;
+}
+
+amiVideo_Bool SDL_ILBM_renderScanlinesToChunkySurface(const ILBM_Image *image, SDL_Surface *surface)
+{
+    return renderScanlines(image, surface, NULL);
+}
+
+amiVideo_Bool SDL_ILBM_renderScanlinesToRGBSurface(const ILBM_Image *image, amiVideo_Screen *screen, SDL_Surface *surface)
+{
+    Uint32 colors[SDL_ILBM_MAX_NUM_OF_C2P_COLORS];
+
+    /* Map the chunky palette, which includes derived colors such as extra halfbrites, to the pixel format of the surface */
+    amiVideo_convertBitplaneColorsToChunkyFormat(&screen->palette);
+    SDL_ILBM_mapChunkyPalette(&screen->palette, surface->format, colors);
+
+    return renderScanlines(image, surface, colors);
+}
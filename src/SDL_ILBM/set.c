@@ -65,7 +65,7 @@ IFF_Bool SDL_ILBM_initSetFromIFFChunk(SDL_ILBM_Set *set, IFF_Chunk *chunk, IFF_B
 
 SDL_ILBM_Set *SDL_ILBM_createSetFromFd(FILE *file)
 {
-    SDL_ILBM_Set *set = (SDL_ILBM_Set*)malloc(sizeof(SDL_ILBM_Set));
+    SDL_ILBM_Set *set = (SDL_ILBM_Set*)SDL_ILBM_malloc(sizeof(SDL_ILBM_Set));
 
     if(set != NULL)
     {
@@ -81,7 +81,7 @@ SDL_ILBM_Set *SDL_ILBM_createSetFromFd(FILE *file)
 
 SDL_ILBM_Set *SDL_ILBM_createSetFromFilename(const char *filename)
 {
-    SDL_ILBM_Set *set = (SDL_ILBM_Set*)malloc(sizeof(SDL_ILBM_Set));
+    SDL_ILBM_Set *set = (SDL_ILBM_Set*)SDL_ILBM_malloc(sizeof(SDL_ILBM_Set));
 
     if(set != NULL)
     {
@@ -97,7 +97,7 @@ SDL_ILBM_Set *SDL_ILBM_createSetFromFilename(const char *filename)
 
 SDL_ILBM_Set *SDL_ILBM_createSet(const char *filename)
 {
-    SDL_ILBM_Set *set = (SDL_ILBM_Set*)malloc(sizeof(SDL_ILBM_Set));
+    SDL_ILBM_Set *set = (SDL_ILBM_Set*)SDL_ILBM_malloc(sizeof(SDL_ILBM_Set));
 
     if(set != NULL)
     {
@@ -113,7 +113,7 @@ SDL_ILBM_Set *SDL_ILBM_createSet(const char *filename)
 
 SDL_ILBM_Set *SDL_ILBM_createSetFromIFFChunk(IFF_Chunk *chunk, IFF_Bool mustFreeChunk)
 {
-    SDL_ILBM_Set *set = (SDL_ILBM_Set*)malloc(sizeof(SDL_ILBM_Set));
+    SDL_ILBM_Set *set = (SDL_ILBM_Set*)SDL_ILBM_malloc(sizeof(SDL_ILBM_Set));
 
     if(set != NULL)
     {
@@ -164,6 +164,6 @@ void SDL_ILBM_freeSet(SDL_ILBM_Set *set)
     if(set != NULL)
     {
         SDL_ILBM_cleanupSet(set);
-        free(set);
+        SDL_ILBM_free(set);
     }
 }
@@ -139,6 +139,8 @@ SDL_Surface *SDL_ILBM_createSurfaceFromSet(const SDL_ILBM_Set *set, const unsign
 
 /**
  * Initializes a preallocated cyclable SDL_ILBM_Image from an image in the set.
+ * The image may refer to data owned by the set, so it must be destroyed before
+ * the set is freed.
  *
  * @param set An SDL_ILBM_Set containing images
  * @param index Index of the image in the set
@@ -155,7 +157,7 @@ IFF_Bool SDL_ILBM_initImageFromSet(const SDL_ILBM_Set *set, const unsigned int i
  * @param index Index of the image in the set
  * @param lowresPixelScaleFactor Specifies the width of a lowres pixel
  * @param format Defines to which format the output must be converted
- * @return An SDL_ILBM_Image or NULL in case of an error. The resulting image must be freed with SDL_ILBM_freeImage()
+ * @return An SDL_ILBM_Image or NULL in case of an error. The resulting image must be freed with SDL_ILBM_freeImage() before the set is freed
  */
 SDL_ILBM_Image *SDL_ILBM_createImageFromSet(const SDL_ILBM_Set *set, const unsigned int index, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format);
 
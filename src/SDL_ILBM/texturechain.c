@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#include "texturechain.h"
+
+amiVideo_Bool SDL_ILBM_initTextureChain(SDL_ILBM_TextureChain *textureChain, SDL_Renderer *renderer, Uint32 format, const SDL_ILBM_Display *display, unsigned int numOfTextures)
+{
+    unsigned int i;
+
+    if(numOfTextures < 1)
+        numOfTextures = 1;
+    else if(numOfTextures > SDL_ILBM_MAX_NUM_OF_CHAINED_TEXTURES)
+        numOfTextures = SDL_ILBM_MAX_NUM_OF_CHAINED_TEXTURES;
+
+    textureChain->texturesLength = 0;
+    textureChain->current = 0;
+    textureChain->format = format;
+    SDL_ILBM_resetLockWaitTimes(textureChain);
+
+    for(i = 0; i < numOfTextures; i++)
+    {
+        SDL_Texture *texture = SDL_ILBM_createTexture(renderer, format, SDL_TEXTUREACCESS_STREAMING, display);
+
+        if(texture == NULL)
+        {
+            SDL_ILBM_destroyTextureChain(textureChain);
+            return FALSE;
+        }
+
+        textureChain->textures[i] = texture;
+        textureChain->texturesLength++;
+    }
+
+    return TRUE;
+}
+
+void SDL_ILBM_destroyTextureChain(SDL_ILBM_TextureChain *textureChain)
+{
+    unsigned int i;
+
+    for(i = 0; i < textureChain->texturesLength; i++)
+        SDL_DestroyTexture(textureChain->textures[i]);
+
+    textureChain->texturesLength = 0;
+}
+
+static int lockTexture(SDL_ILBM_TextureChain *textureChain, SDL_Texture *texture, void **pixels, int *pitch)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    int status = SDL_LockTexture(texture, NULL, pixels, pitch);
+    Uint64 lockWaitTime = SDL_GetPerformanceCounter() - start;
+
+    textureChain->numOfLocks++;
+    textureChain->lockWaitTime += lockWaitTime;
+
+    if(lockWaitTime > textureChain->maxLockWaitTime)
+        textureChain->maxLockWaitTime = lockWaitTime;
+
+    return status;
+}
+
+static unsigned int selectNextTexture(const SDL_ILBM_TextureChain *textureChain)
+{
+    /* Write to the texture that was presented the longest time ago, as the GPU is most likely done reading it */
+    return (textureChain->current + 1) % textureChain->texturesLength;
+}
+
+amiVideo_Bool SDL_ILBM_lockNextTexture(SDL_ILBM_TextureChain *textureChain, void **pixels, int *pitch)
+{
+    return (lockTexture(textureChain, textureChain->textures[selectNextTexture(textureChain)], pixels, pitch) == 0);
+}
+
+void SDL_ILBM_unlockNextTexture(SDL_ILBM_TextureChain *textureChain, const amiVideo_Bool makeCurrent)
+{
+    unsigned int next = selectNextTexture(textureChain);
+
+    SDL_UnlockTexture(textureChain->textures[next]);
+
+    if(makeCurrent)
+        textureChain->current = next;
+}
+
+amiVideo_Bool SDL_ILBM_blitDisplayToTextureChain(SDL_ILBM_TextureChain *textureChain, SDL_ILBM_Display *display)
+{
+    void *pixels;
+    int pitch;
+    amiVideo_Bool status;
+
+    if(!SDL_ILBM_lockNextTexture(textureChain, &pixels, &pitch))
+        return FALSE;
+
+    status = SDL_ILBM_blitDisplayToTexture(display, textureChain->format, pixels, pitch);
+    SDL_ILBM_unlockNextTexture(textureChain, status);
+
+    return status;
+}
+
+SDL_Texture *SDL_ILBM_getCurrentTexture(const SDL_ILBM_TextureChain *textureChain)
+{
+    return textureChain->textures[textureChain->current];
+}
+
+void SDL_ILBM_getLockWaitTimes(const SDL_ILBM_TextureChain *textureChain, double *averageLockWaitTime, double *maxLockWaitTime)
+{
+    double ticksPerMillisecond = SDL_GetPerformanceFrequency() / 1000.0;
+
+    if(textureChain->numOfLocks == 0)
+        *averageLockWaitTime = 0.0;
+    else
+        *averageLockWaitTime = textureChain->lockWaitTime / ticksPerMillisecond / textureChain->numOfLocks;
+
+    *maxLockWaitTime = textureChain->maxLockWaitTime / ticksPerMillisecond;
+}
+
+void SDL_ILBM_resetLockWaitTimes(SDL_ILBM_TextureChain *textureChain)
+{
+    textureChain->numOfLocks = 0;
+    textureChain->lockWaitTime = 0;
+    textureChain->maxLockWaitTime = 0;
+}
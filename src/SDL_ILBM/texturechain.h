@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2012 Sander van der Burg
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ * claim that you wrote the original software. If you use this software in a
+ * product, an acknowledgment in the product documentation would be
+ * appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * Sander van der Burg <svanderburg@gmail.com>
+ */
+
+#ifndef __SDL_ILBM_TEXTURECHAIN_H
+#define __SDL_ILBM_TEXTURECHAIN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SDL_ILBM_TextureChain SDL_ILBM_TextureChain;
+
+#include <SDL.h>
+#include "display.h"
+
+/** Maximum amount of textures in a texture chain */
+#define SDL_ILBM_MAX_NUM_OF_CHAINED_TEXTURES 3
+
+/**
+ * @brief A ring of streaming textures to which the frames of a display are
+ * written in turn, so that a new frame is never written to the texture that
+ * the GPU may still be reading from.
+ */
+struct SDL_ILBM_TextureChain
+{
+    /** Streaming textures having the dimensions of the display */
+    SDL_Texture *textures[SDL_ILBM_MAX_NUM_OF_CHAINED_TEXTURES];
+
+    /** Specifies the amount of textures in the chain */
+    unsigned int texturesLength;
+
+    /** Index of the texture containing the most recent frame */
+    unsigned int current;
+
+    /** Format of the textures */
+    Uint32 format;
+
+    /** Amount of times a texture has been locked */
+    unsigned int numOfLocks;
+
+    /** Total time spent waiting for textures to be locked in performance counter ticks */
+    Uint64 lockWaitTime;
+
+    /** Longest time spent waiting for a texture to be locked in performance counter ticks */
+    Uint64 maxLockWaitTime;
+};
+
+/**
+ * Initializes a preallocated texture chain with streaming textures for a display.
+ *
+ * @param textureChain Preallocated texture chain
+ * @param renderer An SDL_Renderer instance
+ * @param format One of the enumerated SDL texture formats
+ * @param display An SDL_ILBM_Display instance
+ * @param numOfTextures Amount of textures in the chain. Clamped between 1 and SDL_ILBM_MAX_NUM_OF_CHAINED_TEXTURES
+ * @return TRUE if the initialization succeeds, else FALSE
+ */
+amiVideo_Bool SDL_ILBM_initTextureChain(SDL_ILBM_TextureChain *textureChain, SDL_Renderer *renderer, Uint32 format, const SDL_ILBM_Display *display, unsigned int numOfTextures);
+
+/**
+ * Destroys the textures of the provided texture chain.
+ *
+ * @param textureChain An SDL_ILBM_TextureChain instance
+ */
+void SDL_ILBM_destroyTextureChain(SDL_ILBM_TextureChain *textureChain);
+
+/**
+ * Locks the next texture of the chain, so that a frame can be written to it.
+ * The time it takes to lock the texture is measured.
+ *
+ * @param textureChain An SDL_ILBM_TextureChain instance
+ * @param pixels Is set to the pixels of the texture
+ * @param pitch Is set to the size of each scanline in bytes
+ * @return TRUE in case success, else FALSE
+ */
+amiVideo_Bool SDL_ILBM_lockNextTexture(SDL_ILBM_TextureChain *textureChain, void **pixels, int *pitch);
+
+/**
+ * Unlocks the next texture of the chain, which was locked with
+ * SDL_ILBM_lockNextTexture().
+ *
+ * @param textureChain An SDL_ILBM_TextureChain instance
+ * @param makeCurrent TRUE to make the texture the current texture, because a frame has been written to it, else FALSE
+ */
+void SDL_ILBM_unlockNextTexture(SDL_ILBM_TextureChain *textureChain, const amiVideo_Bool makeCurrent);
+
+/**
+ * Blits the image of a display to the next texture of the chain, which then
+ * becomes the current texture. The time it takes to lock the texture is
+ * measured.
+ *
+ * @param textureChain An SDL_ILBM_TextureChain instance
+ * @param display An SDL_ILBM_Display instance
+ * @return TRUE in case success, else FALSE
+ */
+amiVideo_Bool SDL_ILBM_blitDisplayToTextureChain(SDL_ILBM_TextureChain *textureChain, SDL_ILBM_Display *display);
+
+/**
+ * Returns the texture containing the most recent frame, that should be rendered
+ * to the window.
+ *
+ * @param textureChain An SDL_ILBM_TextureChain instance
+ * @return The current texture of the chain
+ */
+SDL_Texture *SDL_ILBM_getCurrentTexture(const SDL_ILBM_TextureChain *textureChain);
+
+/**
+ * Retrieves the times spent waiting for textures to be locked.
+ *
+ * @param textureChain An SDL_ILBM_TextureChain instance
+ * @param averageLockWaitTime Is set to the average time in milliseconds
+ * @param maxLockWaitTime Is set to the longest time in milliseconds
+ */
+void SDL_ILBM_getLockWaitTimes(const SDL_ILBM_TextureChain *textureChain, double *averageLockWaitTime, double *maxLockWaitTime);
+
+/**
+ * Resets the measured times spent waiting for textures to be locked.
+ *
+ * @param textureChain An SDL_ILBM_TextureChain instance
+ */
+void SDL_ILBM_resetLockWaitTimes(SDL_ILBM_TextureChain *textureChain);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -43,8 +43,8 @@ static void printUsage(const char *command)
     puts(
     "Options:\n"
 #ifdef _MSC_VER
-    "  /f FORMAT  Specify the output format. Possible values are: auto, chunky or rgb.\n"
-    "             Defaults to: auto\n"
+    "  /f FORMAT  Specify the output format. Possible values are: auto, chunky,\n"
+    "             rgb or cheapest. Defaults to: auto\n"
     "  /C         Turn cycle mode on by default\n"
     "  /s         Do not clip the picture inside the page but stretch it to its full\n"
     "             size"
@@ -52,6 +52,12 @@ static void printUsage(const char *command)
     puts(
     "  /c VALUE   Specifies the scale factor of a lowres pixel to properly correct\n"
     "             its aspect ratio. Possible values are: auto, none, 2, 4\n"
+    "  /r         Let the renderer correct the aspect ratio instead of scaling the\n"
+    "             picture itself\n"
+    "  /b NUM     Amount of textures to which frames are written in turn (1-3).\n"
+    "             Defaults to: 2\n"
+    "  /w         Reports the time spent waiting for textures to be locked\n"
+    "  /t         Renders the cycled frames of RGB pictures on a separate thread\n"
     "  /F         Views the picture in full screen\n"
     );
     "  /n NUM     Displays the n-th picture inside the IFF scrap file. Defaults to: 0\n"
@@ -59,7 +65,8 @@ static void printUsage(const char *command)
     "  /v         Shows the version of the command to the user\n"
 #else
     "  -f, --format=FORMAT         Specify the output format. Possible values are:\n"
-    "                              auto, chunky or rgb. Defaults to: auto\n"
+    "                              auto, chunky, rgb or cheapest. Defaults to:\n"
+    "                              auto\n"
     "  -C, --cycle                 Turn cycle mode on by default\n"
     "  -s, --stretch               Do not clip the picture inside the page but\n"
     "                              stretch it to its full size"
@@ -68,6 +75,14 @@ static void printUsage(const char *command)
     "  -c, --correct-aspect=VALUE  Specifies the scale factor of a lowres pixel to\n"
     "                              properly correct its aspect ratio. Possible values\n"
     "                              are: auto, none, 2, 4\n"
+    "  -r, --renderer-correction   Let the renderer correct the aspect ratio instead\n"
+    "                              of scaling the picture itself\n"
+    "  -b, --buffers=NUM           Amount of textures to which frames are written in\n"
+    "                              turn (1-3). Defaults to: 2\n"
+    "  -w, --report-lock-wait      Reports the time spent waiting for textures to be\n"
+    "                              locked\n"
+    "  -t, --threaded-cycling      Renders the cycled frames of RGB pictures on a\n"
+    "                              separate thread\n"
     "  -F, --fullscreen            Views the picture in full screen"
     );
     puts(
@@ -95,6 +110,8 @@ static SDL_ILBM_Format determineFormat(const char *format)
         return SDL_ILBM_CHUNKY_FORMAT;
     else if (strcmp(format, "rgb") == 0)
         return SDL_ILBM_RGB_FORMAT;
+    else if (strcmp(format, "cheapest") == 0)
+        return SDL_ILBM_CHEAPEST_FORMAT;
     else
         return SDL_ILBM_AUTO_FORMAT;
 }
@@ -118,6 +135,7 @@ int main(int argc, char *argv[])
     SDL_ILBM_Format format = SDL_ILBM_AUTO_FORMAT;
     unsigned int lowresPixelScaleFactor = 0;
     unsigned int number = 0;
+    unsigned int numOfTextures = 2;
     unsigned int options = 0;
     char *filename;
 
@@ -128,6 +146,7 @@ int main(int argc, char *argv[])
     int formatFollows = FALSE;
     int lowresPixelScaleFactorFollows = FALSE;
     int numberFollows = FALSE;
+    int numOfTexturesFollows = FALSE;
 
     for (i = 1; i < argc; i++)
     {
@@ -149,6 +168,12 @@ int main(int argc, char *argv[])
             number = atoi(argv[i]);
             optind++;
         }
+        else if (numOfTexturesFollows)
+        {
+            numOfTexturesFollows = FALSE;
+            numOfTextures = atoi(argv[i]);
+            optind++;
+        }
         else if (strcmp(argv[i], "/f") == 0)
         {
             formatFollows = TRUE;
@@ -169,6 +194,26 @@ int main(int argc, char *argv[])
             lowresPixelScaleFactorFollows = TRUE;
             optind++;
         }
+        else if (strcmp(argv[i], "/r") == 0)
+        {
+            options |= SDL_ILBM_OPTION_RENDERER_CORRECTION;
+            optind++;
+        }
+        else if (strcmp(argv[i], "/b") == 0)
+        {
+            numOfTexturesFollows = TRUE;
+            optind++;
+        }
+        else if (strcmp(argv[i], "/w") == 0)
+        {
+            options |= SDL_ILBM_OPTION_REPORT_LOCK_WAIT;
+            optind++;
+        }
+        else if (strcmp(argv[i], "/t") == 0)
+        {
+            options |= SDL_ILBM_OPTION_THREADED_CYCLING;
+            optind++;
+        }
         else if (strcmp(argv[i], "/F") == 0)
         {
             options |= SDL_ILBM_OPTION_FULLSCREEN;
@@ -198,6 +243,10 @@ int main(int argc, char *argv[])
         {"cycle", no_argument, 0, 'C'},
         {"stretch", no_argument, 0, 's'},
         {"correct-aspect", required_argument, 0, 'c'},
+        {"renderer-correction", no_argument, 0, 'r'},
+        {"buffers", required_argument, 0, 'b'},
+        {"report-lock-wait", no_argument, 0, 'w'},
+        {"threaded-cycling", no_argument, 0, 't'},
         {"fullscreen", no_argument, 0, 'F'},
         {"number", required_argument, 0, 'n'},
         {"help", no_argument, 0, 'h'},
@@ -206,7 +255,7 @@ int main(int argc, char *argv[])
     };
 
     /* Parse command-line options */
-    while((c = getopt_long(argc, argv, "f:Csc:Fn:hv", long_options, &option_index)) != -1)
+    while((c = getopt_long(argc, argv, "f:Csc:rb:wtFn:hv", long_options, &option_index)) != -1)
     {
         switch(c)
         {
@@ -222,6 +271,18 @@ int main(int argc, char *argv[])
             case 'c':
                 lowresPixelScaleFactor = determineLowresPixelScaleFactor(optarg);
                 break;
+            case 'r':
+                options |= SDL_ILBM_OPTION_RENDERER_CORRECTION;
+                break;
+            case 'b':
+                numOfTextures = atoi(optarg);
+                break;
+            case 'w':
+                options |= SDL_ILBM_OPTION_REPORT_LOCK_WAIT;
+                break;
+            case 't':
+                options |= SDL_ILBM_OPTION_THREADED_CYCLING;
+                break;
             case 'F':
                 options |= SDL_ILBM_OPTION_FULLSCREEN;
                 break;
@@ -246,5 +307,5 @@ int main(int argc, char *argv[])
     else
         filename = argv[optind];
 
-    return SDL_ILBM_viewILBMImages(filename, format, number, lowresPixelScaleFactor, options);
+    return SDL_ILBM_viewILBMImages(filename, format, number, lowresPixelScaleFactor, numOfTextures, options);
 }
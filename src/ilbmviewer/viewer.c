@@ -40,12 +40,53 @@ typedef enum
 }
 SDL_ILBM_Status;
 
-static SDL_ILBM_Status viewILBMImage(SDL_ILBM_Set *set, const unsigned int number, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format, const unsigned int options)
+static void destroyViewerDisplay(SDL_ILBM_ViewerDisplay *viewerDisplay, const unsigned int options)
+{
+    if(options & SDL_ILBM_OPTION_REPORT_LOCK_WAIT)
+        SDL_ILBM_reportLockWaitTimes(viewerDisplay);
+
+    SDL_ILBM_destroyViewerDisplay(viewerDisplay);
+}
+
+/* Lets the cycle renderer, if any, cycle the colors of the image on a worker thread */
+
+static void startCycling(SDL_ILBM_ViewerDisplay *viewerDisplay, SDL_ILBM_CycleRenderer *cycleRenderer)
+{
+    if(cycleRenderer != NULL && SDL_ILBM_startCycleRenderer(cycleRenderer))
+        viewerDisplay->cycleRenderer = cycleRenderer;
+}
+
+/* Takes the image back from the worker thread, so that the main thread can use it again */
+
+static void stopCycling(SDL_ILBM_ViewerDisplay *viewerDisplay, SDL_ILBM_CycleRenderer *cycleRenderer)
+{
+    if(cycleRenderer != NULL)
+        SDL_ILBM_stopCycleRenderer(cycleRenderer);
+
+    viewerDisplay->cycleRenderer = NULL;
+}
+
+static SDL_ILBM_Status viewILBMImage(SDL_ILBM_Set *set, const unsigned int number, const unsigned int lowresPixelScaleFactor, const SDL_ILBM_Format format, const unsigned int numOfTextures, const unsigned int options)
 {
     int cycle, fullscreen, stretch, status = SDL_ILBM_STATUS_NONE;
+    unsigned int imageLowresPixelScaleFactor, displayLowresPixelScaleFactor;
     SDL_ILBM_ViewerDisplay viewerDisplay;
+    SDL_ILBM_Image *image;
+    SDL_ILBM_CycleRenderer *cycleRenderer = NULL;
+
+    /* Determine whether the image or the renderer corrects the aspect ratio */
+    if(options & SDL_ILBM_OPTION_RENDERER_CORRECTION)
+    {
+        imageLowresPixelScaleFactor = 1;
+        displayLowresPixelScaleFactor = lowresPixelScaleFactor;
+    }
+    else
+    {
+        imageLowresPixelScaleFactor = lowresPixelScaleFactor;
+        displayLowresPixelScaleFactor = 1;
+    }
 
-    SDL_ILBM_Image *image = SDL_ILBM_createImageFromSet(set, number, lowresPixelScaleFactor, format);
+    image = SDL_ILBM_createImageFromSet(set, number, imageLowresPixelScaleFactor, format);
 
     if(image == NULL)
     {
@@ -71,12 +112,18 @@ static SDL_ILBM_Status viewILBMImage(SDL_ILBM_Set *set, const unsigned int numbe
     else
         cycle = FALSE;
 
+    /* Render the frames of RGB images on a worker thread, if requested. Chunky images only update their palettes */
+    if(options & SDL_ILBM_OPTION_THREADED_CYCLING)
+        cycleRenderer = SDL_ILBM_createCycleRenderer(image);
+
     /* Initialize everything window related */
-    if(!SDL_ILBM_initViewerDisplay(&viewerDisplay, image, stretch, fullscreen))
+    if(!SDL_ILBM_initViewerDisplay(&viewerDisplay, image, stretch, fullscreen, displayLowresPixelScaleFactor, numOfTextures))
     {
         fprintf(stderr, "Cannot init viewer display!\n");
         status = SDL_ILBM_STATUS_ERROR;
     }
+    else if(cycle)
+        startCycling(&viewerDisplay, cycleRenderer);
 
     /* Main loop taking care of user events */
     while(status == SDL_ILBM_STATUS_NONE)
@@ -91,21 +138,27 @@ static SDL_ILBM_Status viewILBMImage(SDL_ILBM_Set *set, const unsigned int numbe
                     switch(event.key.keysym.sym)
                     {
                         case SDLK_f:
-                            SDL_ILBM_destroyViewerDisplay(&viewerDisplay);
+                            stopCycling(&viewerDisplay, cycleRenderer);
+                            destroyViewerDisplay(&viewerDisplay, options);
 
                             fullscreen = !fullscreen;
 
-                            if(!SDL_ILBM_initViewerDisplay(&viewerDisplay, image, stretch, fullscreen))
+                            if(!SDL_ILBM_initViewerDisplay(&viewerDisplay, image, stretch, fullscreen, displayLowresPixelScaleFactor, numOfTextures))
                                 status = SDL_ILBM_STATUS_ERROR;
+                            else if(cycle)
+                                startCycling(&viewerDisplay, cycleRenderer);
                             break;
 
                         case SDLK_s:
-                            SDL_ILBM_destroyViewerDisplay(&viewerDisplay);
+                            stopCycling(&viewerDisplay, cycleRenderer);
+                            destroyViewerDisplay(&viewerDisplay, options);
 
                             stretch = !stretch;
 
-                            if(!SDL_ILBM_initViewerDisplay(&viewerDisplay, image, stretch, fullscreen))
+                            if(!SDL_ILBM_initViewerDisplay(&viewerDisplay, image, stretch, fullscreen, displayLowresPixelScaleFactor, numOfTextures))
                                 status = SDL_ILBM_STATUS_ERROR;
+                            else if(cycle)
+                                startCycling(&viewerDisplay, cycleRenderer);
                             break;
 
                         case SDLK_ESCAPE:
@@ -126,9 +179,12 @@ static SDL_ILBM_Status viewILBMImage(SDL_ILBM_Set *set, const unsigned int numbe
                         case SDLK_TAB:
                             cycle = !cycle;
 
-                            if(!cycle)
+                            if(cycle)
+                                startCycling(&viewerDisplay, cycleRenderer);
+                            else
                             {
                                 /* If we stop cycling, we reset the colors back to normal */
+                                stopCycling(&viewerDisplay, cycleRenderer);
                                 SDL_ILBM_resetColors(image);
 
                                 if(!SDL_ILBM_renderTexture(&viewerDisplay))
@@ -167,25 +223,46 @@ static SDL_ILBM_Status viewILBMImage(SDL_ILBM_Set *set, const unsigned int numbe
         /* If cycle mode is enabled, do the work that is needed to switch the colors */
         if(cycle)
         {
-            SDL_ILBM_cycleColors(image);
+            if(viewerDisplay.cycleRenderer == NULL)
+            {
+                SDL_ILBM_cycleColors(image);
 
-            if(!SDL_ILBM_renderTexture(&viewerDisplay))
-                status = SDL_ILBM_STATUS_ERROR;
+                if(!SDL_ILBM_renderTexture(&viewerDisplay))
+                    status = SDL_ILBM_STATUS_ERROR;
+            }
+            else if(SDL_ILBM_takeCycledFrame(viewerDisplay.cycleRenderer))
+            {
+                /* The worker thread has rendered a new frame, which only needs to be uploaded */
+                if(!SDL_ILBM_renderTexture(&viewerDisplay))
+                    status = SDL_ILBM_STATUS_ERROR;
+            }
+            else if(!SDL_ILBM_copyTexture(&viewerDisplay))
+                status = SDL_ILBM_STATUS_ERROR; /* The back buffer is undefined after presenting => copy the texture of the current frame again */
         }
 
         /* Flip screen buffers, so that changes become visible */
         SDL_RenderPresent(viewerDisplay.renderer);
+
+        /* Sleep until the worker thread is expected to hand over the next frame, unless an event arrives earlier */
+        if(cycle && viewerDisplay.cycleRenderer != NULL)
+        {
+            Uint32 delay = SDL_ILBM_computeCycledFrameDelay(viewerDisplay.cycleRenderer);
+
+            if(delay > 0)
+                SDL_WaitEventTimeout(NULL, delay);
+        }
     }
 
     /* Cleanup */
-    SDL_ILBM_destroyViewerDisplay(&viewerDisplay);
+    SDL_ILBM_freeCycleRenderer(cycleRenderer);
+    destroyViewerDisplay(&viewerDisplay, options);
     SDL_ILBM_freeImage(image);
 
     /* Return exit status */
     return status;
 }
 
-int SDL_ILBM_viewILBMImages(const char *filename, const SDL_ILBM_Format format, unsigned int number, const unsigned int lowresPixelScaleFactor, const unsigned int options)
+int SDL_ILBM_viewILBMImages(const char *filename, const SDL_ILBM_Format format, unsigned int number, const unsigned int lowresPixelScaleFactor, const unsigned int numOfTextures, const unsigned int options)
 {
     SDL_ILBM_Status status = SDL_ILBM_STATUS_NONE;
     SDL_ILBM_Set *set = SDL_ILBM_createSet(filename);
@@ -214,7 +291,7 @@ int SDL_ILBM_viewILBMImages(const char *filename, const SDL_ILBM_Format format,
     /* Main loop */
     while(status != SDL_ILBM_STATUS_QUIT && status != SDL_ILBM_STATUS_ERROR)
     {
-        status = viewILBMImage(set, number, lowresPixelScaleFactor, format, options);
+        status = viewILBMImage(set, number, lowresPixelScaleFactor, format, numOfTextures, options);
 
         switch(status)
         {
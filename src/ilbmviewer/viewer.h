@@ -29,7 +29,10 @@
 #define SDL_ILBM_OPTION_CYCLE 0x1
 #define SDL_ILBM_OPTION_STRETCH 0x2
 #define SDL_ILBM_OPTION_FULLSCREEN 0x4
+#define SDL_ILBM_OPTION_RENDERER_CORRECTION 0x8
+#define SDL_ILBM_OPTION_REPORT_LOCK_WAIT 0x10
+#define SDL_ILBM_OPTION_THREADED_CYCLING 0x20
 
-int SDL_ILBM_viewILBMImages(const char *filename, const SDL_ILBM_Format format, unsigned int number, const unsigned int lowresPixelScaleFactor, const unsigned int options);
+int SDL_ILBM_viewILBMImages(const char *filename, const SDL_ILBM_Format format, unsigned int number, const unsigned int lowresPixelScaleFactor, const unsigned int numOfTextures, const unsigned int options);
 
 #endif
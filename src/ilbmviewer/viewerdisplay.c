@@ -24,12 +24,12 @@
 
 #include "viewerdisplay.h"
 
-int SDL_ILBM_initViewerDisplay(SDL_ILBM_ViewerDisplay *viewerDisplay, SDL_ILBM_Image *image, const int stretch, const int fullscreen)
+int SDL_ILBM_initViewerDisplay(SDL_ILBM_ViewerDisplay *viewerDisplay, SDL_ILBM_Image *image, const int stretch, const int fullscreen, const unsigned int lowresPixelScaleFactor, const unsigned int numOfTextures)
 {
     Uint32 fullScreenFlag;
 
     /* Set up a display from the image and the display settings */
-    SDL_ILBM_initDisplay(&viewerDisplay->display, image, stretch);
+    SDL_ILBM_initScaledDisplay(&viewerDisplay->display, image, stretch, lowresPixelScaleFactor);
 
     /* Configure the fullscreen flag if the fullscreen setting has been provided */
     if(fullscreen)
@@ -41,6 +41,13 @@ int SDL_ILBM_initViewerDisplay(SDL_ILBM_ViewerDisplay *viewerDisplay, SDL_ILBM_I
     viewerDisplay->offsetX = 0;
     viewerDisplay->offsetY = 0;
 
+    /* Frames are taken from the image until a cycle renderer is attached */
+    viewerDisplay->cycleRenderer = NULL;
+
+    /* No textures have been created yet */
+    viewerDisplay->textureChain.texturesLength = 0;
+    SDL_ILBM_resetLockWaitTimes(&viewerDisplay->textureChain);
+
     /* Create a SDL window */
     viewerDisplay->window = SDL_ILBM_createWindow("SDL ILBM Viewer", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, &viewerDisplay->display, fullScreenFlag);
 
@@ -60,17 +67,20 @@ int SDL_ILBM_initViewerDisplay(SDL_ILBM_ViewerDisplay *viewerDisplay, SDL_ILBM_I
         return FALSE;
     }
 
-    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
+    /* Keep the pixels sharp if the renderer corrects the aspect ratio, as it stretches them by whole factors */
+    if(viewerDisplay->display.scaleX > 1 || viewerDisplay->display.scaleY > 1)
+        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+    else
+        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
+
     SDL_ILBM_renderSetLogicalSize(viewerDisplay->renderer, &viewerDisplay->display);
 
     /* Clear the renderer with a black color */
     SDL_SetRenderDrawColor(viewerDisplay->renderer, 0, 0, 0, 255);
     SDL_RenderClear(viewerDisplay->renderer);
 
-    /* Create a texture */
-    viewerDisplay->texture = SDL_ILBM_createTexture(viewerDisplay->renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, &viewerDisplay->display);
-
-    if(viewerDisplay->texture == NULL)
+    /* Create textures in a format that the renderer can upload without converting it, so that each frame is written to a texture the GPU is not reading from */
+    if(!SDL_ILBM_initTextureChain(&viewerDisplay->textureChain, viewerDisplay->renderer, SDL_ILBM_selectTextureFormat(viewerDisplay->renderer, &viewerDisplay->display), &viewerDisplay->display, numOfTextures))
     {
         fprintf(stderr, "Cannot create texture!\n");
         SDL_ILBM_destroyViewerDisplay(viewerDisplay);
@@ -86,33 +96,49 @@ void SDL_ILBM_destroyViewerDisplay(SDL_ILBM_ViewerDisplay *viewerDisplay)
     if(viewerDisplay != NULL)
     {
         SDL_ILBM_destroyDisplay(&viewerDisplay->display);
-        SDL_DestroyTexture(viewerDisplay->texture);
+        SDL_ILBM_destroyTextureChain(&viewerDisplay->textureChain);
         SDL_DestroyRenderer(viewerDisplay->renderer);
         SDL_DestroyWindow(viewerDisplay->window);
     }
 }
 
-int SDL_ILBM_renderTexture(SDL_ILBM_ViewerDisplay *viewerDisplay)
+static amiVideo_Bool blitCycledFrameToTextureChain(SDL_ILBM_ViewerDisplay *viewerDisplay)
 {
     void *pixels;
     int pitch;
+    amiVideo_Bool status;
 
-    if(SDL_LockTexture(viewerDisplay->texture, NULL, &pixels, &pitch) < 0)
-    {
-        fprintf(stderr, "Cannot lock texture: %s\n", SDL_GetError());
+    if(!SDL_ILBM_lockNextTexture(&viewerDisplay->textureChain, &pixels, &pitch))
         return FALSE;
-    }
 
-    if(!SDL_ILBM_blitDisplayToTexture(&viewerDisplay->display, SDL_PIXELFORMAT_RGBA8888, pixels, pitch))
+    status = SDL_ILBM_blitCycledFrameToTexture(viewerDisplay->cycleRenderer, viewerDisplay->textureChain.format, pixels, pitch);
+    SDL_ILBM_unlockNextTexture(&viewerDisplay->textureChain, status);
+
+    return status;
+}
+
+int SDL_ILBM_renderTexture(SDL_ILBM_ViewerDisplay *viewerDisplay)
+{
+    amiVideo_Bool status;
+
+    /* While a worker thread renders the frames, the image belongs to it */
+    if(viewerDisplay->cycleRenderer == NULL)
+        status = SDL_ILBM_blitDisplayToTextureChain(&viewerDisplay->textureChain, &viewerDisplay->display);
+    else
+        status = blitCycledFrameToTextureChain(viewerDisplay);
+
+    if(!status)
     {
         fprintf(stderr, "Cannot blit display to texture: %s\n", SDL_GetError());
-        SDL_UnlockTexture(viewerDisplay->texture);
         return FALSE;
     }
 
-    SDL_UnlockTexture(viewerDisplay->texture);
+    return SDL_ILBM_copyTexture(viewerDisplay);
+}
 
-    if(SDL_ILBM_renderCopy(viewerDisplay->renderer, viewerDisplay->texture, viewerDisplay->offsetX, viewerDisplay->offsetY, &viewerDisplay->display) == 0)
+int SDL_ILBM_copyTexture(SDL_ILBM_ViewerDisplay *viewerDisplay)
+{
+    if(SDL_ILBM_renderCopy(viewerDisplay->renderer, SDL_ILBM_getCurrentTexture(&viewerDisplay->textureChain), viewerDisplay->offsetX, viewerDisplay->offsetY, &viewerDisplay->display) == 0)
         return TRUE;
     else
     {
@@ -121,6 +147,14 @@ int SDL_ILBM_renderTexture(SDL_ILBM_ViewerDisplay *viewerDisplay)
     }
 }
 
+void SDL_ILBM_reportLockWaitTimes(const SDL_ILBM_ViewerDisplay *viewerDisplay)
+{
+    double averageLockWaitTime, maxLockWaitTime;
+
+    SDL_ILBM_getLockWaitTimes(&viewerDisplay->textureChain, &averageLockWaitTime, &maxLockWaitTime);
+    fprintf(stderr, "Texture lock wait times with %u textures: %u locks, average: %.3f ms, maximum: %.3f ms\n", viewerDisplay->textureChain.texturesLength, viewerDisplay->textureChain.numOfLocks, averageLockWaitTime, maxLockWaitTime);
+}
+
 int SDL_ILBM_scrollWindowLeft(SDL_ILBM_ViewerDisplay *viewerDisplay)
 {
     if(viewerDisplay->offsetX > 0)
@@ -131,7 +165,7 @@ int SDL_ILBM_scrollWindowLeft(SDL_ILBM_ViewerDisplay *viewerDisplay)
 
 int SDL_ILBM_scrollWindowRight(SDL_ILBM_ViewerDisplay *viewerDisplay)
 {
-    if(viewerDisplay->offsetX < viewerDisplay->display.blitSurface->w - viewerDisplay->display.width)
+    if(viewerDisplay->offsetX < viewerDisplay->display.blitSurface->w - viewerDisplay->display.width / viewerDisplay->display.scaleX)
         viewerDisplay->offsetX++;
 
     return SDL_ILBM_renderTexture(viewerDisplay);
@@ -147,7 +181,7 @@ int SDL_ILBM_scrollWindowUp(SDL_ILBM_ViewerDisplay *viewerDisplay)
 
 int SDL_ILBM_scrollWindowDown(SDL_ILBM_ViewerDisplay *viewerDisplay)
 {
-    if(viewerDisplay->offsetY < viewerDisplay->display.blitSurface->h - viewerDisplay->display.height)
+    if(viewerDisplay->offsetY < viewerDisplay->display.blitSurface->h - viewerDisplay->display.height / viewerDisplay->display.scaleY)
         viewerDisplay->offsetY++;
 
     return SDL_ILBM_renderTexture(viewerDisplay);
@@ -26,6 +26,8 @@
 #define __SDL_ILBM_VIEWERDISPLAY_H
 #include <SDL.h>
 #include "display.h"
+#include "texturechain.h"
+#include "cyclerenderer.h"
 #include "image.h"
 
 typedef struct
@@ -33,17 +35,22 @@ typedef struct
     SDL_ILBM_Display display;
     SDL_Window *window;
     SDL_Renderer *renderer;
-    SDL_Texture *texture;
+    SDL_ILBM_TextureChain textureChain;
+    SDL_ILBM_CycleRenderer *cycleRenderer;
     int offsetX, offsetY;
 }
 SDL_ILBM_ViewerDisplay;
 
-int SDL_ILBM_initViewerDisplay(SDL_ILBM_ViewerDisplay *viewerDisplay, SDL_ILBM_Image *image, const int stretch, const int fullscreen);
+int SDL_ILBM_initViewerDisplay(SDL_ILBM_ViewerDisplay *viewerDisplay, SDL_ILBM_Image *image, const int stretch, const int fullscreen, const unsigned int lowresPixelScaleFactor, const unsigned int numOfTextures);
 
 void SDL_ILBM_destroyViewerDisplay(SDL_ILBM_ViewerDisplay *viewerDisplay);
 
 int SDL_ILBM_renderTexture(SDL_ILBM_ViewerDisplay *viewerDisplay);
 
+int SDL_ILBM_copyTexture(SDL_ILBM_ViewerDisplay *viewerDisplay);
+
+void SDL_ILBM_reportLockWaitTimes(const SDL_ILBM_ViewerDisplay *viewerDisplay);
+
 int SDL_ILBM_scrollWindowLeft(SDL_ILBM_ViewerDisplay *viewerDisplay);
 
 int SDL_ILBM_scrollWindowRight(SDL_ILBM_ViewerDisplay *viewerDisplay);